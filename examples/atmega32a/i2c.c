@@ -8,11 +8,13 @@
 /******************************************************************************
  * Definitions
  ******************************************************************************/
-#define SYSTEM_CLK (12000000ul) /**< TODO: the system clock */
+#define SYSTEM_CLK I2C_CPU_CLK /**< the system clock, see i2c_cfg.h */
 
 #define I2C_WRITE 0 /**< A mask to OR with the address for write operation */
 #define I2C_READ 1 /**< A mask to OR with the address for read operation */
 
+#define I2C_GENERAL_CALL 0x00 /**< The general call (broadcast) address */
+
 //Status register codes:
 
 //master transmitter
@@ -20,9 +22,11 @@
 #define I2C_SR_MT_RSTA 0x10 /**< the restart bit is sent successfully */
 #define I2C_SR_MT_AACK 0x18 /**< ACK is received after sending the address */
 #define I2C_SR_MT_ACK 0x28 /**< ACK is received after sending a byte */
+#define I2C_SR_MT_NACK 0x30 /**< NACK is received after sending a byte */
 //master receiver
 #define I2C_SR_MR_STA 0x08 /**< the start bit is sent successfully */
 #define I2C_SR_MR_AACK 0x40 /**< ACK is received after sending the address */
+#define I2C_SR_MR_ACK 0x50 /**< ACK is sent after receiving a byte */
 #define I2C_SR_MR_NACK 0x58 /**< NACK is sent after receiving a byte */
 
 
@@ -39,6 +43,53 @@
  */
 #define I2C_FREQ_TO_REG(__FREQUENCY__, __PRESCALER__) \
 (uint32_t)(((SYSTEM_CLK / __FREQUENCY__) - 16) / (2 * __PRESCALER__));
+
+/**
+ * @brief The interrupt enable bit to OR with the control register commands.
+ * The I2C interrupt wakes the CPU up in I2C_WAIT_SLEEP and advances the
+ * asynchronous transfers if I2C_ASYNC_IRQ is 1.
+ */
+#define I2C_CMD_IE \
+((I2C_WAIT_STRATEGY == I2C_WAIT_SLEEP || I2C_ASYNC_IRQ == 1) ? \
+(1 << TWIE) : 0)
+
+#ifdef I2C_SIM
+/* The host model has no interrupts, it sleeps in I2C_SIM_SLEEP */
+#define I2C_DISABLE_IRQ()
+#define I2C_ENABLE_IRQ()
+#define I2C_ENABLE_IRQ_AND_SLEEP()
+#else
+#define I2C_DISABLE_IRQ() __asm__ __volatile__ ("cli" ::: "memory")
+#define I2C_ENABLE_IRQ() __asm__ __volatile__ ("sei" ::: "memory")
+
+/**
+ * @brief Enable the interrupts and sleep. The instruction following sei is
+ * executed before any pending interrupt, so a wake-up can't be missed.
+ */
+#define I2C_ENABLE_IRQ_AND_SLEEP() \
+__asm__ __volatile__ ("sei" "\n\t" "sleep" ::: "memory")
+#endif
+
+/**
+ * @brief The polls of I2c_EngineBurst which last as long as I2C_TIMEOUT
+ * polls of the wait loop.
+ */
+#define I2C_FAST_TIMEOUT \
+((uint32_t)I2C_TIMEOUT * I2C_POLL_CYCLES / I2C_FAST_POLL_CYCLES > 0xFFFF ? \
+0xFFFF : (uint16_t)((uint32_t)I2C_TIMEOUT * I2C_POLL_CYCLES / \
+I2C_FAST_POLL_CYCLES))
+
+/**
+ * @brief Give a step to the recorder set by I2c_SetRecorder. The calls are
+ * compiled out if I2C_RECORDER is 0.
+ */
+#define I2C_RECORD(__I2C__, __OP__, __STATUS__, __DATA__) \
+do { \
+  if(I2C_RECORDER == 1 && gRecorder != 0x0) \
+    { \
+      gRecorder((__I2C__), (__OP__), (__STATUS__), (__DATA__)); \
+    } \
+} while(0)
 /******************************************************************************
  * Includes
  ******************************************************************************/
@@ -48,46 +99,163 @@
 /******************************************************************************
  * typedefs 
  ******************************************************************************/
-typedef enum {
-  I2C_FLAG_STA,    /**< Start bit is sent successfully */
-  I2C_FLAG_ACK,   /**< Acknowledge is received/sent */
-  I2C_FLAG_NACK,   /**< Not-Acknowledge is received/sent */
-}I2cFlag_t;
+typedef struct
+{
+  uint8_t Bitrate; /**< the value of the bitrate register */
+  uint8_t Prescaler; /**< the value of the prescaler bits of the status register */
+}I2cScl_t;
+
+/**
+ * @brief What an op expects from the hardware.
+ */
+typedef struct
+{
+  uint8_t Status; /**< the status code of a successful step */
+  uint8_t AltStatus; /**< another accepted status code */
+  uint8_t Error; /**< the result of the program if the step fails */
+  uint8_t HasCount; /**< 1 if the op is followed by a count byte */
+}I2cOpInfo_t;
+
+/**
+ * @brief The state of the program running on an I2C peripheral.
+ */
+typedef struct
+{
+  const I2cTransfer_t* Transfer; /**< the running program and its operands */
+  const uint8_t* Pc; /**< the next op of the program */
+  const uint8_t* Tx; /**< the next byte to send */
+  uint8_t* Rx; /**< where to save the next received byte */
+  uint8_t Op; /**< the current op */
+  uint8_t Count; /**< the remaining steps of the current op */
+  uint8_t Extra; /**< the bytes received after the block of I2C_OP_RX_BLOCK */
+  uint8_t Nack; /**< 1 if a byte received with NACK ends the current op */
+  uint8_t Error; /**< the result of the program once that byte is received,
+                   0 if the program goes on */
+  uint8_t Status; /**< the result of the program, I2C_PENDING until it ends */
+  uint8_t Owned; /**< 1 from a successful start bit until a stop bit */
+  uint8_t Async; /**< 1 while an asynchronous transfer runs */
+  uint16_t Timeout; /**< the polls without progress of an asynchronous
+                      transfer */
+  volatile uint8_t Busy; /**< 1 while a transfer uses the peripheral */
+}I2cEngine_t;
 /******************************************************************************
  * module variables definitions
  ******************************************************************************/
 static volatile uint8_t* const gControlReg[I2C_MAX] =
 {
-  TWCR
+  TWCR,
+#ifdef I2C_SIM
+  TWCR_1,
+#endif
 };
 
 static volatile uint8_t* const gBitrateReg[I2C_MAX] =
 {
-  TWBR
+  TWBR,
+#ifdef I2C_SIM
+  TWBR_1,
+#endif
 };
 
 static volatile uint8_t* const gStatusReg[I2C_MAX] =
 {
-  TWSR
+  TWSR,
+#ifdef I2C_SIM
+  TWSR_1,
+#endif
 };
 
 static volatile uint8_t* const gDataReg[I2C_MAX] =
 {
-  TWDR
+  TWDR,
+#ifdef I2C_SIM
+  TWDR_1,
+#endif
+};
+
+/**
+ * The SCL register values of each I2C peripheral. They're used for the
+ * devices which are not listed in the device configuration table.
+ */
+static I2cScl_t gBusScl[I2C_MAX];
+
+/**
+ * The SCL register values of each device in the device configuration table.
+ * They're computed once in I2c_Init so that switching the speed between
+ * transactions is only a couple of register writes.
+ */
+static I2cScl_t gDeviceScl[I2C_DEVICE_MAX];
+
+/**
+ * The SCL register values currently programmed in each I2C peripheral.
+ */
+static I2cScl_t gActiveScl[I2C_MAX];
+
+static const I2cDeviceConfig_t* gDeviceConfig;
+
+static I2cWaitStats_t gWaitStats[I2C_MAX];
+
+/**
+ * The expected status codes of each op. The ops without a step on the bus
+ * (I2C_OP_END, I2C_OP_STOP) have no entry.
+ */
+static const I2cOpInfo_t gOpInfo[I2C_OP_MAX] =
+{
+  [I2C_OP_START] = { I2C_SR_MT_STA, I2C_SR_MT_RSTA, 2, 0 },
+  [I2C_OP_ADDR_W] = { I2C_SR_MT_AACK, I2C_SR_MT_AACK, 3, 0 },
+  [I2C_OP_ADDR_R] = { I2C_SR_MR_AACK, I2C_SR_MR_AACK, 3, 0 },
+  [I2C_OP_REG] = { I2C_SR_MT_ACK, I2C_SR_MT_ACK, 4, 0 },
+  [I2C_OP_TX] = { I2C_SR_MT_ACK, I2C_SR_MT_ACK, 4, 1 },
+  //The ACK of a general call is the wired-AND of all the devices, so it
+  //only tells that at least one device acknowledged. A device may also
+  //latch or reset on the command without acknowledging it.
+  [I2C_OP_TX_GC] = { I2C_SR_MT_ACK, I2C_SR_MT_NACK, 4, 1 },
+  [I2C_OP_RX_ACK] = { I2C_SR_MR_ACK, I2C_SR_MR_ACK, 5, 1 },
+  [I2C_OP_RX_NACK] = { I2C_SR_MR_NACK, I2C_SR_MR_NACK, 5, 0 },
+  [I2C_OP_RX_BLOCK] = { I2C_SR_MR_ACK, I2C_SR_MR_ACK, 5, 1 },
 };
 
+static I2cEngine_t gEngine[I2C_MAX];
+
+static I2cRecorder_t gRecorder;
+
+static I2cWriteObserver_t gWriteObserver;
 
 /******************************************************************************
  * functions prototypes
  ******************************************************************************/
-inline static uint8_t I2c_SetSclFreq(const I2c_t I2c, const uint32_t Frequency);
+static uint8_t I2c_ComputeScl(const uint32_t Frequency, I2cScl_t* const Scl);
+inline static void I2c_SetScl(const I2c_t I2c, const I2cScl_t* const Scl);
+static const I2cScl_t* I2c_FindDeviceScl(const I2c_t I2c,
+                                         const uint8_t Address);
+inline static uint32_t I2c_GetSclPeriod(const I2cScl_t* const Scl);
+static void I2c_SelectScl(const I2c_t I2c, const I2cScl_t* const Scl);
+static void I2c_SelectDeviceScl(const I2c_t I2c, const uint8_t Address);
 inline static void I2c_Enable(const I2c_t I2c);
 inline static void I2c_SendStartBit(const I2c_t I2c);
 inline static void I2c_SendStopBit(const I2c_t I2c);
 inline static void I2c_WriteDataReg(const I2c_t I2c, const uint8_t Data);
 inline static uint8_t I2c_ReadDataReg(const I2c_t I2c);
 inline static void I2c_SendNack(const I2c_t I2c);
-static uint8_t I2C_WaitOnFlagUntilTimeout(const I2c_t I2c, const I2cFlag_t Flag);
+inline static void I2c_SendAck(const I2c_t I2c);
+inline static uint8_t I2c_ReadStatusReg(const I2c_t I2c);
+inline static uint8_t I2c_Lock(const I2c_t I2c);
+inline static void I2c_Unlock(const I2c_t I2c);
+static uint8_t I2c_Run(const I2c_t I2c, const I2cTransfer_t* const Transfer);
+static void I2c_Load(const I2c_t I2c, const I2cTransfer_t* const Transfer);
+static void I2c_AsyncEnd(const I2c_t I2c);
+static void I2c_NotifyWrite(const I2c_t I2c,
+                            const I2cTransfer_t* const Transfer);
+inline static uint8_t I2c_IsStepDone(const I2c_t I2c);
+static void I2c_EngineNext(const I2c_t I2c);
+static void I2c_EngineStep(const I2c_t I2c);
+static void I2c_EngineBlock(const I2c_t I2c);
+inline static void I2c_EngineReceive(const I2c_t I2c, const uint8_t Data);
+static void I2c_EngineAbort(const I2c_t I2c, const uint8_t Error);
+static void I2c_EngineTimeout(const I2c_t I2c);
+static void I2c_EngineBurst(const I2c_t I2c);
+static uint8_t I2C_WaitOnFlagUntilTimeout(const I2c_t I2c);
+inline static void I2c_Sleep(const I2c_t I2c);
 /******************************************************************************
  * functions definitions
  ******************************************************************************/
@@ -116,31 +284,44 @@ I2c_Init(const I2cConfig_t * const Config)
 
   for(i = 0; i < I2C_MAX; i++)
     {
-      res = I2c_SetSclFreq(i, Config[i].Speed);
+      res = I2c_ComputeScl(Config[i].Speed, &gBusScl[i]);
       if(res == 0) 
         {
           //TODO: handle this error
           return;
         }
+      I2c_SetScl(i, &gBusScl[i]);
       I2c_Enable(i);
     }
+
+  gDeviceConfig = I2c_GetDeviceConfig();
+
+  for(i = 0; i < I2C_DEVICE_MAX; i++)
+    {
+      res = I2c_ComputeScl(gDeviceConfig[i].Speed, &gDeviceScl[i]);
+      if(res == 0) 
+        {
+          //TODO: handle this error
+          return;
+        }
+    }
 }
 
 /******************************************************************************
-* Function : I2c_SetSclFreq()
+* Function : I2c_ComputeScl()
 *//**
 * \b Description:
-* Utility function to set the SCL frequency <br>
-* POST-CONDITION: The SCL frequency is set up <br>
-* @param I2c the id of the I2c peripheral
+* Utility function to compute the register values of an SCL frequency <br>
+* POST-CONDITION: The register values are saved in Scl <br>
 * @param Frequency the frequency of the SCL in Hz. It must be less than or
 * equal 400000 Hz.
-* @return uint8_t 1 if the frequency is set up, 0 otherwise.
+* @param Scl a pointer to receive the register values in
+* @return uint8_t 1 if the frequency is valid, 0 otherwise.
  ******************************************************************************/
-inline static uint8_t 
-I2c_SetSclFreq(const I2c_t I2c, const uint32_t Frequency)
+static uint8_t 
+I2c_ComputeScl(const uint32_t Frequency, I2cScl_t* const Scl)
 {
-  if(!(Frequency <= 400000ul))
+  if(!(Frequency != 0 && Frequency <= 400000ul))
     {
       return 0; 
     }
@@ -161,8 +342,8 @@ I2c_SetSclFreq(const I2c_t I2c, const uint32_t Frequency)
       BitrateReg = I2C_FREQ_TO_REG(Frequency, Prescaler);
       if(BitrateReg < 255)
         {
-          *(gBitrateReg[I2c]) = (uint8_t)BitrateReg;
-          *(gStatusReg[I2c]) = PrescalerIndex;
+          Scl->Bitrate = (uint8_t)BitrateReg;
+          Scl->Prescaler = PrescalerIndex;
           return 1;
         }
     }
@@ -170,6 +351,109 @@ I2c_SetSclFreq(const I2c_t I2c, const uint32_t Frequency)
   return 0;
 }
 
+/******************************************************************************
+* Function : I2c_SetScl()
+*//**
+* \b Description:
+* Utility function to set the SCL frequency <br>
+* PRE-CONDITION: The bus is idle <br>
+* POST-CONDITION: The SCL frequency is set up <br>
+* @param I2c the id of the I2c peripheral
+* @param Scl the precomputed register values of the SCL frequency
+* @return void
+ ******************************************************************************/
+inline static void
+I2c_SetScl(const I2c_t I2c, const I2cScl_t* const Scl)
+{
+  *(gBitrateReg[I2c]) = Scl->Bitrate;
+  *(gStatusReg[I2c]) = Scl->Prescaler;
+  gActiveScl[I2c] = *Scl;
+}
+
+/******************************************************************************
+* Function : I2c_FindDeviceScl()
+*//**
+* \b Description:
+* Utility function to find the SCL register values of a device. A device
+* which isn't listed in the device configuration table gets the ones of the
+* peripheral. <br>
+* @param I2c the id of the I2c peripheral
+* @param Address the 7-bit address of the device
+* @return const I2cScl_t* the register values
+ ******************************************************************************/
+static const I2cScl_t*
+I2c_FindDeviceScl(const I2c_t I2c, const uint8_t Address)
+{
+  uint8_t i;
+
+  for(i = 0; i < I2C_DEVICE_MAX; i++)
+    {
+      if(gDeviceConfig[i].I2c == I2c && gDeviceConfig[i].Address == Address)
+        {
+          return &gDeviceScl[i];
+        }
+    }
+
+  return &gBusScl[I2c];
+}
+
+/******************************************************************************
+* Function : I2c_GetSclPeriod()
+*//**
+* \b Description:
+* Utility function to get the part of the SCL period set by the registers,
+* TWBR * 4^TWPS. A larger value is a lower frequency. <br>
+* @param Scl the register values
+* @return uint32_t the period in units of 2 CPU cycles, less the fixed 16
+* cycles
+ ******************************************************************************/
+inline static uint32_t
+I2c_GetSclPeriod(const I2cScl_t* const Scl)
+{
+  return (uint32_t)Scl->Bitrate << (2 * Scl->Prescaler);
+}
+
+/******************************************************************************
+* Function : I2c_SelectScl()
+*//**
+* \b Description:
+* Utility function to switch the SCL frequency. The registers are only
+* written if they differ from the ones currently programmed. <br>
+* PRE-CONDITION: The bus is idle <br>
+* POST-CONDITION: The SCL frequency is set up <br>
+* @param I2c the id of the I2c peripheral
+* @param Scl the precomputed register values of the SCL frequency
+* @return void
+ ******************************************************************************/
+static void
+I2c_SelectScl(const I2c_t I2c, const I2cScl_t* const Scl)
+{
+  if(Scl->Bitrate != gActiveScl[I2c].Bitrate ||
+    Scl->Prescaler != gActiveScl[I2c].Prescaler)
+    {
+      I2c_SetScl(I2c, Scl);
+    }
+}
+
+/******************************************************************************
+* Function : I2c_SelectDeviceScl()
+*//**
+* \b Description:
+* Utility function to switch the SCL frequency to the one of a device. The
+* registers are only written if the device needs a different speed than the
+* one currently programmed. <br>
+* PRE-CONDITION: The bus is idle <br>
+* POST-CONDITION: The SCL frequency matches the device <br>
+* @param I2c the id of the I2c peripheral
+* @param Address the 7-bit address of the device
+* @return void
+ ******************************************************************************/
+static void
+I2c_SelectDeviceScl(const I2c_t I2c, const uint8_t Address)
+{
+  I2c_SelectScl(I2c, I2c_FindDeviceScl(I2c, Address));
+}
+
 /******************************************************************************
 * Function : I2c_Enable()
 *//**
@@ -186,227 +470,1381 @@ I2c_Enable(const I2c_t I2c)
 }
 
 /******************************************************************************
-* Function : I2c_SendByte()
+* Function : I2c_Transfer()
 *//**
-* \b Description: Write one byte into a device register using I2C <br>
-* POST-CONDITION: A byte is saved inside the device register <br>
+* \b Description: Run a transaction program using I2C. Every step of the
+* program is checked against the expected status code of its op. If a step
+* fails, a stop bit is sent and the error of the op is returned. <br>
+* POST-CONDITION: The program is run <br>
 * @param I2c the id of the I2C peripheral
-* @param Address the address of the register to write using I2C peripheral
-* @param Data the byte to write 
+* @param Transfer the program and its operands
 * @return uint8_t 1 the operations is done successfully
 *                 2 start bit error
 *                 3 address error
 *                 4 data sending error
+*                 5 data receiving error
+*                 6 the peripheral is busy
+*                 7 invalid byte count of I2C_OP_RX_BLOCK
  ******************************************************************************/
-extern uint8_t 
-I2c_SendByte(const I2c_t I2c, 
-             const uint8_t Address,
-             const uint8_t Register, 
-             const uint8_t Data)
+extern uint8_t
+I2c_Transfer(const I2c_t I2c, const I2cTransfer_t* const Transfer)
 {
-  if(!(I2c < I2C_MAX)) return 0; 
-    
+  if(!(I2c < I2C_MAX && Transfer != 0x0 && Transfer->Program != 0x0))
+    {
+      return 0;
+    }
+
   uint8_t res;
 
-  I2c_SendStartBit(I2c);
-  res = I2C_WaitOnFlagUntilTimeout(I2c, I2C_FLAG_STA);
-  if(res == 0) return 2;
+  res = I2c_Lock(I2c);
+  if(res == 0) return 6;
 
-  I2c_WriteDataReg(I2c, (Address << 1) | I2C_WRITE);
-  res = I2C_WaitOnFlagUntilTimeout(I2c, I2C_FLAG_ACK);
-  if(res == 0) return 3;
+  //the speed can't change while the bus is owned
+  if(gEngine[I2c].Owned == 0)
+    {
+      I2c_SelectDeviceScl(I2c, Transfer->Address);
+    }
 
-  I2c_WriteDataReg(I2c, Register);
-  res = I2C_WaitOnFlagUntilTimeout(I2c, I2C_FLAG_ACK);
-  if(res == 0) return 4;
-  
-  I2c_WriteDataReg(I2c, Data);
-  res = I2C_WaitOnFlagUntilTimeout(I2c, I2C_FLAG_ACK);
-  if(res == 0) return 4;
+  res = I2c_Run(I2c, Transfer);
 
-  I2c_SendStopBit(I2c);
+  I2c_Unlock(I2c);
 
-  return 1;
+  return res;
 }
 
 /******************************************************************************
-* Function : I2c_ReceiveByte()
+* Function : I2c_TransferAsync()
 *//**
-* \b Description: Read one byte from a device register using I2C <br>
-* POST-CONDITION: A byte is received from the device register <br>
+* \b Description: Start a transaction program using I2C without waiting
+* for it. It's advanced by I2c_Poll, or by the I2C interrupt if
+* I2C_ASYNC_IRQ is 1, so the transfers of several peripherals run at the
+* same time. The callback of the transfer is called when it ends. <br>
+* POST-CONDITION: The result of I2c_GetResult is I2C_PENDING until the
+* program ends <br>
 * @param I2c the id of the I2C peripheral
-* @param Address the address of the register to read using I2C peripheral
-* @param Data a pointer to receive the byte in
-* @return uint8_t 1 the operations is done successfully
-*                 2 start bit error
-*                 3 address error
-*                 4 register sending error
-*                 5 data receiving error
+* @param Transfer the program and its operands. It must stay valid until
+* the program ends.
+* @return uint8_t 1 the program is started
+*                 6 the peripheral is busy
  ******************************************************************************/
 extern uint8_t
-I2c_ReceiveByte(const I2c_t I2c,
-             const uint8_t Address,
-             const uint8_t Register,
-	     uint8_t* const Data)
+I2c_TransferAsync(const I2c_t I2c, const I2cTransfer_t* const Transfer)
 {
-  if(!(I2c < I2C_MAX)) return 0;
+  if(!(I2c < I2C_MAX && Transfer != 0x0 && Transfer->Program != 0x0))
+    {
+      return 0;
+    }
 
+  I2C_CRITICAL_STATE State;
+  uint8_t Ended;
   uint8_t res;
 
-  I2c_SendStartBit(I2c);
-  res = I2C_WaitOnFlagUntilTimeout(I2c, I2C_FLAG_STA);
-  if(res == 0) return 2;
-
-  I2c_WriteDataReg(I2c, (Address << 1) | I2C_WRITE);
-  res = I2C_WaitOnFlagUntilTimeout(I2c, I2C_FLAG_ACK);
-  if(res == 0) return 3;
-
-  I2c_WriteDataReg(I2c, Register);
-  res = I2C_WaitOnFlagUntilTimeout(I2c, I2C_FLAG_ACK);
-  if(res == 0) return 4;
-
-  I2c_SendStartBit(I2c);
-  res = I2C_WaitOnFlagUntilTimeout(I2c, I2C_FLAG_STA);
-  if(res == 0) return 2;
-
-  I2c_WriteDataReg(I2c, (Address << 1) | I2C_READ);
-  res = I2C_WaitOnFlagUntilTimeout(I2c, I2C_FLAG_ACK);
-  if(res == 0) return 3;
+  res = I2c_Lock(I2c);
+  if(res == 0) return 6;
 
-  I2c_SendNack(I2c);
-  res = I2C_WaitOnFlagUntilTimeout(I2c, I2C_FLAG_NACK);
-  if(res == 0) return 5;
+  if(gEngine[I2c].Owned == 0)
+    {
+      I2c_SelectDeviceScl(I2c, Transfer->Address);
+    }
 
-  I2c_SendStopBit(I2c);
+  //the interrupt mustn't advance the program before it's loaded. Once the
+  //section is left, it may end the program itself, so only a program ended
+  //by the load is ended here.
+  I2C_ENTER_CRITICAL(State);
+  gEngine[I2c].Async = 1;
+  I2c_Load(I2c, Transfer);
+  Ended = gEngine[I2c].Status != I2C_PENDING;
+  if(Ended != 0)
+    {
+      gEngine[I2c].Async = 0;
+    }
+  I2C_EXIT_CRITICAL(State);
 
-  *Data = I2c_ReadDataReg(I2c);
+  if(Ended != 0)
+    {
+      I2c_AsyncEnd(I2c);
+    }
 
   return 1;
 }
 
 /******************************************************************************
-* Function : I2C_WaitOnFlagUntilTimeout()
+* Function : I2c_Poll()
 *//**
-* \b Description: Utility function handles I2C Communication Timeout.
-* It also clears the flag if set. <br>
-* @param  I2c the id of the I2c peripheral
-* @param  Flag flag to check.
-* @return uint8_t 1 if there's no timeout and the flag is set, 0 otherwise
-******************************************************************************/
-static uint8_t 
-I2C_WaitOnFlagUntilTimeout(const I2c_t I2c, const I2cFlag_t Flag)
+* \b Description: Advance the asynchronous transfers of all the I2C
+* peripherals. If I2C_ASYNC_IRQ is 1, the interrupt advances them and this
+* function only ends the ones which made no progress for I2C_TIMEOUT calls.
+* It's meant to be called from the main loop or the scheduler tick. <br>
+* @return void
+ ******************************************************************************/
+extern void
+I2c_Poll(void)
 {
-  uint16_t Timeout = 0;
-  uint8_t Status = 0;
-  uint8_t StatusReg;
-  uint8_t FinishOp;
-
-  while (Timeout < I2C_TIMEOUT)
-    {
-      FinishOp = *(gControlReg[I2c]) & (1 << TWINT);
-      if(FinishOp != 0) break;
-
-      Timeout++;
-    }
+  I2cEngine_t* Engine;
+  uint8_t i;
 
-  if(Timeout != I2C_TIMEOUT)
+  for(i = 0; i < I2C_MAX; i++)
     {
-      StatusReg = *(gStatusReg[I2c]);
-      //mask the first three bits which are not related to status.
-      StatusReg &= 0xF8;
+      Engine = &gEngine[i];
+      if(Engine->Async == 0) continue;
 
-      switch(Flag)
-      {
-        case I2C_FLAG_STA:
-          if(StatusReg == I2C_SR_MT_STA ||
-            StatusReg == I2C_SR_MT_RSTA ||
-            StatusReg == I2C_SR_MR_STA)
-            {
-              Status = 1;
-            }
-        break;
+#if I2C_ASYNC_IRQ == 1
+      I2C_CRITICAL_STATE State;
+      uint8_t Ended = 0;
 
-        case I2C_FLAG_ACK:
-          if(StatusReg == I2C_SR_MT_AACK ||
-            StatusReg == I2C_SR_MT_ACK ||
-            StatusReg == I2C_SR_MR_AACK)
+      I2C_ENTER_CRITICAL(State);
+      if(Engine->Async != 0 && Engine->Status == I2C_PENDING)
+        {
+          Engine->Timeout++;
+          if(Engine->Timeout >= I2C_TIMEOUT)
             {
-              Status = 1;
+              I2c_EngineTimeout(i);
+              Ended = 1;
             }
-        break;
+        }
+      I2C_EXIT_CRITICAL(State);
 
-        case I2C_FLAG_NACK:
-          if(StatusReg == I2C_SR_MR_NACK)
+      if(Ended != 0)
+        {
+          I2c_AsyncEnd(i);
+        }
+#else
+      I2C_SIM_POLL(i);
+      if(I2c_IsStepDone(i) != 0)
+        {
+          Engine->Timeout = 0;
+          I2c_EngineStep(i);
+        }
+      else
+        {
+          Engine->Timeout++;
+          if(Engine->Timeout >= I2C_TIMEOUT)
             {
-              Status = 1;
+              I2c_EngineTimeout(i);
             }
-        break;
+        }
 
-        default:
-        break;
-      }
+      if(Engine->Status != I2C_PENDING)
+        {
+          I2c_AsyncEnd(i);
+        }
+#endif
     }
-
-  return Status;
 }
 
 /******************************************************************************
-* Function : I2c_SendStartBit()
+* Function : I2c_GetResult()
 *//**
-* \b Description: Utility function to send a start bit on the I2c bus. <br>
-* @param  I2c the id of the I2c peripheral
-* @param  Flag flag to check.
-* @return void
-******************************************************************************/
-inline static void
-I2c_SendStartBit(const I2c_t I2c)
+* \b Description: Get the result of the last transfer of an I2C
+* peripheral. <br>
+* @param I2c the id of the I2C peripheral
+* @return uint8_t I2C_PENDING while an asynchronous transfer runs, the
+* result of the transfer otherwise, see I2c_Transfer.
+ ******************************************************************************/
+extern uint8_t
+I2c_GetResult(const I2c_t I2c)
 {
-  *(gControlReg[I2c]) = 1 << TWEN | 1 << TWINT | 1 << TWSTA;
+  if(!(I2c < I2C_MAX)) return 0;
+
+  return gEngine[I2c].Status;
 }
 
 /******************************************************************************
-* Function : I2c_SendStopBit()
+* Function : I2c_SendByte()
 *//**
-* \b Description: Utility function to send a stop bit on the I2c bus. <br>
-* @param  I2c the id of the I2c peripheral
-* @param  Flag flag to check.
-* @return void
-******************************************************************************/
-inline static void
-I2c_SendStopBit(const I2c_t I2c)
+* \b Description: Write one byte into a device register using I2C <br>
+* POST-CONDITION: A byte is saved inside the device register <br>
+* @param I2c the id of the I2C peripheral
+* @param Address the address of the register to write using I2C peripheral
+* @param Data the byte to write
+* @return uint8_t 1 the operations is done successfully
+*                 2 start bit error
+*                 3 address error
+*                 4 data sending error
+*                 6 the peripheral is busy
+ ******************************************************************************/
+extern uint8_t
+I2c_SendByte(const I2c_t I2c,
+             const uint8_t Address,
+             const uint8_t Register,
+             const uint8_t Data)
 {
-  *(gControlReg[I2c]) = 1 << TWEN | 1 << TWINT | 1 << TWSTO;
+  static const uint8_t Program[] =
+  {
+    I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_REG, I2C_OP_TX, 1, I2C_OP_STOP,
+    I2C_OP_END
+  };
+  I2cTransfer_t Transfer = { Program, Address, Register, &Data, 0x0, 0x0, 0x0 };
+
+  return I2c_Transfer(I2c, &Transfer);
 }
 
 /******************************************************************************
-* Function : I2c_WriteDataReg()
+* Function : I2c_ReceiveByte()
 *//**
-* \b Description: Utility function to set a byte in the I2C data register
-* to be send by the peripheral.<br>
-* @param  I2c the id of the I2c peripheral
-* @return void
-******************************************************************************/
-inline static void
-I2c_WriteDataReg(const I2c_t I2c, const uint8_t Data)
+* \b Description: Read one byte from a device register using I2C <br>
+* POST-CONDITION: A byte is received from the device register <br>
+* @param I2c the id of the I2C peripheral
+* @param Address the address of the register to read using I2C peripheral
+* @param Data a pointer to receive the byte in
+* @return uint8_t 1 the operations is done successfully
+*                 2 start bit error
+*                 3 address error
+*                 4 register sending error
+*                 5 data receiving error
+*                 6 the peripheral is busy
+ ******************************************************************************/
+extern uint8_t
+I2c_ReceiveByte(const I2c_t I2c,
+             const uint8_t Address,
+             const uint8_t Register,
+             uint8_t* const Data)
 {
-  *(gDataReg[I2c]) = Data;
-  *(gControlReg[I2c]) = 1 << TWEN | 1 << TWINT;
+  if(!(Data != 0x0)) return 0;
+
+  static const uint8_t Program[] =
+  {
+    I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_REG, I2C_OP_START, I2C_OP_ADDR_R,
+    I2C_OP_RX_NACK, I2C_OP_STOP, I2C_OP_END
+  };
+  I2cTransfer_t Transfer = { Program, Address, Register, 0x0, Data, 0x0, 0x0 };
+
+  return I2c_Transfer(I2c, &Transfer);
 }
 
 /******************************************************************************
-* Function : I2c_ReadDataReg()
+* Function : I2c_SendBytes()
 *//**
-* \b Description: Utility function to return a byte from the I2C data
-* register <br>
-* @param  I2c the id of the I2c peripheral
-* @return uint8_t the byte received
-******************************************************************************/
-inline static uint8_t
+* \b Description: Write successive bytes into device registers using I2C
+* starting from a register. The device is expected to increment its
+* register pointer after each byte. <br>
+* POST-CONDITION: The bytes are saved inside the device registers <br>
+* @param I2c the id of the I2C peripheral
+* @param Address the address of the device
+* @param Register the first register to write
+* @param Data the bytes to write
+* @param Length the number of the bytes to write
+* @return uint8_t 1 the operations is done successfully
+*                 2 start bit error
+*                 3 address error
+*                 4 data sending error
+*                 6 the peripheral is busy
+ ******************************************************************************/
+extern uint8_t
+I2c_SendBytes(const I2c_t I2c,
+              const uint8_t Address,
+              const uint8_t Register,
+              const uint8_t* const Data,
+              const uint8_t Length)
+{
+  if(!(Data != 0x0 || Length == 0)) return 0;
+
+  const uint8_t Program[] =
+  {
+    I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_REG, I2C_OP_TX, Length, I2C_OP_STOP,
+    I2C_OP_END
+  };
+  I2cTransfer_t Transfer = { Program, Address, Register, Data, 0x0, 0x0, 0x0 };
+
+  return I2c_Transfer(I2c, &Transfer);
+}
+
+/******************************************************************************
+* Function : I2c_ReceiveBytes()
+*//**
+* \b Description: Read successive bytes from device registers using I2C
+* starting from a register. The device is expected to increment its
+* register pointer after each byte. <br>
+* POST-CONDITION: The bytes are received from the device registers <br>
+* @param I2c the id of the I2C peripheral
+* @param Address the address of the device
+* @param Register the first register to read
+* @param Data a pointer to receive the bytes in
+* @param Length the number of the bytes to read. It must be at least 1.
+* @return uint8_t 1 the operations is done successfully
+*                 2 start bit error
+*                 3 address error
+*                 4 register sending error
+*                 5 data receiving error
+*                 6 the peripheral is busy
+ ******************************************************************************/
+extern uint8_t
+I2c_ReceiveBytes(const I2c_t I2c,
+                 const uint8_t Address,
+                 const uint8_t Register,
+                 uint8_t* const Data,
+                 const uint8_t Length)
+{
+  if(!(Data != 0x0 && Length != 0)) return 0;
+
+  //acknowledge all the bytes except the last one
+  const uint8_t Program[] =
+  {
+    I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_REG, I2C_OP_START, I2C_OP_ADDR_R,
+    I2C_OP_RX_ACK, Length - 1, I2C_OP_RX_NACK, I2C_OP_STOP, I2C_OP_END
+  };
+  I2cTransfer_t Transfer = { Program, Address, Register, 0x0, Data, 0x0, 0x0 };
+
+  return I2c_Transfer(I2c, &Transfer);
+}
+
+/******************************************************************************
+* Function : I2c_UpdateBits()
+*//**
+* \b Description: Update a bit field of a device register using I2C. The
+* register is read then written using a repeated start, so the bus isn't
+* released between the read and the write. The write is skipped if the
+* field already has the value. <br>
+* POST-CONDITION: The bits of the mask in the device register equal the
+* ones of the value <br>
+* @param I2c the id of the I2C peripheral
+* @param Address the address of the device
+* @param Register the register to update
+* @param Mask the bits to update
+* @param Value the new value of the bits
+* @return uint8_t 1 the operations is done successfully
+*                 2 start bit error
+*                 3 address error
+*                 4 register or data sending error
+*                 5 data receiving error
+*                 6 the peripheral is busy
+ ******************************************************************************/
+extern uint8_t
+I2c_UpdateBits(const I2c_t I2c,
+               const uint8_t Address,
+               const uint8_t Register,
+               const uint8_t Mask,
+               const uint8_t Value)
+{
+  if(!(I2c < I2C_MAX)) return 0;
+
+  static const uint8_t ReadProgram[] =
+  {
+    I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_REG, I2C_OP_START, I2C_OP_ADDR_R,
+    I2C_OP_RX_NACK, I2C_OP_END
+  };
+  static const uint8_t WriteProgram[] =
+  {
+    I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_REG, I2C_OP_TX, 1, I2C_OP_STOP,
+    I2C_OP_END
+  };
+  static const uint8_t StopProgram[] =
+  {
+    I2C_OP_STOP, I2C_OP_END
+  };
+  uint8_t OldValue;
+  uint8_t NewValue;
+  I2cTransfer_t Transfer = { ReadProgram, Address, Register, &NewValue,
+                             &OldValue, 0x0, 0x0 };
+  uint8_t res;
+
+  res = I2c_Lock(I2c);
+  if(res == 0) return 6;
+
+  //the speed can't change while the bus is owned
+  if(gEngine[I2c].Owned == 0)
+    {
+      I2c_SelectDeviceScl(I2c, Address);
+    }
+
+  res = I2c_Run(I2c, &Transfer);
+  if(res == 1)
+    {
+      NewValue = (OldValue & ~Mask) | (Value & Mask);
+      Transfer.Program = NewValue != OldValue ? WriteProgram : StopProgram;
+      res = I2c_Run(I2c, &Transfer);
+    }
+
+  I2c_Unlock(I2c);
+
+  return res;
+}
+
+/******************************************************************************
+* Function : I2c_GroupUpdate()
+*//**
+* \b Description: Preload a register of several devices then latch them
+* together with one general call command. All the writes are chained using
+* repeated starts in one bus ownership window, at the lowest speed of the
+* devices and of the general call address. <br>
+* PRE-CONDITION: The devices respond to the general call address <br>
+* POST-CONDITION: All the devices applied their new values at the same time
+* <br>
+* @param I2c the id of the I2C peripheral
+* @param Addresses the addresses of the devices
+* @param Register the register to preload in every device
+* @param Data the byte to preload in each device, one per address
+* @param Count the number of the devices. If it's 0, only the general call
+* command is sent.
+* @param Command the general call command which latches the devices
+* @return uint8_t 1 the operations is done successfully
+*                 2 start bit error
+*                 3 address error, or no device acknowledged the general
+*                   call address
+*                 4 data sending error
+*                 6 the peripheral is busy
+ ******************************************************************************/
+extern uint8_t
+I2c_GroupUpdate(const I2c_t I2c,
+                const uint8_t* const Addresses,
+                const uint8_t Register,
+                const uint8_t* const Data,
+                const uint8_t Count,
+                const uint8_t Command)
+{
+  if(!(I2c < I2C_MAX &&
+      ((Addresses != 0x0 && Data != 0x0) || Count == 0))) return 0;
+
+  static const uint8_t PreloadProgram[] =
+  {
+    I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_REG, I2C_OP_TX, 1, I2C_OP_END
+  };
+  static const uint8_t LatchProgram[] =
+  {
+    I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_TX_GC, 1, I2C_OP_STOP, I2C_OP_END
+  };
+  I2cTransfer_t Transfer = { PreloadProgram, 0, Register, 0x0, 0x0, 0x0, 0x0 };
+  const I2cScl_t* Scl;
+  const I2cScl_t* DeviceScl;
+  uint8_t res;
+  uint8_t i;
+
+  res = I2c_Lock(I2c);
+  if(res == 0) return 6;
+
+  //all the devices share the bus in one window, so it runs at the lowest
+  //speed of the devices and of the general call
+  if(gEngine[I2c].Owned == 0)
+    {
+      Scl = I2c_FindDeviceScl(I2c, I2C_GENERAL_CALL);
+      for(i = 0; i < Count; i++)
+        {
+          DeviceScl = I2c_FindDeviceScl(I2c, Addresses[i]);
+          if(I2c_GetSclPeriod(DeviceScl) > I2c_GetSclPeriod(Scl))
+            {
+              Scl = DeviceScl;
+            }
+        }
+      I2c_SelectScl(I2c, Scl);
+    }
+
+  for(i = 0; i < Count && res == 1; i++)
+    {
+      Transfer.Address = Addresses[i];
+      Transfer.TxData = &Data[i];
+      res = I2c_Run(I2c, &Transfer);
+    }
+
+  if(res == 1)
+    {
+      Transfer.Program = LatchProgram;
+      Transfer.Address = I2C_GENERAL_CALL;
+      Transfer.TxData = &Command;
+      res = I2c_Run(I2c, &Transfer);
+    }
+
+  I2c_Unlock(I2c);
+
+  return res;
+}
+
+/******************************************************************************
+* Function : I2c_Start()
+*//**
+* \b Description: Send a start (or a repeated start) bit followed by the
+* address of a device. It's used with I2c_Write, I2c_Read and I2c_Stop to
+* build the transactions not covered by the other functions. <br>
+* POST-CONDITION: The device is addressed <br>
+* @param I2c the id of the I2C peripheral
+* @param Address the address of the device
+* @param Read 1 to address the device for reading, 0 for writing
+* @return uint8_t 1 the operations is done successfully
+*                 2 start bit error
+*                 3 address error
+*                 6 the peripheral is busy
+ ******************************************************************************/
+extern uint8_t
+I2c_Start(const I2c_t I2c, const uint8_t Address, const uint8_t Read)
+{
+  static const uint8_t WriteProgram[] =
+  {
+    I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_END
+  };
+  static const uint8_t ReadProgram[] =
+  {
+    I2C_OP_START, I2C_OP_ADDR_R, I2C_OP_END
+  };
+  I2cTransfer_t Transfer = { Read != 0 ? ReadProgram : WriteProgram, Address,
+                             0, 0x0, 0x0, 0x0, 0x0 };
+
+  return I2c_Transfer(I2c, &Transfer);
+}
+
+/******************************************************************************
+* Function : I2c_Write()
+*//**
+* \b Description: Send one byte to the addressed device <br>
+* PRE-CONDITION: The device is addressed for writing by I2c_Start <br>
+* @param I2c the id of the I2C peripheral
+* @param Data the byte to send
+* @return uint8_t 1 the operations is done successfully
+*                 4 data sending error
+*                 6 the peripheral is busy
+ ******************************************************************************/
+extern uint8_t
+I2c_Write(const I2c_t I2c, const uint8_t Data)
+{
+  static const uint8_t Program[] =
+  {
+    I2C_OP_TX, 1, I2C_OP_END
+  };
+  I2cTransfer_t Transfer = { Program, 0, 0, &Data, 0x0, 0x0, 0x0 };
+
+  return I2c_Transfer(I2c, &Transfer);
+}
+
+/******************************************************************************
+* Function : I2c_Read()
+*//**
+* \b Description: Receive one byte from the addressed device <br>
+* PRE-CONDITION: The device is addressed for reading by I2c_Start <br>
+* @param I2c the id of the I2C peripheral
+* @param Ack 1 to acknowledge the byte (more bytes follow), 0 to send NACK
+* (the last byte)
+* @param Data a pointer to receive the byte in
+* @return uint8_t 1 the operations is done successfully
+*                 5 data receiving error
+*                 6 the peripheral is busy
+ ******************************************************************************/
+extern uint8_t
+I2c_Read(const I2c_t I2c, const uint8_t Ack, uint8_t* const Data)
+{
+  if(!(Data != 0x0)) return 0;
+
+  static const uint8_t AckProgram[] =
+  {
+    I2C_OP_RX_ACK, 1, I2C_OP_END
+  };
+  static const uint8_t NackProgram[] =
+  {
+    I2C_OP_RX_NACK, I2C_OP_END
+  };
+  I2cTransfer_t Transfer = { Ack != 0 ? AckProgram : NackProgram, 0, 0, 0x0,
+                             Data, 0x0, 0x0 };
+
+  return I2c_Transfer(I2c, &Transfer);
+}
+
+/******************************************************************************
+* Function : I2c_Stop()
+*//**
+* \b Description: Send a stop bit and release the bus <br>
+* @param I2c the id of the I2C peripheral
+* @return void
+ ******************************************************************************/
+extern void
+I2c_Stop(const I2c_t I2c)
+{
+  static const uint8_t Program[] =
+  {
+    I2C_OP_STOP, I2C_OP_END
+  };
+  I2cTransfer_t Transfer = { Program, 0, 0, 0x0, 0x0, 0x0, 0x0 };
+
+  I2c_Transfer(I2c, &Transfer);
+}
+
+/******************************************************************************
+* Function : I2c_Lock()
+*//**
+* \b Description: Utility function to take the peripheral for a transfer.
+* It prevents an ISR from starting a transfer in the middle of another one.
+* <br>
+* @param  I2c the id of the I2c peripheral
+* @return uint8_t 1 if the peripheral is taken, 0 if it's busy
+******************************************************************************/
+inline static uint8_t
+I2c_Lock(const I2c_t I2c)
+{
+  I2C_CRITICAL_STATE State;
+  uint8_t Locked = 0;
+
+  I2C_ENTER_CRITICAL(State);
+  if(gEngine[I2c].Busy == 0)
+    {
+      gEngine[I2c].Busy = 1;
+      Locked = 1;
+    }
+  I2C_EXIT_CRITICAL(State);
+
+  return Locked;
+}
+
+/******************************************************************************
+* Function : I2c_Unlock()
+*//**
+* \b Description: Utility function to release the peripheral after a
+* transfer. <br>
+* @param  I2c the id of the I2c peripheral
+* @return void
+******************************************************************************/
+inline static void
+I2c_Unlock(const I2c_t I2c)
+{
+  gEngine[I2c].Busy = 0;
+}
+
+/******************************************************************************
+* Function : I2c_Run()
+*//**
+* \b Description: Utility function to run a program until it ends or fails.
+* <br>
+* PRE-CONDITION: The peripheral is taken by I2c_Lock <br>
+* @param  I2c the id of the I2c peripheral
+* @param  Transfer the program and its operands
+* @return uint8_t the result of the program, see I2c_Transfer
+******************************************************************************/
+static uint8_t
+I2c_Run(const I2c_t I2c, const I2cTransfer_t* const Transfer)
+{
+  I2cEngine_t* const Engine = &gEngine[I2c];
+  uint8_t res;
+
+  I2c_Load(I2c, Transfer);
+
+  while(Engine->Status == I2C_PENDING)
+    {
+      res = I2C_WaitOnFlagUntilTimeout(I2c);
+      if(res == 0)
+        {
+          I2c_EngineTimeout(I2c);
+        }
+      else
+        {
+          I2c_EngineStep(I2c);
+          if(I2C_FAST_DATA == 1 && Engine->Status == I2C_PENDING &&
+             Engine->Count > 1 &&
+             (Engine->Op == I2C_OP_TX || Engine->Op == I2C_OP_RX_ACK))
+            {
+              I2c_EngineBurst(I2c);
+            }
+        }
+    }
+
+  I2c_NotifyWrite(I2c, Transfer);
+
+  return Engine->Status;
+}
+
+/******************************************************************************
+* Function : I2c_Load()
+*//**
+* \b Description: Utility function to load a program into the engine and
+* start its first step. <br>
+* PRE-CONDITION: The peripheral is taken by I2c_Lock <br>
+* @param  I2c the id of the I2c peripheral
+* @param  Transfer the program and its operands
+* @return void
+******************************************************************************/
+static void
+I2c_Load(const I2c_t I2c, const I2cTransfer_t* const Transfer)
+{
+  I2cEngine_t* const Engine = &gEngine[I2c];
+
+  Engine->Transfer = Transfer;
+  Engine->Pc = Transfer->Program;
+  Engine->Tx = Transfer->TxData;
+  Engine->Rx = Transfer->RxData;
+  Engine->Count = 0;
+  Engine->Nack = 0;
+  Engine->Error = 0;
+  Engine->Timeout = 0;
+  Engine->Status = I2C_PENDING;
+
+  I2c_EngineNext(I2c);
+}
+
+/******************************************************************************
+* Function : I2c_AsyncEnd()
+*//**
+* \b Description: Utility function to release the peripheral after an
+* asynchronous transfer, then notify the client. The callback can start the
+* next transfer. <br>
+* @param  I2c the id of the I2c peripheral
+* @return void
+******************************************************************************/
+static void
+I2c_AsyncEnd(const I2c_t I2c)
+{
+  const I2cTransfer_t* const Transfer = gEngine[I2c].Transfer;
+  const uint8_t Status = gEngine[I2c].Status;
+
+  I2c_NotifyWrite(I2c, Transfer);
+
+  gEngine[I2c].Async = 0;
+  I2c_Unlock(I2c);
+
+  if(Transfer->Callback != 0x0)
+    {
+      Transfer->Callback(I2c, Transfer, Status);
+    }
+}
+
+/******************************************************************************
+* Function : I2c_NotifyWrite()
+*//**
+* \b Description: Utility function to give the registers written by an
+* ended program to the write observer. Only the programs which send a
+* register then bytes are written ones. They are given even if they failed,
+* because the device may have taken some bytes. <br>
+* @param  I2c the id of the I2c peripheral
+* @param  Transfer the program and its operands
+* @return void
+******************************************************************************/
+static void
+I2c_NotifyWrite(const I2c_t I2c, const I2cTransfer_t* const Transfer)
+{
+  const I2cWriteObserver_t Observer = gWriteObserver;
+  const uint8_t* Pc = Transfer->Program;
+  uint8_t HasRegister = 0;
+  uint16_t Length = 0;
+  uint8_t Op;
+
+  if(Observer == 0x0) return;
+
+  for(Op = *Pc; Op != I2C_OP_END && Op < I2C_OP_MAX; Op = *Pc)
+    {
+      Pc++;
+      if(Op == I2C_OP_REG)
+        {
+          HasRegister = 1;
+        }
+      else if(Op == I2C_OP_TX)
+        {
+          Length += *Pc;
+        }
+
+      if(gOpInfo[Op].HasCount != 0)
+        {
+          Pc++;
+        }
+    }
+
+  if(HasRegister != 0 && Length != 0)
+    {
+      Observer(I2c, Transfer->Address, Transfer->Register, Length);
+    }
+}
+
+/******************************************************************************
+* Function : I2c_EngineNext()
+*//**
+* \b Description: Utility function to start the next step of the program.
+* The ops without a step on the bus (a stop bit, a count of 0) are done
+* right away. <br>
+* @param  I2c the id of the I2c peripheral
+* @return void
+******************************************************************************/
+static void
+I2c_EngineNext(const I2c_t I2c)
+{
+  I2cEngine_t* const Engine = &gEngine[I2c];
+  uint8_t Op;
+
+  while(Engine->Count == 0)
+    {
+      if(Engine->Nack != 0)
+        {
+          //the last byte of a block
+          Engine->Nack = 0;
+          Engine->Op = I2C_OP_RX_NACK;
+          Engine->Count = 1;
+          break;
+        }
+
+      if(Engine->Error != 0)
+        {
+          I2c_EngineAbort(I2c, Engine->Error);
+          return;
+        }
+
+      Op = *Engine->Pc;
+      if(Op == I2C_OP_END)
+        {
+          Engine->Status = 1;
+          return;
+        }
+
+      if(!(Op < I2C_OP_MAX))
+        {
+          I2c_EngineAbort(I2c, 0);
+          return;
+        }
+
+      Engine->Pc++;
+
+      if(Op == I2C_OP_STOP)
+        {
+          I2c_SendStopBit(I2c);
+          I2C_RECORD(I2c, I2C_OP_STOP, I2C_NO_STATUS, 0);
+          Engine->Owned = 0;
+          continue;
+        }
+
+      Engine->Op = Op;
+      Engine->Count = 1;
+      if(gOpInfo[Op].HasCount != 0)
+        {
+          Engine->Count = *Engine->Pc;
+          Engine->Pc++;
+        }
+
+      //the byte count comes first, the bytes after it are set by its value
+      if(Op == I2C_OP_RX_BLOCK)
+        {
+          Engine->Extra = Engine->Count;
+          Engine->Count = 1;
+        }
+    }
+
+  switch(Engine->Op)
+  {
+    case I2C_OP_START:
+      I2c_SendStartBit(I2c);
+    break;
+
+    case I2C_OP_ADDR_W:
+      I2c_WriteDataReg(I2c, (Engine->Transfer->Address << 1) | I2C_WRITE);
+    break;
+
+    case I2C_OP_ADDR_R:
+      I2c_WriteDataReg(I2c, (Engine->Transfer->Address << 1) | I2C_READ);
+    break;
+
+    case I2C_OP_REG:
+      I2c_WriteDataReg(I2c, Engine->Transfer->Register);
+    break;
+
+    case I2C_OP_TX:
+    case I2C_OP_TX_GC:
+      I2c_WriteDataReg(I2c, *Engine->Tx);
+      Engine->Tx++;
+    break;
+
+    case I2C_OP_RX_ACK:
+    case I2C_OP_RX_BLOCK:
+      I2c_SendAck(I2c);
+    break;
+
+    default:
+      I2c_SendNack(I2c);
+    break;
+  }
+}
+
+/******************************************************************************
+* Function : I2c_EngineStep()
+*//**
+* \b Description: Utility function to finish the current step of the
+* program once the hardware is done, then start the next one. <br>
+* PRE-CONDITION: The interrupt flag is set <br>
+* @param  I2c the id of the I2c peripheral
+* @return void
+******************************************************************************/
+static void
+I2c_EngineStep(const I2c_t I2c)
+{
+  I2cEngine_t* const Engine = &gEngine[I2c];
+  const I2cOpInfo_t* const Info = &gOpInfo[Engine->Op];
+  uint8_t StatusReg;
+
+  StatusReg = I2c_ReadStatusReg(I2c);
+  I2C_RECORD(I2c, Engine->Op, StatusReg, I2c_ReadDataReg(I2c));
+
+  if(StatusReg != Info->Status && StatusReg != Info->AltStatus)
+    {
+      I2c_EngineAbort(I2c, Info->Error);
+      return;
+    }
+
+  if(Engine->Op == I2C_OP_START)
+    {
+      Engine->Owned = 1;
+    }
+  else if(Engine->Op == I2C_OP_RX_ACK || Engine->Op == I2C_OP_RX_NACK)
+    {
+      I2c_EngineReceive(I2c, I2c_ReadDataReg(I2c));
+    }
+  else if(Engine->Op == I2C_OP_RX_BLOCK)
+    {
+      I2c_EngineBlock(I2c);
+      return;
+    }
+
+  Engine->Count--;
+  I2c_EngineNext(I2c);
+}
+
+/******************************************************************************
+* Function : I2c_EngineBlock()
+*//**
+* \b Description: Utility function to finish the byte count of
+* I2C_OP_RX_BLOCK. The counted bytes and the bytes after them are received
+* as I2C_OP_RX_ACK bytes, then a NACKed one. An invalid count is followed
+* by a NACKed byte only, then the program ends with the result 7. <br>
+* PRE-CONDITION: The byte count is received <br>
+* @param  I2c the id of the I2c peripheral
+* @return void
+******************************************************************************/
+static void
+I2c_EngineBlock(const I2c_t I2c)
+{
+  I2cEngine_t* const Engine = &gEngine[I2c];
+  const uint8_t Count = I2c_ReadDataReg(I2c);
+
+  I2c_EngineReceive(I2c, Count);
+
+  Engine->Op = I2C_OP_RX_ACK;
+  Engine->Count = Count + Engine->Extra - 1;
+  Engine->Nack = 1;
+
+  if(Count == 0 || Count > I2C_RX_BLOCK_MAX)
+    {
+      //end the read with a NACK before the stop
+      Engine->Count = 0;
+      Engine->Error = 7;
+    }
+
+  I2c_EngineNext(I2c);
+}
+
+/******************************************************************************
+* Function : I2c_EngineReceive()
+*//**
+* \b Description: Utility function to give a received byte to the Receive
+* function of the transfer, or to save it in RxData if there's none. <br>
+* @param  I2c the id of the I2c peripheral
+* @param  Data the received byte
+* @return void
+******************************************************************************/
+inline static void
+I2c_EngineReceive(const I2c_t I2c, const uint8_t Data)
+{
+  I2cEngine_t* const Engine = &gEngine[I2c];
+
+  if(Engine->Transfer->Receive != 0x0)
+    {
+      Engine->Transfer->Receive(Engine->Transfer, Data);
+      return;
+    }
+
+  *Engine->Rx = Data;
+  Engine->Rx++;
+}
+
+/******************************************************************************
+* Function : I2c_EngineAbort()
+*//**
+* \b Description: Utility function to end a failed program. A stop bit is
+* sent to release the bus. <br>
+* @param  I2c the id of the I2c peripheral
+* @param  Error the result of the program
+* @return void
+******************************************************************************/
+static void
+I2c_EngineAbort(const I2c_t I2c, const uint8_t Error)
+{
+  I2c_SendStopBit(I2c);
+  I2C_RECORD(I2c, I2C_OP_STOP, I2C_NO_STATUS, 0);
+  gEngine[I2c].Owned = 0;
+  gEngine[I2c].Status = Error;
+}
+
+/******************************************************************************
+* Function : I2c_EngineTimeout()
+*//**
+* \b Description: Utility function to end a program whose step isn't done
+* after I2C_TIMEOUT polls. <br>
+* @param  I2c the id of the I2c peripheral
+* @return void
+******************************************************************************/
+static void
+I2c_EngineTimeout(const I2c_t I2c)
+{
+  const uint8_t Op = gEngine[I2c].Op;
+
+  I2C_RECORD(I2c, Op, I2C_NO_STATUS, 0);
+  I2c_EngineAbort(I2c, gOpInfo[Op].Error);
+}
+
+/******************************************************************************
+* Function : I2c_EngineBurst()
+*//**
+* \b Description: Utility function to run the data phase of the current op
+* in a tight loop. The next byte is loaded as soon as the flag is set and
+* the status is only compared with the code of the op, so the bus idles
+* for a few cycles between the bytes (I2C_FAST_STEP_CYCLES). It returns
+* with the last byte of the op on the bus, or at the first unexpected
+* status which is left for I2c_EngineStep. The interrupt is only enabled
+* for the last byte, the others are too short to sleep. <br>
+* PRE-CONDITION: The current op is I2C_OP_TX or I2C_OP_RX_ACK and it has
+* more than one step left <br>
+* @param  I2c the id of the I2c peripheral
+* @return void
+******************************************************************************/
+static void
+I2c_EngineBurst(const I2c_t I2c)
+{
+  I2cEngine_t* const Engine = &gEngine[I2c];
+  volatile uint8_t* const ControlReg = gControlReg[I2c];
+  volatile uint8_t* const StatusReg = gStatusReg[I2c];
+  volatile uint8_t* const DataReg = gDataReg[I2c];
+  const uint8_t Op = Engine->Op;
+  const uint8_t Expected = gOpInfo[Op].Status;
+  const I2cTransfer_t* const Transfer = Engine->Transfer;
+  const uint8_t* Tx = Engine->Tx;
+  uint8_t* Rx = Engine->Rx;
+  uint8_t Count = Engine->Count;
+  uint8_t Command = 1 << TWEN | 1 << TWINT;
+  uint8_t Status;
+  uint8_t Data;
+  uint16_t Timeout;
+#if I2C_WAIT_STATS == 1
+  uint16_t Start = I2C_GET_CYCLES();
+#endif
+
+  if(Op == I2C_OP_RX_ACK)
+    {
+      Command |= 1 << TWEA;
+    }
+
+  while(Count > 1)
+    {
+      for(Timeout = 0; Timeout < I2C_FAST_TIMEOUT; Timeout++)
+        {
+          I2C_SIM_FAST_POLL(I2c);
+          if((*ControlReg & (1 << TWINT)) != 0) break;
+        }
+
+      if(Timeout == I2C_FAST_TIMEOUT)
+        {
+          I2c_EngineTimeout(I2c);
+          break;
+        }
+
+      Status = *StatusReg & 0xF8;
+      if(Status != Expected) break;
+
+      Data = *DataReg;
+      if(Op != I2C_OP_RX_ACK)
+        {
+          *DataReg = *Tx;
+          Tx++;
+        }
+      else if(Transfer->Receive == 0x0)
+        {
+          *Rx = Data;
+          Rx++;
+        }
+
+      Count--;
+      if(Count == 1)
+        {
+          Command |= I2C_CMD_IE;
+        }
+      *ControlReg = Command;
+      I2C_SIM_FAST_COMMAND(I2c);
+
+      //the Receive function of the transfer runs while the next byte is on
+      //the bus, SCL isn't held for it
+      if(Op == I2C_OP_RX_ACK && Transfer->Receive != 0x0)
+        {
+          Transfer->Receive(Transfer, Data);
+        }
+
+      I2C_RECORD(I2c, Op, Status, Data);
+    }
+
+  Engine->Tx = Tx;
+  Engine->Rx = Rx;
+  Engine->Count = Count;
+
+#if I2C_WAIT_STATS == 1
+  gWaitStats[I2c].SpinCycles += (uint16_t)(I2C_GET_CYCLES() - Start);
+#endif
+}
+
+/******************************************************************************
+* Function : I2C_WaitOnFlagUntilTimeout()
+*//**
+* \b Description: Utility function handles I2C Communication Timeout.
+* It waits until the hardware finishes the current step. <br>
+* @param  I2c the id of the I2c peripheral
+* @return uint8_t 1 if there's no timeout and the flag is set, 0 otherwise
+******************************************************************************/
+static uint8_t
+I2C_WaitOnFlagUntilTimeout(const I2c_t I2c)
+{
+  uint16_t Timeout = 0;
+  uint8_t FinishOp = 0;
+#if I2C_WAIT_STATS == 1
+  uint16_t Start = I2C_GET_CYCLES();
+  uint32_t Asleep = gWaitStats[I2c].SleepCycles;
+#endif
+
+  while (Timeout < I2C_TIMEOUT)
+    {
+      I2C_SIM_POLL(I2c);
+      FinishOp = *(gControlReg[I2c]) & (1 << TWINT);
+      if(FinishOp != 0) break;
+
+#if I2C_WAIT_STRATEGY == I2C_WAIT_SLEEP
+      I2c_Sleep(I2c);
+#endif
+      Timeout++;
+    }
+
+#if I2C_WAIT_STATS == 1
+  Asleep = gWaitStats[I2c].SleepCycles - Asleep;
+  gWaitStats[I2c].SpinCycles += (uint16_t)(I2C_GET_CYCLES() - Start) - Asleep;
+#endif
+
+  return FinishOp != 0;
+}
+
+/******************************************************************************
+* Function : I2c_Sleep()
+*//**
+* \b Description: Utility function to put the CPU in idle sleep until an
+* interrupt fires. It returns immediately if the flag is already set. <br>
+* PRE-CONDITION: The I2C interrupt is enabled by the last command <br>
+* @param  I2c the id of the I2c peripheral
+* @return void
+******************************************************************************/
+inline static void
+I2c_Sleep(const I2c_t I2c)
+{
+#if I2C_WAIT_STATS == 1
+  uint16_t Start = I2C_GET_CYCLES();
+#endif
+
+  I2C_DISABLE_IRQ();
+  if((*(gControlReg[I2c]) & (1 << TWINT)) == 0)
+    {
+      //idle mode
+      *MCUCR = (*MCUCR & ~(1 << SM2 | 1 << SM1 | 1 << SM0)) | 1 << SE;
+      I2C_ENABLE_IRQ_AND_SLEEP();
+      I2C_SIM_SLEEP(I2c);
+      *MCUCR &= ~(1 << SE);
+    }
+  else
+    {
+      I2C_ENABLE_IRQ();
+    }
+
+#if I2C_WAIT_STATS == 1
+  gWaitStats[I2c].SleepCycles += (uint16_t)(I2C_GET_CYCLES() - Start);
+  gWaitStats[I2c].Wakeups++;
+#endif
+}
+
+/******************************************************************************
+* Function : I2c_IrqHandler()
+*//**
+* \b Description: The I2C interrupt handler. It must be called from the
+* interrupt of the I2C peripheral. It advances the asynchronous transfer if
+* I2C_ASYNC_IRQ is 1. Otherwise it only disables the interrupt so it
+* doesn't fire again, the flag stays set for the waiting function. <br>
+* @param  I2c the id of the I2c peripheral
+* @return void
+******************************************************************************/
+extern void
+I2c_IrqHandler(const I2c_t I2c)
+{
+#if I2C_ASYNC_IRQ == 1
+  if(gEngine[I2c].Async != 0)
+    {
+      gEngine[I2c].Timeout = 0;
+      I2c_EngineStep(I2c);
+      if(gEngine[I2c].Status != I2C_PENDING)
+        {
+          I2c_AsyncEnd(I2c);
+        }
+      return;
+    }
+#endif
+
+  //writing 0 to TWINT doesn't clear it.
+  *(gControlReg[I2c]) &= ~(1 << TWIE | 1 << TWINT);
+}
+
+/******************************************************************************
+* Function : I2c_GetWaitStats()
+*//**
+* \b Description: Get the CPU cycles spent waiting for the hardware since
+* the last reset. It's only updated when I2C_WAIT_STATS is 1. <br>
+* @param  I2c the id of the I2c peripheral
+* @param  Stats a pointer to receive the statistics in
+* @return void
+******************************************************************************/
+extern void
+I2c_GetWaitStats(const I2c_t I2c, I2cWaitStats_t* const Stats)
+{
+  if(!(I2c < I2C_MAX && Stats != 0x0)) return;
+
+  *Stats = gWaitStats[I2c];
+}
+
+/******************************************************************************
+* Function : I2c_ResetWaitStats()
+*//**
+* \b Description: Reset the CPU cycles spent waiting for the hardware. <br>
+* @param  I2c the id of the I2c peripheral
+* @return void
+******************************************************************************/
+extern void
+I2c_ResetWaitStats(const I2c_t I2c)
+{
+  if(!(I2c < I2C_MAX)) return;
+
+  gWaitStats[I2c].SleepCycles = 0;
+  gWaitStats[I2c].SpinCycles = 0;
+  gWaitStats[I2c].Wakeups = 0;
+}
+
+/******************************************************************************
+* Function : I2c_SetRecorder()
+*//**
+* \b Description: Set the function called with every step of the
+* transactions of all the I2C peripherals: the op, the status code and the
+* byte sent or received. A step which times out, like a stop bit, has the
+* status I2C_NO_STATUS. The recorder runs in the context of the
+* step, the I2C interrupt if I2C_ASYNC_IRQ is 1, so it must be short. It's
+* only called when I2C_RECORDER is 1. <br>
+* @param  Recorder the function, null to stop recording
+* @return void
+******************************************************************************/
+extern void
+I2c_SetRecorder(const I2cRecorder_t Recorder)
+{
+  I2C_CRITICAL_STATE State;
+
+  I2C_ENTER_CRITICAL(State);
+  gRecorder = Recorder;
+  I2C_EXIT_CRITICAL(State);
+}
+
+/******************************************************************************
+* Function : I2c_SetWriteObserver()
+*//**
+* \b Description: Set the function called when a program of I2c_Transfer,
+* I2c_TransferAsync or of the functions built on them sends bytes to a
+* register, e.g. to drop the cached copies of the registers. The bytes of
+* I2c_Write aren't observed. The observer runs when the program ends, in
+* the I2C interrupt for an asynchronous program if I2C_ASYNC_IRQ is 1, so
+* it must be short. <br>
+* @param  Observer the function, null to stop observing
+* @return void
+******************************************************************************/
+extern void
+I2c_SetWriteObserver(const I2cWriteObserver_t Observer)
+{
+  I2C_CRITICAL_STATE State;
+
+  I2C_ENTER_CRITICAL(State);
+  gWriteObserver = Observer;
+  I2C_EXIT_CRITICAL(State);
+}
+
+/******************************************************************************
+* Function : I2c_SendStartBit()
+*//**
+* \b Description: Utility function to send a start bit on the I2c bus. <br>
+* @param  I2c the id of the I2c peripheral
+* @param  Flag flag to check.
+* @return void
+******************************************************************************/
+inline static void
+I2c_SendStartBit(const I2c_t I2c)
+{
+  *(gControlReg[I2c]) = 1 << TWEN | 1 << TWINT | 1 << TWSTA | I2C_CMD_IE;
+  I2C_SIM_COMMAND(I2c);
+}
+
+/******************************************************************************
+* Function : I2c_SendStopBit()
+*//**
+* \b Description: Utility function to send a stop bit on the I2c bus. <br>
+* @param  I2c the id of the I2c peripheral
+* @param  Flag flag to check.
+* @return void
+******************************************************************************/
+inline static void
+I2c_SendStopBit(const I2c_t I2c)
+{
+  *(gControlReg[I2c]) = 1 << TWEN | 1 << TWINT | 1 << TWSTO;
+  I2C_SIM_COMMAND(I2c);
+}
+
+/******************************************************************************
+* Function : I2c_WriteDataReg()
+*//**
+* \b Description: Utility function to set a byte in the I2C data register
+* to be send by the peripheral.<br>
+* @param  I2c the id of the I2c peripheral
+* @return void
+******************************************************************************/
+inline static void
+I2c_WriteDataReg(const I2c_t I2c, const uint8_t Data)
+{
+  *(gDataReg[I2c]) = Data;
+  *(gControlReg[I2c]) = 1 << TWEN | 1 << TWINT | I2C_CMD_IE;
+  I2C_SIM_COMMAND(I2c);
+}
+
+/******************************************************************************
+* Function : I2c_ReadDataReg()
+*//**
+* \b Description: Utility function to return a byte from the I2C data
+* register <br>
+* @param  I2c the id of the I2c peripheral
+* @return uint8_t the byte received
+******************************************************************************/
+inline static uint8_t
 I2c_ReadDataReg(const I2c_t I2c)
 {
   return *(gDataReg[I2c]);
 }
 
+/******************************************************************************
+* Function : I2c_ReadStatusReg()
+*//**
+* \b Description: Utility function to return the status code of the last
+* step <br>
+* @param  I2c the id of the I2c peripheral
+* @return uint8_t the status code
+******************************************************************************/
+inline static uint8_t
+I2c_ReadStatusReg(const I2c_t I2c)
+{
+  //mask the first three bits which are not related to status.
+  return *(gStatusReg[I2c]) & 0xF8;
+}
+
+/******************************************************************************
+* Function : I2c_IsStepDone()
+*//**
+* \b Description: Utility function to check whether the hardware finished
+* the current step <br>
+* @param  I2c the id of the I2c peripheral
+* @return uint8_t 1 if the interrupt flag is set, 0 otherwise
+******************************************************************************/
+inline static uint8_t
+I2c_IsStepDone(const I2c_t I2c)
+{
+  return (*(gControlReg[I2c]) & (1 << TWINT)) != 0;
+}
+
 /******************************************************************************
 * Function : I2c_SendNack()
 *//**
@@ -417,6 +1855,37 @@ I2c_ReadDataReg(const I2c_t I2c)
 inline static void
 I2c_SendNack(const I2c_t I2c)
 {
-  *(gControlReg[I2c]) = 1 << TWEN | 1 << TWINT;
+  *(gControlReg[I2c]) = 1 << TWEN | 1 << TWINT | I2C_CMD_IE;
+  I2C_SIM_COMMAND(I2c);
+}
+
+/******************************************************************************
+* Function : I2c_SendAck()
+*//**
+* \b Description: Send ACK signal after receiving the next byte <br>
+* @param  I2c the id of the I2c peripheral
+* @return void
+******************************************************************************/
+inline static void
+I2c_SendAck(const I2c_t I2c)
+{
+  *(gControlReg[I2c]) = 1 << TWEN | 1 << TWINT | 1 << TWEA | I2C_CMD_IE;
+  I2C_SIM_COMMAND(I2c);
+}
+
+#if (I2C_WAIT_STRATEGY == I2C_WAIT_SLEEP || I2C_ASYNC_IRQ == 1) && \
+    !defined(I2C_SIM)
+/******************************************************************************
+* Function : TWI_vect()
+*//**
+* \b Description: The TWI interrupt service routine <br>
+* @return void
+******************************************************************************/
+void TWI_vect(void) __attribute__ ((signal, used, externally_visible));
+void
+TWI_vect(void)
+{
+  I2c_IrqHandler(I2C_0);
 }
+#endif
 /*****************************End of File ************************************/
@@ -11,9 +11,31 @@
 *****************************************************************************/
 #include "i2c_cfg.h"
 
+/*****************************************************************************
+* Definitions
+*****************************************************************************/
+#ifndef I2C_SIM
+#define I2C_TCNT1 (*((volatile uint16_t*) 0x4C)) /**< Timer1 counter */
+#define I2C_TCCR1A (*((volatile uint8_t*) 0x4F)) /**< Timer1 control A */
+#define I2C_TCCR1B (*((volatile uint8_t*) 0x4E)) /**< Timer1 control B */
+#define I2C_TIMSK (*((volatile uint8_t*) 0x59)) /**< timers interrupt mask */
+#define I2C_TIFR (*((volatile uint8_t*) 0x58)) /**< timers interrupt flags */
+#define I2C_CS10 0 /**< Timer1 clocked by the CPU clock */
+#define I2C_TOV1 2 /**< Timer1 overflow flag and interrupt enable */
+
+#define TIMER1_OVF_vect __vector_9 /**< Timer1 overflow interrupt vector */
+#endif
+
 /*****************************************************************************
 * Module Variable Definitions
 *****************************************************************************/
+#ifndef I2C_SIM
+/**
+ * The overflows of Timer1, the high half of I2c_GetTime.
+ */
+static volatile uint16_t gTimeHigh;
+#endif
+
 /**
 * The following array contains the configuration data for each
 * I2C Peripheral. Each row represents I2C peripheral. Each column is
@@ -24,7 +46,36 @@
 static const I2cConfig_t I2cConfig[] =
 {
   //TODO: configure your UART peripherals
-  { I2C_0, 100000 }
+  { I2C_0, 100000 },
+#ifdef I2C_SIM
+  { I2C_1, 100000 }
+#endif
+};
+
+/**
+* The following array contains the configuration data for each device
+* that runs at an SCL speed other than the speed of its I2C peripheral.
+* Each row represents a device. Each column is representing a member of the
+* I2cDeviceConfig_t structure. This table is read in by I2c_Init, where the
+* SCL register values of each device are computed once.
+*/
+static const I2cDeviceConfig_t I2cDeviceConfig[] =
+{
+  //TODO: configure your devices
+  { I2C_DEVICE_0, I2C_0, 0x50, 400000 },
+  { I2C_DEVICE_1, I2C_0, 0x52, 50000 }
+};
+
+/**
+* The following array contains the configuration data for each device
+* data-ready line. Each row represents a line. Each column is representing a
+* member of the I2cDrdyConfig_t structure. This table is read in by
+* I2cDrdy_Init, where the burst read of each line is prepared once.
+*/
+static const I2cDrdyConfig_t I2cDrdyConfig[] =
+{
+  //TODO: configure your data-ready lines
+  { I2C_DRDY_0, I2C_DEVICE_0, 0x28, 6 }
 };
 /******************************************************************************
 * Function Definitions
@@ -55,4 +106,108 @@ I2c_GetConfig(void)
   */
   return (const I2cConfig_t *) I2cConfig;
 }
+
+/******************************************************************************
+* Function : I2c_GetDeviceConfig()
+*//**
+* \b Description:
+* This function is used to get the device configuration handle of the I2C <br>
+* POST-CONDITION: A constant pointer to the first member of the device
+* configuration table will be returned. <br>
+* @return A pointer to the device configuration table.
+* @see I2c_Init
+ ******************************************************************************/
+extern const I2cDeviceConfig_t *
+I2c_GetDeviceConfig(void)
+{
+  return (const I2cDeviceConfig_t *) I2cDeviceConfig;
+}
+
+/******************************************************************************
+* Function : I2c_GetDrdyConfig()
+*//**
+* \b Description:
+* This function is used to get the data-ready configuration handle of the
+* I2C <br>
+* POST-CONDITION: A constant pointer to the first member of the data-ready
+* configuration table will be returned. <br>
+* @return A pointer to the data-ready configuration table.
+* @see I2cDrdy_Init
+ ******************************************************************************/
+extern const I2cDrdyConfig_t *
+I2c_GetDrdyConfig(void)
+{
+  return (const I2cDrdyConfig_t *) I2cDrdyConfig;
+}
+
+#ifndef I2C_SIM
+/******************************************************************************
+* Function : I2c_InitTime()
+*//**
+* \b Description:
+* Start Timer1 in normal mode without a prescaler, with its overflow
+* interrupt, as the time base of I2C_GET_CYCLES and I2C_DRDY_GET_TIME. <br>
+* POST-CONDITION: I2c_GetTime counts the CPU cycles from 0 <br>
+* @return void
+* @see I2c_GetTime
+ ******************************************************************************/
+extern void
+I2c_InitTime(void)
+{
+  I2C_CRITICAL_STATE State;
+
+  I2C_ENTER_CRITICAL(State);
+  I2C_TCCR1A = 0;
+  I2C_TCCR1B = 1 << I2C_CS10;
+  I2C_TCNT1 = 0;
+  I2C_TIFR = 1 << I2C_TOV1;
+  I2C_TIMSK |= 1 << I2C_TOV1;
+  gTimeHigh = 0;
+  I2C_EXIT_CRITICAL(State);
+}
+
+/******************************************************************************
+* Function : I2c_GetTime()
+*//**
+* \b Description:
+* Get the 32-bit time in CPU cycles: Timer1 widened by the count of its
+* overflows. An overflow which isn't counted yet by its interrupt, because
+* the interrupts are disabled, is taken from its flag. It can be called from
+* an interrupt, e.g. the data-ready edge. <br>
+* PRE-CONDITION: I2c_InitTime is called <br>
+* @return uint32_t the time
+ ******************************************************************************/
+extern uint32_t
+I2c_GetTime(void)
+{
+  I2C_CRITICAL_STATE State;
+  uint16_t High;
+  uint16_t Low;
+
+  I2C_ENTER_CRITICAL(State);
+  High = gTimeHigh;
+  Low = I2C_TCNT1;
+  //a low count read after the pending overflow belongs to the next period
+  if((I2C_TIFR & (1 << I2C_TOV1)) != 0 && Low < 0x8000)
+    {
+      High++;
+    }
+  I2C_EXIT_CRITICAL(State);
+
+  return (uint32_t)High << 16 | Low;
+}
+
+/******************************************************************************
+* Function : TIMER1_OVF_vect()
+*//**
+* \b Description: The Timer1 overflow interrupt service routine <br>
+* @return void
+******************************************************************************/
+void TIMER1_OVF_vect(void) __attribute__ ((signal, used, externally_visible));
+void
+TIMER1_OVF_vect(void)
+{
+  gTimeHigh++;
+}
+#endif
 /*****************************End of File ************************************/
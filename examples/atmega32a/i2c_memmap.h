@@ -9,6 +9,31 @@
 #ifndef I2C_MEMMAP_H
 #define I2C_MEMMAP_H
 
+#ifdef I2C_SIM
+/* The registers of the host simulation, see test/support/twi_sim.h */
+#include "twi_sim.h"
+
+#define TWBR    (&gTwiSim[I2C_0].Twbr)
+#define TWSR    (&gTwiSim[I2C_0].Twsr)
+#define TWAR    (&gTwiSim[I2C_0].Twar)
+#define TWDR    (&gTwiSim[I2C_0].Twdr)
+
+#define TWCR    (&gTwiSim[I2C_0].Twcr)
+
+/* the second bus */
+#define TWBR_1  (&gTwiSim[I2C_1].Twbr)
+#define TWSR_1  (&gTwiSim[I2C_1].Twsr)
+#define TWDR_1  (&gTwiSim[I2C_1].Twdr)
+#define TWCR_1  (&gTwiSim[I2C_1].Twcr)
+
+#define MCUCR   (&gTwiSimMcucr)
+
+#define I2C_SIM_COMMAND(__I2C__) TwiSim_Command(__I2C__)
+#define I2C_SIM_POLL(__I2C__) TwiSim_Poll(__I2C__)
+#define I2C_SIM_FAST_COMMAND(__I2C__) TwiSim_FastCommand(__I2C__)
+#define I2C_SIM_FAST_POLL(__I2C__) TwiSim_FastPoll(__I2C__)
+#define I2C_SIM_SLEEP(__I2C__) TwiSim_Sleep(__I2C__)
+#else
 #define TWBR    ((volatile uint8_t*) 0x20)
 #define TWSR    ((volatile uint8_t*) 0x21)
 #define TWAR    ((volatile uint8_t*) 0x22)
@@ -16,6 +41,18 @@
 
 #define TWCR    ((volatile uint8_t*) 0x56)
 
+#define MCUCR   ((volatile uint8_t*) 0x55)
+
+/* Called after a command is written to TWCR and on every poll of TWINT,
+ * by the wait loop and by the data phase fast path, and in place of the
+ * sleep of I2C_WAIT_SLEEP. They're only used by the host simulation. */
+#define I2C_SIM_COMMAND(__I2C__)
+#define I2C_SIM_POLL(__I2C__)
+#define I2C_SIM_FAST_COMMAND(__I2C__)
+#define I2C_SIM_FAST_POLL(__I2C__)
+#define I2C_SIM_SLEEP(__I2C__)
+#endif
+
 /* TWCR */
 #define TWINT   7
 #define TWEA    6
@@ -26,5 +63,14 @@
 /* bit 1 reserved */
 #define TWIE    0
 
+/* MCUCR */
+#define SE      7
+#define SM2     6
+#define SM1     5
+#define SM0     4
+
+/* Interrupt vectors */
+#define TWI_vect __vector_19
+
 #endif
 /*****************************End of File ************************************/
@@ -0,0 +1,146 @@
+/**
+ * @file main.cpp
+ * @author Mohamed Hassanin
+ * @brief Two device state machines sharing one bus with the coroutine layer
+ * (i2c_co.hpp), run on the host model of the TWI:
+ *
+ *   gcc -c -DI2C_SIM -Isrc -Itest/support examples/atmega32a/i2c.c \
+ *     examples/atmega32a/i2c_cfg.c test/support/twi_sim.c
+ *   g++ -std=c++20 -DI2C_SIM -Isrc -Itest/support \
+ *     examples/coroutines/main.cpp i2c.o i2c_cfg.o twi_sim.o -o co_demo
+ *
+ * @version 0.1
+ * @date 2021-05-24
+ */
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <cstdio>
+#include "i2c_co.hpp"
+#include "twi_sim.h"
+/******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define EEPROM_ADDRESS 0x50
+#define SENSOR_ADDRESS 0x1D
+
+#define SENSOR_STATUS 0x00 /**< bit 0 is set when a sample is ready, the
+                             host clears it */
+#define SENSOR_DATA 0x01 /**< the 6 bytes of a sample */
+#define SENSOR_CTRL 0x2A
+
+#define SAMPLES 3
+/******************************************************************************
+ * module variables definitions
+ ******************************************************************************/
+static uint8_t gSamples;
+
+static uint8_t gLogged;
+
+static uint8_t gErrors;
+/******************************************************************************
+ * functions definitions
+ ******************************************************************************/
+/**
+ * @brief Configure the sensor, then read a sample whenever it's ready.
+ */
+static I2cTask
+Sensor(I2cBus& Bus)
+{
+  static const uint8_t Config = 0x01;
+  static const uint8_t Clear = 0x00;
+  uint8_t Status;
+  uint8_t Sample[6];
+
+  if(co_await Bus.Write(SENSOR_ADDRESS, SENSOR_CTRL, &Config, 1) != 1)
+    {
+      gErrors++;
+      co_return;
+    }
+
+  while(gSamples < SAMPLES)
+    {
+      if(co_await Bus.Read(SENSOR_ADDRESS, SENSOR_STATUS, &Status, 1) != 1)
+        {
+          gErrors++;
+          co_return;
+        }
+      if((Status & 0x01) == 0) continue;
+
+      if(co_await Bus.Read(SENSOR_ADDRESS, SENSOR_DATA, Sample, 6) != 1 ||
+        co_await Bus.Write(SENSOR_ADDRESS, SENSOR_STATUS, &Clear, 1) != 1)
+        {
+          gErrors++;
+          co_return;
+        }
+      gSamples++;
+      std::printf("sample %u: %02X %02X %02X %02X %02X %02X\n", gSamples,
+                  Sample[0], Sample[1], Sample[2], Sample[3], Sample[4],
+                  Sample[5]);
+    }
+}
+
+/**
+ * @brief Write a page of the EEPROM and check it.
+ */
+static I2cTask
+Logger(I2cBus& Bus)
+{
+  uint8_t Page[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+  uint8_t Check[8];
+  uint8_t i;
+
+  if(co_await Bus.Write(EEPROM_ADDRESS, 0x40, Page, 8) != 1 ||
+    co_await Bus.Read(EEPROM_ADDRESS, 0x40, Check, 8) != 1)
+    {
+      gErrors++;
+      co_return;
+    }
+
+  for(i = 0; i < 8; i++)
+    {
+      gErrors += Check[i] != Page[i];
+    }
+  gLogged = 1;
+}
+
+int
+main(void)
+{
+  TwiSimDevice_t* SensorModel;
+  uint32_t Polls = 0;
+
+  TwiSim_Init();
+  TwiSim_AddDevice(I2C_0, EEPROM_ADDRESS);
+  SensorModel = TwiSim_AddDevice(I2C_0, SENSOR_ADDRESS);
+  I2c_Init(I2c_GetConfig());
+
+  I2cBus Bus(I2C_0);
+  I2cTask SensorTask = Sensor(Bus);
+  I2cTask LoggerTask = Logger(Bus);
+
+  if(!(SensorTask.IsValid() && LoggerTask.IsValid()))
+    {
+      std::printf("the frames don't fit in I2C_CO_FRAME_SIZE\n");
+      return 1;
+    }
+
+  while(!(SensorTask.IsDone() && LoggerTask.IsDone()) && Polls < 1000000ul)
+    {
+      Bus.Poll();
+      Polls++;
+
+      //the sensor has a new sample every 2000 polls
+      if(Polls % 2000 == 0)
+        {
+          SensorModel->Memory[SENSOR_STATUS] = 0x01;
+          SensorModel->Memory[SENSOR_DATA] = (uint8_t)Polls;
+        }
+    }
+
+  std::printf("%u samples, logged %u, %u errors, %lu cycles\n", gSamples,
+              gLogged, gErrors, (unsigned long)TwiSim_GetClock());
+
+  return (gSamples == SAMPLES && gLogged == 1 && gErrors == 0) ? 0 : 1;
+}
+/*****************************End of File ************************************/
@@ -0,0 +1,1410 @@
+/**
+ * @file i2c.c
+ * @author Mohamed Hassanin
+ * @brief I2C driver of the Linux userspace port. It runs the transaction
+ * programs on the character devices of the I2C adapters (/dev/i2c-N). The
+ * ops are packed into the messages of one I2C_RDWR ioctl per transaction,
+ * a message per start bit, so a transaction costs one system call whatever
+ * its number of bytes. The kernel sends a stop bit at the end of every
+ * ioctl, so the program is given to it at I2C_OP_STOP, or at its end if it
+ * received bytes the caller waits for.
+ * @version 0.1
+ * @date 2021-05-27
+ */
+/******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define I2C_GENERAL_CALL 0x00 /**< The general call (broadcast) address */
+
+/**
+ * @brief Give a step to the recorder set by I2c_SetRecorder. The calls are
+ * compiled out if I2C_RECORDER is 0.
+ */
+#define I2C_RECORD(__I2C__, __OP__, __STATUS__, __DATA__) \
+do { \
+  if(I2C_RECORDER == 1 && gRecorder != 0x0) \
+    { \
+      gRecorder((__I2C__), (__OP__), (__STATUS__), (__DATA__)); \
+    } \
+} while(0)
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <inttypes.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include "i2c.h"
+#include "i2c_linux.h"
+
+#if I2C_LINUX_MSGS > I2C_RDWR_IOCTL_MAX_MSGS
+#error "I2C_LINUX_MSGS must be at most I2C_RDWR_IOCTL_MAX_MSGS"
+#endif
+
+#if I2C_RX_BLOCK_MAX != I2C_SMBUS_BLOCK_MAX
+#error "I2C_RX_BLOCK_MAX must be the I2C_SMBUS_BLOCK_MAX of the kernel"
+#endif
+/******************************************************************************
+ * typedefs
+ ******************************************************************************/
+/**
+ * @brief The state of an I2C adapter and of the transaction being packed.
+ */
+typedef struct
+{
+  int Fd; /**< the character device of the adapter, -1 if it isn't open */
+  struct i2c_msg Msgs[I2C_LINUX_MSGS]; /**< the messages of the transaction */
+  uint8_t Buffer[I2C_LINUX_BUFFER_SIZE]; /**< the bytes of the write
+                                           messages */
+  uint16_t Used; /**< the bytes of the buffer taken */
+  uint8_t Count; /**< the number of the messages */
+  uint8_t Open; /**< 1 if the last message takes the next bytes, 0 after a
+                  start bit, a NACK or an ioctl */
+  uint8_t Address; /**< the address of the last message */
+  uint8_t HasRead; /**< 1 if a message receives bytes */
+  uint8_t HasBlock; /**< 1 if a message receives a block (I2C_M_RECV_LEN) */
+  uint8_t Owned; /**< 1 from a start bit until a stop bit */
+  const I2cTransfer_t* Transfer; /**< the running program and its operands */
+  uint8_t Status; /**< the result of the program, I2C_PENDING until it ends */
+  uint8_t Async; /**< 1 while an asynchronous transfer waits for I2c_Poll */
+  uint8_t Busy; /**< 1 while a transfer uses the adapter */
+}I2cAdapter_t;
+/******************************************************************************
+ * module variables definitions
+ ******************************************************************************/
+static I2cAdapter_t gAdapter[I2C_MAX];
+
+static I2cWaitStats_t gWaitStats[I2C_MAX];
+
+static I2cRecorder_t gRecorder;
+
+static I2cWriteObserver_t gWriteObserver;
+
+static int I2c_SysOpen(const char* Path, int Flags);
+static int I2c_SysIoctl(int Fd, unsigned long Request, void* Arg);
+
+/**
+ * The system calls of the kernel.
+ */
+static const I2cSys_t gLinuxSys =
+{
+  I2c_SysOpen, I2c_SysIoctl, close
+};
+
+static const I2cSys_t* gSys = &gLinuxSys;
+/******************************************************************************
+ * functions prototypes
+ ******************************************************************************/
+inline static uint8_t I2c_Lock(const I2c_t I2c);
+inline static void I2c_Unlock(const I2c_t I2c);
+static uint8_t I2c_Run(const I2c_t I2c, const I2cTransfer_t* const Transfer);
+static void I2c_AsyncEnd(const I2c_t I2c);
+static void I2c_NotifyWrite(const I2c_t I2c,
+                            const I2cTransfer_t* const Transfer);
+static uint8_t I2c_AddMsg(const I2c_t I2c, const uint16_t Flags);
+static uint8_t I2c_AddTx(const I2c_t I2c, const uint8_t* const Data,
+                         const uint8_t Length, const uint16_t Flags);
+static uint8_t I2c_AddRx(const I2c_t I2c, uint8_t* const Data,
+                         const uint8_t Length);
+static uint8_t I2c_AddBlock(const I2c_t I2c, uint8_t* const Data,
+                            const uint8_t Extra);
+static uint8_t I2c_Flush(const I2c_t I2c);
+static void I2c_Drop(const I2c_t I2c);
+static void I2c_RecordMsgs(const I2c_t I2c);
+static void I2c_ReceiveMsgs(const I2c_t I2c);
+/******************************************************************************
+ * functions definitions
+ ******************************************************************************/
+/******************************************************************************
+* Function : I2c_SetSys()
+*//**
+* \b Description:
+* Replace the system calls of the driver, e.g. with the ones of a fake
+* device to run it without the hardware. <br>
+* PRE-CONDITION: It's called before I2c_Init <br>
+* @param Sys the system calls, null to use the ones of the kernel. It must
+* stay valid while the driver is used.
+* @return void
+ ******************************************************************************/
+extern void
+I2c_SetSys(const I2cSys_t* const Sys)
+{
+  gSys = Sys != 0x0 ? Sys : &gLinuxSys;
+}
+
+/******************************************************************************
+* Function : I2c_Init()
+*//**
+* \b Description:
+* initialize the I2C adapters: open their character devices and check that
+* they transfer plain I2C messages. An adapter which fails stays closed and
+* its transfers return 2. <br>
+* PRE-CONDITION: The user can read and write the character devices <br>
+* POST-CONDITION: I2C driver is set up <br>
+* @return void
+ ******************************************************************************/
+extern void
+I2c_Init(const I2cConfig_t * const Config)
+{
+  if(!(Config != 0x0))
+    {
+      //TODO: handle this error
+      return;
+    }
+
+  I2cAdapter_t* Adapter;
+  unsigned long Funcs;
+  int res;
+  uint8_t i;
+
+  for(i = 0; i < I2C_MAX; i++)
+    {
+      Adapter = &gAdapter[Config[i].I2c];
+      //the adapters are zeroed before the first call, 0 is the standard input
+      if(Adapter->Fd > 0)
+        {
+          gSys->Close(Adapter->Fd);
+        }
+
+      Adapter->Fd = -1;
+      Adapter->Count = 0;
+      Adapter->Used = 0;
+      Adapter->Open = 0;
+      Adapter->HasRead = 0;
+      Adapter->HasBlock = 0;
+      Adapter->Owned = 0;
+      Adapter->Async = 0;
+      Adapter->Busy = 0;
+      Adapter->Status = 1;
+
+      res = gSys->Open(Config[i].Path, O_RDWR);
+      if(res < 0)
+        {
+          //TODO: handle this error
+          continue;
+        }
+      Adapter->Fd = res;
+
+      res = gSys->Ioctl(Adapter->Fd, I2C_FUNCS, &Funcs);
+      if(res < 0 || (Funcs & I2C_FUNC_I2C) == 0)
+        {
+          //TODO: handle this error
+          gSys->Close(Adapter->Fd);
+          Adapter->Fd = -1;
+        }
+    }
+}
+
+/******************************************************************************
+* Function : I2c_Transfer()
+*//**
+* \b Description: Run a transaction program using I2C. The ops are packed
+* into the messages of one I2C_RDWR ioctl, given to the kernel at the stop
+* bit, or at the end of the program if it receives bytes. A program which
+* ends without a stop bit and without receiving (e.g. I2c_Start and
+* I2c_Write) is kept for the next one, so its errors are returned by the
+* program which gives it to the kernel. If the ioctl fails, the bus is
+* released and the error is mapped from errno: ENXIO (the address isn't
+* acknowledged) is 3, a lost arbitration or a timeout is 2, any other
+* error is 5 if the transaction receives and 4 otherwise. <br>
+* POST-CONDITION: The program is run <br>
+* @param I2c the id of the I2C adapter
+* @param Transfer the program and its operands
+* @return uint8_t 1 the operations is done successfully
+*                 2 start bit error, or the adapter isn't open
+*                 3 address error
+*                 4 data sending error
+*                 5 data receiving error
+*                 6 the adapter is busy
+*                 7 invalid byte count of I2C_OP_RX_BLOCK
+*                 0 the program is invalid or it doesn't fit in
+*                   I2C_LINUX_MSGS and I2C_LINUX_BUFFER_SIZE
+ ******************************************************************************/
+extern uint8_t
+I2c_Transfer(const I2c_t I2c, const I2cTransfer_t* const Transfer)
+{
+  if(!(I2c < I2C_MAX && Transfer != 0x0 && Transfer->Program != 0x0))
+    {
+      return 0;
+    }
+
+  uint8_t res;
+
+  res = I2c_Lock(I2c);
+  if(res == 0) return 6;
+
+  res = I2c_Run(I2c, Transfer);
+
+  I2c_Unlock(I2c);
+
+  return res;
+}
+
+/******************************************************************************
+* Function : I2c_TransferAsync()
+*//**
+* \b Description: Queue a transaction program for I2c_Poll. The ioctl
+* blocks, so the program is run by the next call of I2c_Poll, which blocks
+* its caller for the transaction, then the callback of the transfer is
+* called. <br>
+* POST-CONDITION: The result of I2c_GetResult is I2C_PENDING until the
+* program ends <br>
+* @param I2c the id of the I2C adapter
+* @param Transfer the program and its operands. It must stay valid until
+* the program ends.
+* @return uint8_t 1 the program is queued
+*                 6 the adapter is busy
+ ******************************************************************************/
+extern uint8_t
+I2c_TransferAsync(const I2c_t I2c, const I2cTransfer_t* const Transfer)
+{
+  if(!(I2c < I2C_MAX && Transfer != 0x0 && Transfer->Program != 0x0))
+    {
+      return 0;
+    }
+
+  uint8_t res;
+
+  res = I2c_Lock(I2c);
+  if(res == 0) return 6;
+
+  gAdapter[I2c].Transfer = Transfer;
+  gAdapter[I2c].Status = I2C_PENDING;
+  gAdapter[I2c].Async = 1;
+
+  return 1;
+}
+
+/******************************************************************************
+* Function : I2c_Poll()
+*//**
+* \b Description: Run the asynchronous transfers queued on all the I2C
+* adapters. It's meant to be called from the main loop. <br>
+* @return void
+ ******************************************************************************/
+extern void
+I2c_Poll(void)
+{
+  uint8_t i;
+
+  for(i = 0; i < I2C_MAX; i++)
+    {
+      if(gAdapter[i].Async == 0) continue;
+
+      I2c_Run(i, gAdapter[i].Transfer);
+      I2c_AsyncEnd(i);
+    }
+}
+
+/******************************************************************************
+* Function : I2c_GetResult()
+*//**
+* \b Description: Get the result of the last transfer of an I2C
+* adapter. <br>
+* @param I2c the id of the I2C adapter
+* @return uint8_t I2C_PENDING while an asynchronous transfer runs, the
+* result of the transfer otherwise, see I2c_Transfer.
+ ******************************************************************************/
+extern uint8_t
+I2c_GetResult(const I2c_t I2c)
+{
+  if(!(I2c < I2C_MAX)) return 0;
+
+  return gAdapter[I2c].Status;
+}
+
+/******************************************************************************
+* Function : I2c_SendByte()
+*//**
+* \b Description: Write one byte into a device register using I2C <br>
+* POST-CONDITION: A byte is saved inside the device register <br>
+* @param I2c the id of the I2C adapter
+* @param Address the address of the register to write using I2C adapter
+* @param Data the byte to write
+* @return uint8_t 1 the operations is done successfully
+*                 2 start bit error
+*                 3 address error
+*                 4 data sending error
+*                 6 the adapter is busy
+ ******************************************************************************/
+extern uint8_t
+I2c_SendByte(const I2c_t I2c,
+             const uint8_t Address,
+             const uint8_t Register,
+             const uint8_t Data)
+{
+  static const uint8_t Program[] =
+  {
+    I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_REG, I2C_OP_TX, 1, I2C_OP_STOP,
+    I2C_OP_END
+  };
+  I2cTransfer_t Transfer = { Program, Address, Register, &Data, 0x0, 0x0, 0x0 };
+
+  return I2c_Transfer(I2c, &Transfer);
+}
+
+/******************************************************************************
+* Function : I2c_ReceiveByte()
+*//**
+* \b Description: Read one byte from a device register using I2C <br>
+* POST-CONDITION: A byte is received from the device register <br>
+* @param I2c the id of the I2C adapter
+* @param Address the address of the register to read using I2C adapter
+* @param Data a pointer to receive the byte in
+* @return uint8_t 1 the operations is done successfully
+*                 2 start bit error
+*                 3 address error
+*                 4 register sending error
+*                 5 data receiving error
+*                 6 the adapter is busy
+ ******************************************************************************/
+extern uint8_t
+I2c_ReceiveByte(const I2c_t I2c,
+             const uint8_t Address,
+             const uint8_t Register,
+             uint8_t* const Data)
+{
+  if(!(Data != 0x0)) return 0;
+
+  static const uint8_t Program[] =
+  {
+    I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_REG, I2C_OP_START, I2C_OP_ADDR_R,
+    I2C_OP_RX_NACK, I2C_OP_STOP, I2C_OP_END
+  };
+  I2cTransfer_t Transfer = { Program, Address, Register, 0x0, Data, 0x0, 0x0 };
+
+  return I2c_Transfer(I2c, &Transfer);
+}
+
+/******************************************************************************
+* Function : I2c_SendBytes()
+*//**
+* \b Description: Write successive bytes into device registers using I2C
+* starting from a register. The device is expected to increment its
+* register pointer after each byte. <br>
+* POST-CONDITION: The bytes are saved inside the device registers <br>
+* @param I2c the id of the I2C adapter
+* @param Address the address of the device
+* @param Register the first register to write
+* @param Data the bytes to write
+* @param Length the number of the bytes to write
+* @return uint8_t 1 the operations is done successfully
+*                 2 start bit error
+*                 3 address error
+*                 4 data sending error
+*                 6 the adapter is busy
+ ******************************************************************************/
+extern uint8_t
+I2c_SendBytes(const I2c_t I2c,
+              const uint8_t Address,
+              const uint8_t Register,
+              const uint8_t* const Data,
+              const uint8_t Length)
+{
+  if(!(Data != 0x0 || Length == 0)) return 0;
+
+  const uint8_t Program[] =
+  {
+    I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_REG, I2C_OP_TX, Length, I2C_OP_STOP,
+    I2C_OP_END
+  };
+  I2cTransfer_t Transfer = { Program, Address, Register, Data, 0x0, 0x0, 0x0 };
+
+  return I2c_Transfer(I2c, &Transfer);
+}
+
+/******************************************************************************
+* Function : I2c_ReceiveBytes()
+*//**
+* \b Description: Read successive bytes from device registers using I2C
+* starting from a register. The device is expected to increment its
+* register pointer after each byte. <br>
+* POST-CONDITION: The bytes are received from the device registers <br>
+* @param I2c the id of the I2C adapter
+* @param Address the address of the device
+* @param Register the first register to read
+* @param Data a pointer to receive the bytes in
+* @param Length the number of the bytes to read. It must be at least 1.
+* @return uint8_t 1 the operations is done successfully
+*                 2 start bit error
+*                 3 address error
+*                 4 register sending error
+*                 5 data receiving error
+*                 6 the adapter is busy
+ ******************************************************************************/
+extern uint8_t
+I2c_ReceiveBytes(const I2c_t I2c,
+                 const uint8_t Address,
+                 const uint8_t Register,
+                 uint8_t* const Data,
+                 const uint8_t Length)
+{
+  if(!(Data != 0x0 && Length != 0)) return 0;
+
+  //acknowledge all the bytes except the last one
+  const uint8_t Program[] =
+  {
+    I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_REG, I2C_OP_START, I2C_OP_ADDR_R,
+    I2C_OP_RX_ACK, Length - 1, I2C_OP_RX_NACK, I2C_OP_STOP, I2C_OP_END
+  };
+  I2cTransfer_t Transfer = { Program, Address, Register, 0x0, Data, 0x0, 0x0 };
+
+  return I2c_Transfer(I2c, &Transfer);
+}
+
+/******************************************************************************
+* Function : I2c_UpdateBits()
+*//**
+* \b Description: Update a bit field of a device register using I2C. The
+* register is read by one ioctl, then written by another one. The kernel
+* sends a stop bit at the end of the read, so the bus is released between
+* the read and the write. The write is skipped if the field already has the
+* value. <br>
+* POST-CONDITION: The bits of the mask in the device register equal the
+* ones of the value <br>
+* @param I2c the id of the I2C adapter
+* @param Address the address of the device
+* @param Register the register to update
+* @param Mask the bits to update
+* @param Value the new value of the bits
+* @return uint8_t 1 the operations is done successfully
+*                 2 start bit error
+*                 3 address error
+*                 4 register or data sending error
+*                 5 data receiving error
+*                 6 the adapter is busy
+ ******************************************************************************/
+extern uint8_t
+I2c_UpdateBits(const I2c_t I2c,
+               const uint8_t Address,
+               const uint8_t Register,
+               const uint8_t Mask,
+               const uint8_t Value)
+{
+  if(!(I2c < I2C_MAX)) return 0;
+
+  static const uint8_t ReadProgram[] =
+  {
+    I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_REG, I2C_OP_START, I2C_OP_ADDR_R,
+    I2C_OP_RX_NACK, I2C_OP_END
+  };
+  static const uint8_t WriteProgram[] =
+  {
+    I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_REG, I2C_OP_TX, 1, I2C_OP_STOP,
+    I2C_OP_END
+  };
+  static const uint8_t StopProgram[] =
+  {
+    I2C_OP_STOP, I2C_OP_END
+  };
+  uint8_t OldValue;
+  uint8_t NewValue;
+  I2cTransfer_t Transfer = { ReadProgram, Address, Register, &NewValue,
+                             &OldValue, 0x0, 0x0 };
+  uint8_t res;
+
+  res = I2c_Lock(I2c);
+  if(res == 0) return 6;
+
+  res = I2c_Run(I2c, &Transfer);
+  if(res == 1)
+    {
+      NewValue = (OldValue & ~Mask) | (Value & Mask);
+      Transfer.Program = NewValue != OldValue ? WriteProgram : StopProgram;
+      res = I2c_Run(I2c, &Transfer);
+    }
+
+  I2c_Unlock(I2c);
+
+  return res;
+}
+
+/******************************************************************************
+* Function : I2c_GroupUpdate()
+*//**
+* \b Description: Preload a register of several devices then latch them
+* together with one general call command. All the writes are chained using
+* repeated starts in one ioctl. <br>
+* PRE-CONDITION: The devices respond to the general call address <br>
+* POST-CONDITION: All the devices applied their new values at the same time
+* <br>
+* @param I2c the id of the I2C adapter
+* @param Addresses the addresses of the devices
+* @param Register the register to preload in every device
+* @param Data the byte to preload in each device, one per address
+* @param Count the number of the devices. If it's 0, only the general call
+* command is sent.
+* @param Command the general call command which latches the devices
+* @return uint8_t 1 the operations is done successfully
+*                 2 start bit error
+*                 3 address error, or no device acknowledged the general
+*                   call address
+*                 4 data sending error
+*                 6 the adapter is busy
+ ******************************************************************************/
+extern uint8_t
+I2c_GroupUpdate(const I2c_t I2c,
+                const uint8_t* const Addresses,
+                const uint8_t Register,
+                const uint8_t* const Data,
+                const uint8_t Count,
+                const uint8_t Command)
+{
+  if(!(I2c < I2C_MAX &&
+      ((Addresses != 0x0 && Data != 0x0) || Count == 0))) return 0;
+
+  static const uint8_t PreloadProgram[] =
+  {
+    I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_REG, I2C_OP_TX, 1, I2C_OP_END
+  };
+  static const uint8_t LatchProgram[] =
+  {
+    I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_TX_GC, 1, I2C_OP_STOP, I2C_OP_END
+  };
+  I2cTransfer_t Transfer = { PreloadProgram, 0, Register, 0x0, 0x0, 0x0, 0x0 };
+  uint8_t res;
+  uint8_t i;
+
+  res = I2c_Lock(I2c);
+  if(res == 0) return 6;
+
+  for(i = 0; i < Count && res == 1; i++)
+    {
+      Transfer.Address = Addresses[i];
+      Transfer.TxData = &Data[i];
+      res = I2c_Run(I2c, &Transfer);
+    }
+
+  if(res == 1)
+    {
+      Transfer.Program = LatchProgram;
+      Transfer.Address = I2C_GENERAL_CALL;
+      Transfer.TxData = &Command;
+      res = I2c_Run(I2c, &Transfer);
+    }
+
+  I2c_Unlock(I2c);
+
+  return res;
+}
+
+/******************************************************************************
+* Function : I2c_Start()
+*//**
+* \b Description: Send a start (or a repeated start) bit followed by the
+* address of a device. It's used with I2c_Write, I2c_Read and I2c_Stop to
+* build the transactions not covered by the other functions. The message
+* is given to the kernel with the next ones by I2c_Stop or I2c_Read, so an
+* address error is returned by I2c_Read, or by I2c_GetResult after
+* I2c_Stop. <br>
+* POST-CONDITION: The device is addressed <br>
+* @param I2c the id of the I2C adapter
+* @param Address the address of the device
+* @param Read 1 to address the device for reading, 0 for writing
+* @return uint8_t 1 the operations is done successfully
+*                 2 start bit error
+*                 3 address error
+*                 6 the adapter is busy
+ ******************************************************************************/
+extern uint8_t
+I2c_Start(const I2c_t I2c, const uint8_t Address, const uint8_t Read)
+{
+  static const uint8_t WriteProgram[] =
+  {
+    I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_END
+  };
+  static const uint8_t ReadProgram[] =
+  {
+    I2C_OP_START, I2C_OP_ADDR_R, I2C_OP_END
+  };
+  I2cTransfer_t Transfer = { Read != 0 ? ReadProgram : WriteProgram, Address,
+                             0, 0x0, 0x0, 0x0, 0x0 };
+
+  return I2c_Transfer(I2c, &Transfer);
+}
+
+/******************************************************************************
+* Function : I2c_Write()
+*//**
+* \b Description: Send one byte to the addressed device. It's added to the
+* message of I2c_Start, a data error is returned like the errors of
+* I2c_Start. <br>
+* PRE-CONDITION: The device is addressed for writing by I2c_Start <br>
+* @param I2c the id of the I2C adapter
+* @param Data the byte to send
+* @return uint8_t 1 the operations is done successfully
+*                 4 data sending error
+*                 6 the adapter is busy
+ ******************************************************************************/
+extern uint8_t
+I2c_Write(const I2c_t I2c, const uint8_t Data)
+{
+  static const uint8_t Program[] =
+  {
+    I2C_OP_TX, 1, I2C_OP_END
+  };
+  I2cTransfer_t Transfer = { Program, 0, 0, &Data, 0x0, 0x0, 0x0 };
+
+  return I2c_Transfer(I2c, &Transfer);
+}
+
+/******************************************************************************
+* Function : I2c_Read()
+*//**
+* \b Description: Receive one byte from the addressed device. The caller
+* waits for the byte, so the transaction up to it is given to the kernel
+* and ended by a stop bit. The next byte is read by a new transaction, the
+* device must keep its register pointer between them. <br>
+* PRE-CONDITION: The device is addressed for reading by I2c_Start <br>
+* @param I2c the id of the I2C adapter
+* @param Ack 1 to acknowledge the byte (more bytes follow), 0 to send NACK
+* (the last byte)
+* @param Data a pointer to receive the byte in
+* @return uint8_t 1 the operations is done successfully
+*                 5 data receiving error
+*                 6 the adapter is busy
+ ******************************************************************************/
+extern uint8_t
+I2c_Read(const I2c_t I2c, const uint8_t Ack, uint8_t* const Data)
+{
+  if(!(Data != 0x0)) return 0;
+
+  static const uint8_t AckProgram[] =
+  {
+    I2C_OP_RX_ACK, 1, I2C_OP_END
+  };
+  static const uint8_t NackProgram[] =
+  {
+    I2C_OP_RX_NACK, I2C_OP_END
+  };
+  I2cTransfer_t Transfer = { Ack != 0 ? AckProgram : NackProgram, 0, 0, 0x0,
+                             Data, 0x0, 0x0 };
+
+  return I2c_Transfer(I2c, &Transfer);
+}
+
+/******************************************************************************
+* Function : I2c_Stop()
+*//**
+* \b Description: Send a stop bit and release the bus. The messages since
+* the last ioctl are given to the kernel, the result is kept for
+* I2c_GetResult. <br>
+* @param I2c the id of the I2C adapter
+* @return void
+ ******************************************************************************/
+extern void
+I2c_Stop(const I2c_t I2c)
+{
+  static const uint8_t Program[] =
+  {
+    I2C_OP_STOP, I2C_OP_END
+  };
+  I2cTransfer_t Transfer = { Program, 0, 0, 0x0, 0x0, 0x0, 0x0 };
+
+  I2c_Transfer(I2c, &Transfer);
+}
+
+/******************************************************************************
+* Function : I2c_Lock()
+*//**
+* \b Description: Utility function to take the adapter for a transfer.
+* It prevents a callback from starting a transfer in the middle of another
+* one.
+* <br>
+* @param  I2c the id of the I2c adapter
+* @return uint8_t 1 if the adapter is taken, 0 if it's busy
+******************************************************************************/
+inline static uint8_t
+I2c_Lock(const I2c_t I2c)
+{
+  I2C_CRITICAL_STATE State;
+  uint8_t Locked = 0;
+
+  I2C_ENTER_CRITICAL(State);
+  if(gAdapter[I2c].Busy == 0)
+    {
+      gAdapter[I2c].Busy = 1;
+      Locked = 1;
+    }
+  I2C_EXIT_CRITICAL(State);
+
+  return Locked;
+}
+
+/******************************************************************************
+* Function : I2c_Unlock()
+*//**
+* \b Description: Utility function to release the adapter after a
+* transfer. <br>
+* @param  I2c the id of the I2c adapter
+* @return void
+******************************************************************************/
+inline static void
+I2c_Unlock(const I2c_t I2c)
+{
+  gAdapter[I2c].Busy = 0;
+}
+
+/******************************************************************************
+* Function : I2c_Run()
+*//**
+* \b Description: Utility function to pack the ops of a program into the
+* messages of the transaction, and to give them to the kernel at the stop
+* bit and at the end of a program which receives. <br>
+* PRE-CONDITION: The adapter is taken by I2c_Lock <br>
+* @param  I2c the id of the I2c adapter
+* @param  Transfer the program and its operands
+* @return uint8_t the result of the program, see I2c_Transfer
+******************************************************************************/
+static uint8_t
+I2c_Run(const I2c_t I2c, const I2cTransfer_t* const Transfer)
+{
+  I2cAdapter_t* const Adapter = &gAdapter[I2c];
+  const uint8_t* Pc = Transfer->Program;
+  const uint8_t* Tx = Transfer->TxData;
+  //the bytes of a Receive function are received in the buffer of the adapter
+  uint8_t* Rx = Transfer->Receive != 0x0 ? 0x0 : Transfer->RxData;
+  uint8_t Op;
+  uint8_t Count;
+  uint8_t res = 1;
+
+  Adapter->Transfer = Transfer;
+
+  if(Adapter->Fd < 0)
+    {
+      res = 2;
+    }
+
+  while(res == 1 && *Pc != I2C_OP_END)
+    {
+      Op = *Pc;
+      Pc++;
+
+      Count = 1;
+      if(Op == I2C_OP_TX || Op == I2C_OP_TX_GC || Op == I2C_OP_RX_ACK ||
+         Op == I2C_OP_RX_BLOCK)
+        {
+          Count = *Pc;
+          Pc++;
+        }
+
+      switch(Op)
+      {
+        case I2C_OP_START:
+          Adapter->Owned = 1;
+          Adapter->Open = 0;
+        break;
+
+        case I2C_OP_ADDR_W:
+        case I2C_OP_ADDR_R:
+          Adapter->Address = Transfer->Address;
+          res = I2c_AddMsg(I2c, Op == I2C_OP_ADDR_R ? I2C_M_RD : 0);
+        break;
+
+        case I2C_OP_REG:
+          res = I2c_AddTx(I2c, &Transfer->Register, 1, 0);
+        break;
+
+        case I2C_OP_TX:
+        case I2C_OP_TX_GC:
+          //the ACK of a general call only tells that a device acknowledged
+          res = I2c_AddTx(I2c, Tx, Count,
+                          Op == I2C_OP_TX_GC ? I2C_M_IGNORE_NAK : 0);
+          Tx += Count;
+        break;
+
+        case I2C_OP_RX_ACK:
+        case I2C_OP_RX_NACK:
+          res = I2c_AddRx(I2c, Rx, Count);
+          if(Rx != 0x0)
+            {
+              Rx += Count;
+            }
+          //the kernel sends NACK after the last byte of a message
+          if(Op == I2C_OP_RX_NACK)
+            {
+              Adapter->Open = 0;
+            }
+        break;
+
+        case I2C_OP_RX_BLOCK:
+          //the length of the block is only known after the ioctl, so it
+          //ends the reads of the program
+          res = I2c_AddBlock(I2c, Rx, Count);
+          Rx = 0x0;
+        break;
+
+        case I2C_OP_STOP:
+          res = I2c_Flush(I2c);
+          Adapter->Owned = 0;
+        break;
+
+        default:
+          res = 0;
+        break;
+      }
+    }
+
+  //the caller waits for the received bytes
+  if(res == 1 && Adapter->HasRead != 0)
+    {
+      res = I2c_Flush(I2c);
+    }
+
+  if(res != 1)
+    {
+      I2c_Drop(I2c);
+    }
+
+  Adapter->Status = res;
+  I2c_NotifyWrite(I2c, Transfer);
+
+  return res;
+}
+
+/******************************************************************************
+* Function : I2c_AsyncEnd()
+*//**
+* \b Description: Utility function to release the adapter after an
+* asynchronous transfer, then notify the client. The callback can start the
+* next transfer. <br>
+* @param  I2c the id of the I2c adapter
+* @return void
+******************************************************************************/
+static void
+I2c_AsyncEnd(const I2c_t I2c)
+{
+  const I2cTransfer_t* const Transfer = gAdapter[I2c].Transfer;
+  const uint8_t Status = gAdapter[I2c].Status;
+
+  gAdapter[I2c].Async = 0;
+  I2c_Unlock(I2c);
+
+  if(Transfer->Callback != 0x0)
+    {
+      Transfer->Callback(I2c, Transfer, Status);
+    }
+}
+
+/******************************************************************************
+* Function : I2c_NotifyWrite()
+*//**
+* \b Description: Utility function to give the registers written by an
+* ended program to the write observer. Only the programs which send a
+* register then bytes are written ones. They are given even if they failed,
+* because the device may have taken some bytes. <br>
+* @param  I2c the id of the I2c adapter
+* @param  Transfer the program and its operands
+* @return void
+******************************************************************************/
+static void
+I2c_NotifyWrite(const I2c_t I2c, const I2cTransfer_t* const Transfer)
+{
+  const uint8_t* Pc = Transfer->Program;
+  uint8_t HasRegister = 0;
+  uint16_t Length = 0;
+  uint8_t Op;
+
+  if(gWriteObserver == 0x0) return;
+
+  for(Op = *Pc; Op != I2C_OP_END && Op < I2C_OP_MAX; Op = *Pc)
+    {
+      Pc++;
+      if(Op == I2C_OP_REG)
+        {
+          HasRegister = 1;
+        }
+      else if(Op == I2C_OP_TX)
+        {
+          Length += *Pc;
+        }
+
+      if(Op == I2C_OP_TX || Op == I2C_OP_TX_GC || Op == I2C_OP_RX_ACK ||
+         Op == I2C_OP_RX_BLOCK)
+        {
+          Pc++;
+        }
+    }
+
+  if(HasRegister != 0 && Length != 0)
+    {
+      gWriteObserver(I2c, Transfer->Address, Transfer->Register, Length);
+    }
+}
+
+/******************************************************************************
+* Function : I2c_AddMsg()
+*//**
+* \b Description: Utility function to start a message of the transaction,
+* to the address of the last address op. <br>
+* @param  I2c the id of the I2c adapter
+* @param  Flags I2C_M_RD for a read message, 0 for a write one
+* @return uint8_t 1 if the message is added, 0 if there are I2C_LINUX_MSGS
+* messages already.
+******************************************************************************/
+static uint8_t
+I2c_AddMsg(const I2c_t I2c, const uint16_t Flags)
+{
+  I2cAdapter_t* const Adapter = &gAdapter[I2c];
+  struct i2c_msg* Msg;
+
+  if(!(Adapter->Count < I2C_LINUX_MSGS)) return 0;
+
+  Msg = &Adapter->Msgs[Adapter->Count];
+  Msg->addr = Adapter->Address;
+  Msg->flags = Flags;
+  Msg->len = 0;
+  Msg->buf = (Flags & I2C_M_RD) != 0 ? 0x0 : &Adapter->Buffer[Adapter->Used];
+
+  Adapter->Count++;
+  Adapter->Open = 1;
+
+  return 1;
+}
+
+/******************************************************************************
+* Function : I2c_AddTx()
+*//**
+* \b Description: Utility function to copy bytes to send into the last
+* message. A new write message is started if the last one reads or is
+* closed, e.g. the bytes of I2c_Write after a read. <br>
+* @param  I2c the id of the I2c adapter
+* @param  Data the bytes to send
+* @param  Length the number of the bytes
+* @param  Flags the flags to add to the message, e.g. I2C_M_IGNORE_NAK
+* @return uint8_t 1 if the bytes are added, 0 if they don't fit.
+******************************************************************************/
+static uint8_t
+I2c_AddTx(const I2c_t I2c, const uint8_t* const Data,
+          const uint8_t Length, const uint16_t Flags)
+{
+  I2cAdapter_t* const Adapter = &gAdapter[I2c];
+  struct i2c_msg* Msg;
+  uint8_t i;
+
+  if(Length == 0) return 1;
+
+  if(!(Adapter->Open != 0 &&
+       (Adapter->Msgs[Adapter->Count - 1].flags & I2C_M_RD) == 0))
+    {
+      if(I2c_AddMsg(I2c, 0) == 0) return 0;
+    }
+  Msg = &Adapter->Msgs[Adapter->Count - 1];
+
+  if(!(Adapter->Used + Length <= I2C_LINUX_BUFFER_SIZE)) return 0;
+
+  //the bytes of the last write message end the buffer
+  for(i = 0; i < Length; i++)
+    {
+      Adapter->Buffer[Adapter->Used + i] = Data[i];
+    }
+  Adapter->Used += Length;
+  Msg->len += Length;
+  Msg->flags |= Flags;
+
+  return 1;
+}
+
+/******************************************************************************
+* Function : I2c_AddRx()
+*//**
+* \b Description: Utility function to receive bytes by the last message.
+* The message reads straight into the buffer of the program, or into the
+* buffer of the adapter for the Receive function of the transfer. A new
+* read message is started if the last one writes or is closed. <br>
+* @param  I2c the id of the I2c adapter
+* @param  Data where to save the bytes, 0x0 for the Receive function
+* @param  Length the number of the bytes
+* @return uint8_t 1 if the bytes are added, 0 if there are too many
+* messages or they don't fit.
+******************************************************************************/
+static uint8_t
+I2c_AddRx(const I2c_t I2c, uint8_t* const Data, const uint8_t Length)
+{
+  I2cAdapter_t* const Adapter = &gAdapter[I2c];
+  uint8_t* Buffer = Data;
+  struct i2c_msg* Msg;
+
+  if(Length == 0) return 1;
+  if(!(Data != 0x0 || Adapter->Transfer->Receive != 0x0)) return 0;
+
+  if(!(Adapter->Open != 0 &&
+       (Adapter->Msgs[Adapter->Count - 1].flags & I2C_M_RD) != 0))
+    {
+      if(I2c_AddMsg(I2c, I2C_M_RD) == 0) return 0;
+    }
+  Msg = &Adapter->Msgs[Adapter->Count - 1];
+
+  //the bytes follow the ones the message already has, see I2c_ReceiveMsgs
+  if(Buffer == 0x0)
+    {
+      if(!(Adapter->Used + Length <= I2C_LINUX_BUFFER_SIZE)) return 0;
+      Buffer = &Adapter->Buffer[Adapter->Used];
+      Adapter->Used += Length;
+    }
+
+  //the bytes of a program are received one after the other
+  if(Msg->len == 0)
+    {
+      Msg->buf = Buffer;
+    }
+  Msg->len += Length;
+  Adapter->HasRead = 1;
+
+  return 1;
+}
+
+/******************************************************************************
+* Function : I2c_AddBlock()
+*//**
+* \b Description: Utility function to receive a block by the last message,
+* which must be a read message without bytes yet (I2C_OP_RX_BLOCK right
+* after I2C_OP_ADDR_R). The adapter receives the byte count, then the
+* bytes it counts and the extra ones (I2C_M_RECV_LEN). Like i2c-dev
+* expects, the first byte of the buffer holds the bytes of the message
+* before the count is known, and the message has the room of the largest
+* block. <br>
+* @param  I2c the id of the I2c adapter
+* @param  Data where to save the count and the bytes, 1 + I2C_RX_BLOCK_MAX
+* + Extra bytes, 0x0 for the Receive function
+* @param  Extra the bytes received after the block, e.g. 1 for a PEC
+* @return uint8_t 1 if the block is added, 0 if the program is invalid or
+* the block doesn't fit.
+******************************************************************************/
+static uint8_t
+I2c_AddBlock(const I2c_t I2c, uint8_t* const Data, const uint8_t Extra)
+{
+  I2cAdapter_t* const Adapter = &gAdapter[I2c];
+  uint8_t* Buffer = Data;
+  struct i2c_msg* Msg;
+
+  if(!(Data != 0x0 || Adapter->Transfer->Receive != 0x0)) return 0;
+  if(!(Extra <= 255 - I2C_RX_BLOCK_MAX)) return 0;
+  if(!(Adapter->Open != 0)) return 0;
+
+  Msg = &Adapter->Msgs[Adapter->Count - 1];
+  if(!((Msg->flags & I2C_M_RD) != 0 && Msg->len == 0)) return 0;
+
+  if(Buffer == 0x0)
+    {
+      if(!(Adapter->Used + 1 + I2C_RX_BLOCK_MAX + Extra <=
+           I2C_LINUX_BUFFER_SIZE))
+        {
+          return 0;
+        }
+      Buffer = &Adapter->Buffer[Adapter->Used];
+      Adapter->Used += 1 + I2C_RX_BLOCK_MAX + Extra;
+    }
+
+  Buffer[0] = 1 + Extra;
+  Msg->buf = Buffer;
+  Msg->len = 1 + I2C_RX_BLOCK_MAX + Extra;
+  Msg->flags |= I2C_M_RECV_LEN;
+  Adapter->HasRead = 1;
+  Adapter->HasBlock = 1;
+  //the kernel sends NACK after the last byte of the block
+  Adapter->Open = 0;
+
+  return 1;
+}
+
+/******************************************************************************
+* Function : I2c_Flush()
+*//**
+* \b Description: Utility function to give the messages of the transaction
+* to the kernel with one I2C_RDWR ioctl. The kernel chains them with
+* repeated starts and ends them with a stop bit. <br>
+* @param  I2c the id of the I2c adapter
+* @return uint8_t 1 if the transaction is done, its error otherwise, see
+* I2c_Transfer.
+******************************************************************************/
+static uint8_t
+I2c_Flush(const I2c_t I2c)
+{
+  I2cAdapter_t* const Adapter = &gAdapter[I2c];
+  struct i2c_rdwr_ioctl_data Data = { Adapter->Msgs, Adapter->Count };
+  uint32_t Start;
+  int Error;
+  int res;
+
+  if(Adapter->Count == 0) return 1;
+
+  Start = I2c_GetTime();
+  res = gSys->Ioctl(Adapter->Fd, I2C_RDWR, &Data);
+  Error = errno;
+  if(I2C_WAIT_STATS == 1)
+    {
+      gWaitStats[I2c].SleepCycles += I2c_GetTime() - Start;
+      gWaitStats[I2c].Wakeups++;
+    }
+
+  if(res >= 0)
+    {
+      I2c_RecordMsgs(I2c);
+      I2c_ReceiveMsgs(I2c);
+    }
+  I2C_RECORD(I2c, I2C_OP_STOP, I2C_NO_STATUS, 0);
+
+  Adapter->Count = 0;
+  Adapter->Used = 0;
+  Adapter->Open = 0;
+
+  if(res >= 0)
+    {
+      Adapter->HasRead = 0;
+      Adapter->HasBlock = 0;
+      return 1;
+    }
+
+  if(Error == EPROTO && Adapter->HasBlock != 0)
+    {
+      //the byte count of the block is 0 or above I2C_RX_BLOCK_MAX
+      return 7;
+    }
+
+  switch(Error)
+  {
+    case ENXIO:
+      return 3;
+
+    case EAGAIN:
+    case EBUSY:
+    case ETIMEDOUT:
+      return 2;
+
+    default:
+      return Adapter->HasRead != 0 ? 5 : 4;
+  }
+}
+
+/******************************************************************************
+* Function : I2c_Drop()
+*//**
+* \b Description: Utility function to drop the transaction of a failed
+* program. The kernel released the bus if it got the messages. <br>
+* @param  I2c the id of the I2c adapter
+* @return void
+******************************************************************************/
+static void
+I2c_Drop(const I2c_t I2c)
+{
+  I2cAdapter_t* const Adapter = &gAdapter[I2c];
+
+  Adapter->Count = 0;
+  Adapter->Used = 0;
+  Adapter->Open = 0;
+  Adapter->HasRead = 0;
+  Adapter->HasBlock = 0;
+  Adapter->Owned = 0;
+}
+
+/******************************************************************************
+* Function : I2c_RecordMsgs()
+*//**
+* \b Description: Utility function to give the steps of a done transaction
+* to the recorder. The kernel doesn't tell the status codes, so every step
+* has the status I2C_NO_STATUS, and the register is recorded as a byte of
+* I2C_OP_TX. The byte count of a block is recorded as I2C_OP_RX_BLOCK. <br>
+* @param  I2c the id of the I2c adapter
+* @return void
+******************************************************************************/
+static void
+I2c_RecordMsgs(const I2c_t I2c)
+{
+  if(!(I2C_RECORDER == 1 && gRecorder != 0x0)) return;
+
+  const I2cAdapter_t* const Adapter = &gAdapter[I2c];
+  const struct i2c_msg* Msg;
+  uint8_t Read;
+  uint8_t Op;
+  uint8_t i;
+  uint16_t Length;
+  uint16_t j;
+
+  for(i = 0; i < Adapter->Count; i++)
+    {
+      Msg = &Adapter->Msgs[i];
+      Read = (Msg->flags & I2C_M_RD) != 0;
+      Length = Msg->len;
+      if((Msg->flags & I2C_M_RECV_LEN) != 0)
+        {
+          //the message has the room of the largest block
+          Length = Msg->len - I2C_RX_BLOCK_MAX + Msg->buf[0];
+        }
+
+      I2C_RECORD(I2c, I2C_OP_START, I2C_NO_STATUS, 0);
+      I2C_RECORD(I2c, Read != 0 ? I2C_OP_ADDR_R : I2C_OP_ADDR_W,
+                 I2C_NO_STATUS, (Msg->addr << 1) | Read);
+
+      for(j = 0; j < Length; j++)
+        {
+          Op = I2C_OP_TX;
+          if(Read != 0)
+            {
+              Op = j + 1 < Length ? I2C_OP_RX_ACK : I2C_OP_RX_NACK;
+            }
+          if(j == 0 && (Msg->flags & I2C_M_RECV_LEN) != 0)
+            {
+              Op = I2C_OP_RX_BLOCK;
+            }
+          I2C_RECORD(I2c, Op, I2C_NO_STATUS, Msg->buf[j]);
+        }
+    }
+}
+
+/******************************************************************************
+* Function : I2c_ReceiveMsgs()
+*//**
+* \b Description: Utility function to give the bytes received by a done
+* transaction to the Receive function of the transfer, in order. The kernel
+* received them in the buffer of the adapter, see I2c_AddRx. <br>
+* @param  I2c the id of the I2c adapter
+* @return void
+******************************************************************************/
+static void
+I2c_ReceiveMsgs(const I2c_t I2c)
+{
+  const I2cAdapter_t* const Adapter = &gAdapter[I2c];
+  const I2cTransfer_t* const Transfer = Adapter->Transfer;
+  const struct i2c_msg* Msg;
+  uint8_t i;
+  uint16_t Length;
+  uint16_t j;
+
+  if(Transfer->Receive == 0x0) return;
+
+  for(i = 0; i < Adapter->Count; i++)
+    {
+      Msg = &Adapter->Msgs[i];
+      if((Msg->flags & I2C_M_RD) == 0) continue;
+
+      Length = Msg->len;
+      if((Msg->flags & I2C_M_RECV_LEN) != 0)
+        {
+          //the message has the room of the largest block
+          Length = Msg->len - I2C_RX_BLOCK_MAX + Msg->buf[0];
+        }
+
+      for(j = 0; j < Length; j++)
+        {
+          Transfer->Receive(Transfer, Msg->buf[j]);
+        }
+    }
+}
+
+/******************************************************************************
+* Function : I2c_IrqHandler()
+*//**
+* \b Description: The I2C interrupt handler. The kernel handles the
+* interrupts of the adapters, so it does nothing. It's kept for the
+* portable code. <br>
+* @param  I2c the id of the I2c adapter
+* @return void
+******************************************************************************/
+extern void
+I2c_IrqHandler(const I2c_t I2c)
+{
+  (void)I2c;
+}
+
+/******************************************************************************
+* Function : I2c_GetWaitStats()
+*//**
+* \b Description: Get the time spent blocked in the kernel since the last
+* reset: SleepCycles counts the microseconds of the ioctls and Wakeups the
+* ioctls. It's only updated when I2C_WAIT_STATS is 1. <br>
+* @param  I2c the id of the I2c adapter
+* @param  Stats a pointer to receive the statistics in
+* @return void
+******************************************************************************/
+extern void
+I2c_GetWaitStats(const I2c_t I2c, I2cWaitStats_t* const Stats)
+{
+  if(!(I2c < I2C_MAX && Stats != 0x0)) return;
+
+  *Stats = gWaitStats[I2c];
+}
+
+/******************************************************************************
+* Function : I2c_ResetWaitStats()
+*//**
+* \b Description: Reset the time spent blocked in the kernel. <br>
+* @param  I2c the id of the I2c adapter
+* @return void
+******************************************************************************/
+extern void
+I2c_ResetWaitStats(const I2c_t I2c)
+{
+  if(!(I2c < I2C_MAX)) return;
+
+  gWaitStats[I2c].SleepCycles = 0;
+  gWaitStats[I2c].SpinCycles = 0;
+  gWaitStats[I2c].Wakeups = 0;
+}
+
+/******************************************************************************
+* Function : I2c_SetRecorder()
+*//**
+* \b Description: Set the function called with the steps of the
+* transactions of all the I2C adapters. The steps of a transaction are
+* given after its ioctl, see I2c_RecordMsgs. It's only called when
+* I2C_RECORDER is 1. <br>
+* @param  Recorder the function, null to stop recording
+* @return void
+******************************************************************************/
+extern void
+I2c_SetRecorder(const I2cRecorder_t Recorder)
+{
+  gRecorder = Recorder;
+}
+
+/******************************************************************************
+* Function : I2c_SetWriteObserver()
+*//**
+* \b Description: Set the function called when a program of I2c_Transfer,
+* I2c_TransferAsync or of the functions built on them sends bytes to a
+* register, e.g. to drop the cached copies of the registers. The bytes of
+* I2c_Write aren't observed. The observer runs when the program ends. <br>
+* @param  Observer the function, null to stop observing
+* @return void
+******************************************************************************/
+extern void
+I2c_SetWriteObserver(const I2cWriteObserver_t Observer)
+{
+  gWriteObserver = Observer;
+}
+
+/******************************************************************************
+* Function : I2c_SysOpen()
+*//**
+* \b Description: Utility function to open a character device, open has a
+* variable number of arguments. <br>
+* @param  Path the path of the device
+* @param  Flags the flags of open
+* @return int the file descriptor, -1 on error
+******************************************************************************/
+static int
+I2c_SysOpen(const char* Path, int Flags)
+{
+  return open(Path, Flags);
+}
+
+/******************************************************************************
+* Function : I2c_SysIoctl()
+*//**
+* \b Description: Utility function to call an ioctl with a pointer, ioctl
+* has a variable number of arguments. <br>
+* @param  Fd the file descriptor
+* @param  Request the request
+* @param  Arg the argument of the request
+* @return int the result of ioctl, -1 on error
+******************************************************************************/
+static int
+I2c_SysIoctl(int Fd, unsigned long Request, void* Arg)
+{
+  return ioctl(Fd, Request, Arg);
+}
+/*****************************End of File ************************************/
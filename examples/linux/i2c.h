@@ -0,0 +1,161 @@
+/**
+ * @file i2c.h
+ * @author Mohamed Hassanin
+ * @brief I2C driver header file.
+ * @version 0.1
+ * @date 2021-04-17
+ */
+#ifndef I2C_H
+#define I2C_H
+/******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define I2C_PENDING 0xFF /**< The result of a transfer which isn't finished */
+
+#define I2C_NO_STATUS 0xF8 /**< The status of a step which timed out or has
+                             none (a stop bit) */
+
+#define I2C_RX_BLOCK_MAX 32 /**< The largest byte count of I2C_OP_RX_BLOCK */
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "i2c_cfg.h"
+/******************************************************************************
+ * Typedefs
+ ******************************************************************************/
+typedef struct
+{
+  uint32_t SleepCycles; /**< CPU cycles spent asleep waiting for the hardware */
+  uint32_t SpinCycles; /**< CPU cycles spent polling the hardware */
+  uint16_t Wakeups; /**< Number of times the CPU woke up while waiting */
+}I2cWaitStats_t;
+
+/**
+ * @brief The ops of a transaction program. A program is a list of ops ended
+ * by I2C_OP_END. The ops I2C_OP_TX, I2C_OP_TX_GC and I2C_OP_RX_ACK are
+ * followed by a count byte, the number of the bytes to transfer (it can be
+ * 0). I2C_OP_RX_BLOCK is followed by the number of the bytes received after
+ * the block (e.g. 1 for a PEC), at most 255 - I2C_RX_BLOCK_MAX. It receives
+ * the byte count sent by the device into RxData, then the counted bytes and
+ * the bytes after them, the last one with NACK, so RxData needs the room of
+ * the largest block. A count of 0 or above I2C_RX_BLOCK_MAX ends the
+ * program with the result 7 after a NACKed byte.
+ */
+typedef enum
+{
+  I2C_OP_END,     /**< the end of the program */
+  I2C_OP_START,   /**< send a start or a repeated start bit */
+  I2C_OP_ADDR_W,  /**< send the address for writing, expect ACK */
+  I2C_OP_ADDR_R,  /**< send the address for reading, expect ACK */
+  I2C_OP_REG,     /**< send the register, expect ACK */
+  I2C_OP_TX,      /**< send bytes from TxData, expect ACK */
+  I2C_OP_TX_GC,   /**< send bytes from TxData, accept ACK or NACK */
+  I2C_OP_RX_ACK,  /**< receive bytes into RxData, send ACK */
+  I2C_OP_RX_NACK, /**< receive one byte into RxData, send NACK */
+  I2C_OP_STOP,    /**< send a stop bit */
+  I2C_OP_RX_BLOCK, /**< receive a byte count then the bytes it counts */
+  I2C_OP_MAX,
+}I2cOp_t;
+
+typedef struct I2cTransfer I2cTransfer_t;
+
+/**
+ * @brief A transaction program and its operands.
+ */
+struct I2cTransfer
+{
+  const uint8_t* Program; /**< the ops of the program */
+  uint8_t Address; /**< the address of the device */
+  uint8_t Register; /**< the register sent by I2C_OP_REG */
+  const uint8_t* TxData; /**< the bytes sent by I2C_OP_TX and I2C_OP_TX_GC */
+  uint8_t* RxData; /**< the buffer of I2C_OP_RX_ACK, I2C_OP_RX_NACK and
+                     I2C_OP_RX_BLOCK, unused if Receive is set */
+  void (*Callback)(const I2c_t I2c,
+                   const I2cTransfer_t* const Transfer,
+                   const uint8_t Status); /**< called when an asynchronous
+                                            transfer ends, it can be null */
+  void (*Receive)(const I2cTransfer_t* const Transfer,
+                  const uint8_t Data); /**< called with every received byte
+                                         in order instead of saving it in
+                                         RxData, it can be null */
+};
+
+/**
+ * @brief A function called with every step of the transactions, see
+ * I2c_SetRecorder. Data is the byte sent or received by the step.
+ */
+typedef void (*I2cRecorder_t)(const I2c_t I2c,
+                              const uint8_t Op,
+                              const uint8_t Status,
+                              const uint8_t Data);
+
+/**
+ * @brief A function called when a program which sends bytes to a register
+ * ends, see I2c_SetWriteObserver. Length is the number of the bytes sent
+ * after the register.
+ */
+typedef void (*I2cWriteObserver_t)(const I2c_t I2c,
+                                   const uint8_t Address,
+                                   const uint8_t Register,
+                                   const uint16_t Length);
+/******************************************************************************
+ * Function prototypes
+ ******************************************************************************/
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+extern void I2c_Init(const I2cConfig_t * const Config);
+extern uint8_t I2c_Transfer(const I2c_t I2c,
+                            const I2cTransfer_t* const Transfer);
+extern uint8_t I2c_TransferAsync(const I2c_t I2c,
+                                 const I2cTransfer_t* const Transfer);
+extern void I2c_Poll(void);
+extern uint8_t I2c_GetResult(const I2c_t I2c);
+extern uint8_t I2c_SendByte(const I2c_t I2c, 
+                            const uint8_t Address,
+                            const uint8_t Register, 
+                            const uint8_t Data);
+extern uint8_t I2c_ReceiveByte(const I2c_t I2c, 
+                               const uint8_t Address,
+                               const uint8_t Register, 
+                               uint8_t* const Data);
+extern uint8_t I2c_SendBytes(const I2c_t I2c, 
+                             const uint8_t Address,
+                             const uint8_t Register, 
+                             const uint8_t* const Data,
+                             const uint8_t Length);
+extern uint8_t I2c_ReceiveBytes(const I2c_t I2c, 
+                                const uint8_t Address,
+                                const uint8_t Register, 
+                                uint8_t* const Data,
+                                const uint8_t Length);
+extern uint8_t I2c_UpdateBits(const I2c_t I2c, 
+                              const uint8_t Address,
+                              const uint8_t Register, 
+                              const uint8_t Mask,
+                              const uint8_t Value);
+extern uint8_t I2c_GroupUpdate(const I2c_t I2c,
+                               const uint8_t* const Addresses,
+                               const uint8_t Register,
+                               const uint8_t* const Data,
+                               const uint8_t Count,
+                               const uint8_t Command);
+extern uint8_t I2c_Start(const I2c_t I2c,
+                         const uint8_t Address,
+                         const uint8_t Read);
+extern uint8_t I2c_Write(const I2c_t I2c, const uint8_t Data);
+extern uint8_t I2c_Read(const I2c_t I2c, const uint8_t Ack, uint8_t* const Data);
+extern void I2c_Stop(const I2c_t I2c);
+extern void I2c_GetWaitStats(const I2c_t I2c, I2cWaitStats_t* const Stats);
+extern void I2c_ResetWaitStats(const I2c_t I2c);
+extern void I2c_SetRecorder(const I2cRecorder_t Recorder);
+extern void I2c_SetWriteObserver(const I2cWriteObserver_t Observer);
+extern void I2c_IrqHandler(const I2c_t I2c);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
+/*****************************End of File ************************************/
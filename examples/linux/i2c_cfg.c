@@ -0,0 +1,135 @@
+/**
+ * @file i2c_cfg.c
+ * @author Mohamed Hassanin
+ * @brief I2C driver configuration file of the Linux userspace port.
+ * @version 0.1
+ * @date 2021-05-27
+ */
+
+/*****************************************************************************
+* Includes
+*****************************************************************************/
+#define _POSIX_C_SOURCE 199309L /* clock_gettime */
+#include <time.h>
+#include "i2c_cfg.h"
+
+/*****************************************************************************
+* Module Variable Definitions
+*****************************************************************************/
+/**
+* The following array contains the configuration data for each
+* I2C adapter. Each row represents an adapter. Each column is
+* representing a member of the I2cConfig_t
+* structure. This table is read in by I2c_Init, where the character device
+* of each adapter is opened.
+*/
+static const I2cConfig_t I2cConfig[] =
+{
+  //TODO: configure your I2C adapters
+  { I2C_0, 100000, "/dev/i2c-1" }
+};
+
+/**
+* The following array contains the configuration data for each device.
+* Each row represents a device. Each column is representing a member of the
+* I2cDeviceConfig_t structure. The SCL speed is set by the kernel, so this
+* table is only read in by the modules (e.g. i2c_drdy).
+*/
+static const I2cDeviceConfig_t I2cDeviceConfig[] =
+{
+  //TODO: configure your devices
+  { I2C_DEVICE_0, I2C_0, 0x50, 400000 }
+};
+
+/**
+* The following array contains the configuration data for each device
+* data-ready line. Each row represents a line. Each column is representing a
+* member of the I2cDrdyConfig_t structure. This table is read in by
+* I2cDrdy_Init, where the burst read of each line is prepared once.
+*/
+static const I2cDrdyConfig_t I2cDrdyConfig[] =
+{
+  //TODO: configure your data-ready lines
+  { I2C_DRDY_0, I2C_DEVICE_0, 0x28, 6 }
+};
+/******************************************************************************
+* Function Definitions
+*****************************************************************************/
+/******************************************************************************
+* Function : I2c_GetConfig()
+*//**
+* \b Description:
+* This function is used to get the cofiguration handle of the I2C <br>
+* POST-CONDITION: A constant pointer to the first member of the
+* configuration table will be returned. <br>
+* @return A pointer to the configuration table.
+*
+* \b Example Example:
+* @code
+* const I2c_ConfigType* I2cConfig = I2c_GetConfig();
+* I2c_Init(I2cConfig);
+* @endcode
+* @see I2c_Init
+ ******************************************************************************/
+extern const I2cConfig_t * 
+I2c_GetConfig(void)
+{
+  /*
+  * The cast is performed to ensure that the address of the first element
+  * of configuration table is returned as a constant pointer and NOT a
+  * pointer that can be modified.
+  */
+  return (const I2cConfig_t *) I2cConfig;
+}
+
+/******************************************************************************
+* Function : I2c_GetDeviceConfig()
+*//**
+* \b Description:
+* This function is used to get the device configuration handle of the I2C <br>
+* POST-CONDITION: A constant pointer to the first member of the device
+* configuration table will be returned. <br>
+* @return A pointer to the device configuration table.
+* @see I2c_Init
+ ******************************************************************************/
+extern const I2cDeviceConfig_t *
+I2c_GetDeviceConfig(void)
+{
+  return (const I2cDeviceConfig_t *) I2cDeviceConfig;
+}
+
+/******************************************************************************
+* Function : I2c_GetDrdyConfig()
+*//**
+* \b Description:
+* This function is used to get the data-ready configuration handle of the
+* I2C <br>
+* POST-CONDITION: A constant pointer to the first member of the data-ready
+* configuration table will be returned. <br>
+* @return A pointer to the data-ready configuration table.
+* @see I2cDrdy_Init
+ ******************************************************************************/
+extern const I2cDrdyConfig_t *
+I2c_GetDrdyConfig(void)
+{
+  return (const I2cDrdyConfig_t *) I2cDrdyConfig;
+}
+
+/******************************************************************************
+* Function : I2c_GetTime()
+*//**
+* \b Description:
+* This function is used to get the time of the driver and its modules, the
+* microseconds of the monotonic clock. It wraps around every 71 minutes. <br>
+* @return uint32_t the time in microseconds
+ ******************************************************************************/
+extern uint32_t
+I2c_GetTime(void)
+{
+  struct timespec Now;
+
+  clock_gettime(CLOCK_MONOTONIC, &Now);
+
+  return (uint32_t)((uint64_t)Now.tv_sec * 1000000u + Now.tv_nsec / 1000);
+}
+/*****************************End of File ************************************/
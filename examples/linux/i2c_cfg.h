@@ -0,0 +1,250 @@
+/**
+ * @file i2c_cfg.h
+ * @author Mohamed Hassanin
+ * @brief I2C driver configuration header file of the Linux userspace port.
+ * @version 0.1
+ * @date 2021-05-27
+ */
+
+#ifndef I2C_CFG_H
+#define I2C_CFG_H
+/******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/**
+ * @brief The maximum number of messages (the segments between two start
+ * bits) of one transaction, all given to the kernel by one I2C_RDWR ioctl.
+ * The kernel takes at most 42 (I2C_RDWR_IOCTL_MAX_MSGS).
+ * TODO: change this as required.
+ */
+#define I2C_LINUX_MSGS 16
+
+/**
+ * @brief The maximum number of bytes written by one transaction: the
+ * registers and the bytes of I2C_OP_TX of all its messages. The received
+ * bytes go straight into RxData.
+ * TODO: change this as required.
+ */
+#define I2C_LINUX_BUFFER_SIZE 512
+
+/**
+ * @brief Set to 1 to count the time spent blocked in the ioctls. See
+ * I2c_GetWaitStats.
+ */
+#define I2C_WAIT_STATS 1
+
+/**
+ * @brief A free running 16-bit counter used by the bus recorder, the low
+ * bits of the microseconds of I2c_GetTime.
+ */
+#define I2C_GET_CYCLES() ((uint16_t)I2c_GetTime())
+
+/**
+ * @brief Set to 1 to give every step of the transactions to the recorder
+ * set by I2c_SetRecorder, 0 to compile the calls out.
+ */
+#define I2C_RECORDER 1
+
+/**
+ * @brief The number of bytes of the log of the bus recorder (i2c_rec), 5
+ * bytes per step. It must be a power of two and at most 32768.
+ * TODO: change this as required.
+ */
+#define I2C_REC_SIZE 256
+
+/**
+ * @brief The maximum number of requests waiting in the arbiter.
+ * TODO: change this as required.
+ */
+#define I2C_ARB_QUEUE_SIZE 8
+
+/**
+ * @brief The maximum number of bytes transferred in one transaction by the
+ * arbiter. Longer requests are split so that urgent requests can get in
+ * between the chunks.
+ * TODO: change this as required.
+ */
+#define I2C_ARB_CHUNK 16
+
+/**
+ * @brief The maximum number of transactions run by one call of
+ * I2cArb_Update. It bounds the execution time of the update.
+ * TODO: change this as required.
+ */
+#define I2C_ARB_CHUNKS_PER_UPDATE 4
+
+/**
+ * @brief The maximum number of requests waiting in the submission queue. It
+ * must be a power of two and at most 128.
+ * TODO: change this as required.
+ */
+#define I2C_QUEUE_SIZE 8
+
+/**
+ * @brief Set to 1 to compute the SMBus PEC with a 16 entries table instead
+ * of a 256 entries one. It saves 240 bytes for two lookups per byte.
+ * TODO: change this as required.
+ */
+#define I2C_SMBUS_PEC_NIBBLE_TABLE 0
+
+/**
+ * @brief The number of bytes of a line of the read-ahead cache (i2c_cache).
+ * A miss reads the whole aligned line. It must be a power of two and at
+ * most 128.
+ * TODO: change this as required.
+ */
+#define I2C_CACHE_LINE_SIZE 16
+
+/**
+ * @brief The number of lines of the read-ahead cache. They're shared by all
+ * the devices.
+ * TODO: change this as required.
+ */
+#define I2C_CACHE_LINES 4
+
+/**
+ * @brief The samples buffered per device by the data-ready acquisition
+ * (i2c_drdy), and the maximum size in bytes of a sample. The depth must be
+ * a power of two and at most 128.
+ * TODO: change this as required.
+ */
+#define I2C_DRDY_DEPTH 4
+#define I2C_DRDY_SAMPLE_SIZE 6
+
+/**
+ * @brief A free running 32-bit time taken by i2c_drdy at the data-ready
+ * edge and at the end of the read of a sample, in microseconds.
+ */
+#define I2C_DRDY_GET_TIME() I2c_GetTime()
+
+/**
+ * @brief The number and the size in bytes of the static coroutine frames of
+ * the tasks of i2c_co.hpp. A task whose frame doesn't fit isn't started.
+ * TODO: change this as required.
+ */
+#define I2C_CO_FRAMES 2
+#define I2C_CO_FRAME_SIZE 256
+
+/**
+ * @brief Set to 1 to decode the 16-bit samples of i2c_sample 8 at a time
+ * with the vector extensions of GCC (SSE2 or NEON), 0 for a scalar loop.
+ * It can be set by the build.
+ * TODO: change this as required.
+ */
+#ifndef I2C_SAMPLE_VECTOR
+#define I2C_SAMPLE_VECTOR 1
+#endif
+
+/**
+ * @brief The descriptors (an asynchronous transfer or a request of the
+ * arbiter) and the data buffers of the static pool (i2c_pool), and the
+ * bytes of a buffer. There are at most 254 of each.
+ * TODO: shrink them to the peaks of I2cPool_GetStats.
+ */
+#define I2C_POOL_DESCRIPTOR_COUNT 8
+#define I2C_POOL_BUFFER_COUNT 4
+#define I2C_POOL_BUFFER_SIZE 16
+
+/**
+ * @brief The bytes of RAM the pool may take with its bookkeeping. It's
+ * checked at compile time. A descriptor takes 48 bytes on a 64-bit CPU.
+ * TODO: change this as required.
+ */
+#define I2C_POOL_RAM_BUDGET 512
+
+/**
+ * @brief The type, entering and exiting of a critical section. The driver
+ * is called from one thread, an application with several threads must
+ * serialize its calls.
+ */
+#define I2C_CRITICAL_STATE uint8_t
+#define I2C_ENTER_CRITICAL(__STATE__) do { (__STATE__) = 0; } while(0)
+#define I2C_EXIT_CRITICAL(__STATE__) do { (void)(__STATE__); } while(0)
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <inttypes.h>
+/******************************************************************************
+ * Typedefs
+ ******************************************************************************/
+/**
+* Defines an enumerated list of all the I2C adapters used by the
+* application. The last element is used to specify the maximum number of
+* enumerated labels.
+*/
+typedef enum
+{
+  /* TODO: Populate this list based on the adapters */
+  I2C_0,
+  I2C_MAX
+}I2c_t;
+
+/**
+* Defines an enumerated list of all the devices connected to the I2C
+* adapters. The last element is used to specify the maximum number of
+* enumerated labels.
+*/
+typedef enum
+{
+  /* TODO: Populate this list based on the devices on the buses */
+  I2C_DEVICE_0,
+  I2C_DEVICE_MAX
+}I2cDevice_t;
+
+/**
+* Defines an enumerated list of all the devices whose data-ready line is
+* watched, see i2c_drdy. The last element is used to specify the maximum
+* number of enumerated labels.
+*/
+typedef enum
+{
+  /* TODO: Populate this list based on the data-ready lines */
+  I2C_DRDY_0,
+  I2C_DRDY_MAX
+}I2cDrdySource_t;
+
+typedef struct
+{
+  I2c_t I2c; /**< the I2c adapter id */
+  uint32_t Speed; /**< the speed of the I2C SCL clock rate in Hz. It's set
+                    by the kernel (the device tree), the driver doesn't
+                    change it */
+  const char* Path; /**< the character device of the adapter, e.g.
+                      "/dev/i2c-1" */
+}I2cConfig_t;
+
+typedef struct
+{
+  I2cDevice_t Device; /**< the device id */
+  I2c_t I2c; /**< the I2c adapter the device is connected to */
+  uint8_t Address; /**< the 7-bit address of the device */
+  uint32_t Speed; /**< the maximum SCL clock rate of the device in Hz. The
+                    adapter must be set at most to it */
+}I2cDeviceConfig_t;
+
+typedef struct
+{
+  I2cDrdySource_t Source; /**< the data-ready line id */
+  I2cDevice_t Device; /**< the device of the line, from the device table */
+  uint8_t Register; /**< the first register of a sample */
+  uint8_t Length; /**< the bytes of a sample (max I2C_DRDY_SAMPLE_SIZE) */
+}I2cDrdyConfig_t;
+/******************************************************************************
+ * Function prototypes
+ ******************************************************************************/
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+extern const I2cConfig_t* I2c_GetConfig(void);
+extern const I2cDeviceConfig_t* I2c_GetDeviceConfig(void);
+extern const I2cDrdyConfig_t* I2c_GetDrdyConfig(void);
+extern uint32_t I2c_GetTime(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
+/*****************************End of File ************************************/
@@ -0,0 +1,373 @@
+/**
+ * @file i2c_fake.c
+ * @author Mohamed Hassanin
+ * @brief A fake I2C adapter in userspace for the Linux port of the driver.
+ * Its system calls (I2cFake_GetSys) take the place of the kernel ones with
+ * I2c_SetSys. The messages of an I2C_RDWR ioctl are run on memory devices
+ * like the kernel does: in order, up to the first one which fails, which
+ * sets errno to ENXIO if nobody acknowledges its address. A read message
+ * with I2C_M_RECV_LEN receives an SMBus block like i2c-dev and an adapter
+ * which supports it do.
+ * @version 0.1
+ * @date 2021-05-27
+ */
+/******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define I2C_FAKE_FD 3 /**< The file descriptor of the fake adapter */
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <errno.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include "i2c_fake.h"
+/******************************************************************************
+ * module variables definitions
+ ******************************************************************************/
+static I2cFakeDevice_t gDevices[I2C_FAKE_DEVICES];
+
+static uint8_t gCount;
+
+static int gFailNext;
+
+static I2cFakeStats_t gStats;
+/******************************************************************************
+ * functions prototypes
+ ******************************************************************************/
+static int I2cFake_Open(const char* Path, int Flags);
+static int I2cFake_Ioctl(int Fd, unsigned long Request, void* Arg);
+static int I2cFake_Close(int Fd);
+static int I2cFake_RunMsg(const struct i2c_msg* const Msg);
+static int I2cFake_RunBlock(I2cFakeDevice_t* const Device,
+                            const struct i2c_msg* const Msg);
+static I2cFakeDevice_t* I2cFake_Find(const uint8_t Address);
+/******************************************************************************
+ * functions definitions
+ ******************************************************************************/
+/******************************************************************************
+* Function : I2cFake_Init()
+*//**
+* \b Description:
+* Remove all the devices and reset the counters. <br>
+* @return void
+ ******************************************************************************/
+extern void
+I2cFake_Init(void)
+{
+  gCount = 0;
+  gFailNext = 0;
+  gStats.Ioctls = 0;
+  gStats.Messages = 0;
+  gStats.Bytes = 0;
+}
+
+/******************************************************************************
+* Function : I2cFake_AddDevice()
+*//**
+* \b Description:
+* Connect a memory device to the fake adapter. Its registers are zeroed.
+* <br>
+* @param Address the 7-bit address of the device
+* @return I2cFakeDevice_t* the device, null if there are I2C_FAKE_DEVICES
+* devices already.
+ ******************************************************************************/
+extern I2cFakeDevice_t*
+I2cFake_AddDevice(const uint8_t Address)
+{
+  if(!(gCount < I2C_FAKE_DEVICES)) return 0x0;
+
+  I2cFakeDevice_t* const Device = &gDevices[gCount];
+  uint16_t i;
+
+  Device->Address = Address;
+  Device->Pointer = 0;
+  Device->GeneralCall = 0;
+  for(i = 0; i < sizeof(Device->Memory); i++)
+    {
+      Device->Memory[i] = 0;
+    }
+  gCount++;
+
+  return Device;
+}
+
+/******************************************************************************
+* Function : I2cFake_GetSys()
+*//**
+* \b Description:
+* Get the system calls of the fake adapter, to give to I2c_SetSys. <br>
+* @return const I2cSys_t* the system calls
+ ******************************************************************************/
+extern const I2cSys_t*
+I2cFake_GetSys(void)
+{
+  static const I2cSys_t Sys =
+  {
+    I2cFake_Open, I2cFake_Ioctl, I2cFake_Close
+  };
+
+  return &Sys;
+}
+
+/******************************************************************************
+* Function : I2cFake_FailNext()
+*//**
+* \b Description:
+* Fail the next I2C_RDWR ioctl with an error, before any of its messages
+* is run, e.g. EAGAIN for a lost arbitration. <br>
+* @param Error the errno of the failure
+* @return void
+ ******************************************************************************/
+extern void
+I2cFake_FailNext(const int Error)
+{
+  gFailNext = Error;
+}
+
+/******************************************************************************
+* Function : I2cFake_GetStats()
+*//**
+* \b Description:
+* Get the counters of the I2C_RDWR ioctls since I2cFake_Init. <br>
+* @param Stats a pointer to receive the counters in
+* @return void
+ ******************************************************************************/
+extern void
+I2cFake_GetStats(I2cFakeStats_t* const Stats)
+{
+  if(!(Stats != 0x0)) return;
+
+  *Stats = gStats;
+}
+
+/******************************************************************************
+* Function : I2cFake_Open()
+*//**
+* \b Description:
+* Utility function to open the fake adapter, whatever the path. <br>
+* @param Path the path of the device
+* @param Flags the flags of open
+* @return int the file descriptor
+ ******************************************************************************/
+static int
+I2cFake_Open(const char* Path, int Flags)
+{
+  (void)Path;
+  (void)Flags;
+
+  return I2C_FAKE_FD;
+}
+
+/******************************************************************************
+* Function : I2cFake_Ioctl()
+*//**
+* \b Description:
+* Utility function to answer I2C_FUNCS, and to run the messages of
+* I2C_RDWR. <br>
+* @param Fd the file descriptor
+* @param Request the request
+* @param Arg the argument of the request
+* @return int the number of the messages run, -1 on error
+ ******************************************************************************/
+static int
+I2cFake_Ioctl(int Fd, unsigned long Request, void* Arg)
+{
+  const struct i2c_rdwr_ioctl_data* Data;
+  uint32_t i;
+  int res;
+
+  if(!(Fd == I2C_FAKE_FD && Arg != 0x0))
+    {
+      errno = EBADF;
+      return -1;
+    }
+
+  if(Request == I2C_FUNCS)
+    {
+      *(unsigned long*)Arg = I2C_FUNC_I2C | I2C_FUNC_PROTOCOL_MANGLING;
+      return 0;
+    }
+
+  if(!(Request == I2C_RDWR))
+    {
+      errno = ENOTTY;
+      return -1;
+    }
+
+  Data = (const struct i2c_rdwr_ioctl_data*)Arg;
+  if(!(Data->nmsgs != 0 && Data->nmsgs <= I2C_RDWR_IOCTL_MAX_MSGS))
+    {
+      errno = EINVAL;
+      return -1;
+    }
+
+  gStats.Ioctls++;
+
+  if(gFailNext != 0)
+    {
+      errno = gFailNext;
+      gFailNext = 0;
+      return -1;
+    }
+
+  for(i = 0; i < Data->nmsgs; i++)
+    {
+      gStats.Messages++;
+      res = I2cFake_RunMsg(&Data->msgs[i]);
+      if(res < 0)
+        {
+          errno = -res;
+          return -1;
+        }
+    }
+
+  return (int)Data->nmsgs;
+}
+
+/******************************************************************************
+* Function : I2cFake_Close()
+*//**
+* \b Description:
+* Utility function to close the fake adapter. <br>
+* @param Fd the file descriptor
+* @return int 0
+ ******************************************************************************/
+static int
+I2cFake_Close(int Fd)
+{
+  (void)Fd;
+
+  return 0;
+}
+
+/******************************************************************************
+* Function : I2cFake_RunMsg()
+*//**
+* \b Description:
+* Utility function to run a message on the devices. A general call gives
+* its first byte to all the devices. <br>
+* @param Msg the message
+* @return int 0 if the message is acknowledged, -ENXIO otherwise, or the
+* error of I2cFake_RunBlock.
+ ******************************************************************************/
+static int
+I2cFake_RunMsg(const struct i2c_msg* const Msg)
+{
+  I2cFakeDevice_t* Device;
+  uint16_t i;
+
+  if((Msg->flags & I2C_M_RECV_LEN) == 0)
+    {
+      gStats.Bytes += Msg->len;
+    }
+
+  if(Msg->addr == 0x00 && (Msg->flags & I2C_M_RD) == 0)
+    {
+      for(i = 0; i < gCount && Msg->len != 0; i++)
+        {
+          gDevices[i].GeneralCall = Msg->buf[0];
+        }
+
+      return gCount != 0 || (Msg->flags & I2C_M_IGNORE_NAK) != 0 ? 0 : -ENXIO;
+    }
+
+  Device = I2cFake_Find(Msg->addr);
+  if(Device == 0x0)
+    {
+      return (Msg->flags & I2C_M_IGNORE_NAK) != 0 ? 0 : -ENXIO;
+    }
+
+  if((Msg->flags & I2C_M_RECV_LEN) != 0)
+    {
+      return I2cFake_RunBlock(Device, Msg);
+    }
+
+  if((Msg->flags & I2C_M_RD) != 0)
+    {
+      for(i = 0; i < Msg->len; i++)
+        {
+          Msg->buf[i] = Device->Memory[Device->Pointer];
+          Device->Pointer++;
+        }
+    }
+  else if(Msg->len != 0)
+    {
+      Device->Pointer = Msg->buf[0];
+      for(i = 1; i < Msg->len; i++)
+        {
+          Device->Memory[Device->Pointer] = Msg->buf[i];
+          Device->Pointer++;
+        }
+    }
+
+  return 0;
+}
+
+/******************************************************************************
+* Function : I2cFake_RunBlock()
+*//**
+* \b Description:
+* Utility function to receive a block (I2C_M_RECV_LEN). The message is
+* checked like i2c-dev does: the first byte of its buffer holds the bytes
+* before the count is known, 1 plus the extra ones (e.g. a PEC), and the
+* buffer has the room of the largest block. The byte count read from the
+* device replaces it. <br>
+* @param Device the addressed device
+* @param Msg the message
+* @return int 0 if the block is received, -EINVAL if the message is
+* invalid, -EPROTO if the byte count is 0 or above I2C_SMBUS_BLOCK_MAX.
+ ******************************************************************************/
+static int
+I2cFake_RunBlock(I2cFakeDevice_t* const Device,
+                 const struct i2c_msg* const Msg)
+{
+  uint8_t Extra;
+  uint8_t Count;
+  uint16_t i;
+
+  if(!((Msg->flags & I2C_M_RD) != 0 && Msg->len >= 1 && Msg->buf[0] >= 1 &&
+       Msg->len >= Msg->buf[0] + I2C_SMBUS_BLOCK_MAX))
+    {
+      return -EINVAL;
+    }
+
+  Extra = Msg->buf[0] - 1;
+  Count = Device->Memory[Device->Pointer];
+  Device->Pointer++;
+  Msg->buf[0] = Count;
+  gStats.Bytes++;
+
+  if(Count == 0 || Count > I2C_SMBUS_BLOCK_MAX) return -EPROTO;
+
+  for(i = 1; i <= Count + Extra; i++)
+    {
+      Msg->buf[i] = Device->Memory[Device->Pointer];
+      Device->Pointer++;
+    }
+  gStats.Bytes += Count + Extra;
+
+  return 0;
+}
+
+/******************************************************************************
+* Function : I2cFake_Find()
+*//**
+* \b Description:
+* Utility function to find the device of an address. <br>
+* @param Address the 7-bit address
+* @return I2cFakeDevice_t* the device, null if nobody has the address.
+ ******************************************************************************/
+static I2cFakeDevice_t*
+I2cFake_Find(const uint8_t Address)
+{
+  uint8_t i;
+
+  for(i = 0; i < gCount; i++)
+    {
+      if(gDevices[i].Address == Address) return &gDevices[i];
+    }
+
+  return 0x0;
+}
+/*****************************End of File ************************************/
@@ -0,0 +1,58 @@
+/**
+ * @file i2c_fake.h
+ * @author Mohamed Hassanin
+ * @brief A fake I2C adapter in userspace for the Linux port of the driver.
+ * @version 0.1
+ * @date 2021-05-27
+ */
+#ifndef I2C_FAKE_H
+#define I2C_FAKE_H
+/******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define I2C_FAKE_DEVICES 4 /**< The maximum number of the fake devices */
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "i2c_linux.h"
+/******************************************************************************
+ * Typedefs
+ ******************************************************************************/
+/**
+ * @brief A memory device: the first byte written after the address sets
+ * the register pointer, the next ones are written from it, and the reads
+ * start from it. The pointer is incremented after each byte.
+ */
+typedef struct
+{
+  uint8_t Address; /**< the 7-bit address */
+  uint8_t Pointer; /**< the register pointer */
+  uint8_t Memory[256]; /**< the registers */
+  uint8_t GeneralCall; /**< the last general call command */
+}I2cFakeDevice_t;
+
+typedef struct
+{
+  uint32_t Ioctls; /**< Number of I2C_RDWR ioctls */
+  uint32_t Messages; /**< Number of messages of the ioctls */
+  uint32_t Bytes; /**< Number of bytes of the messages */
+}I2cFakeStats_t;
+/******************************************************************************
+ * Function prototypes
+ ******************************************************************************/
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+extern void I2cFake_Init(void);
+extern I2cFakeDevice_t* I2cFake_AddDevice(const uint8_t Address);
+extern const I2cSys_t* I2cFake_GetSys(void);
+extern void I2cFake_FailNext(const int Error);
+extern void I2cFake_GetStats(I2cFakeStats_t* const Stats);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
+/*****************************End of File ************************************/
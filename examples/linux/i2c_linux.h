@@ -0,0 +1,43 @@
+/**
+ * @file i2c_linux.h
+ * @author Mohamed Hassanin
+ * @brief The system calls of the Linux userspace port of the I2C driver.
+ * They're replaced with I2c_SetSys to run the driver without the hardware,
+ * e.g. on a fake device (i2c_fake).
+ * @version 0.1
+ * @date 2021-05-27
+ */
+#ifndef I2C_LINUX_H
+#define I2C_LINUX_H
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "i2c.h"
+/******************************************************************************
+ * Typedefs
+ ******************************************************************************/
+/**
+ * @brief The system calls used by the driver. They behave like open, ioctl
+ * and close: a failing call returns -1 and sets errno.
+ */
+typedef struct
+{
+  int (*Open)(const char* Path, int Flags);
+  int (*Ioctl)(int Fd, unsigned long Request, void* Arg);
+  int (*Close)(int Fd);
+}I2cSys_t;
+/******************************************************************************
+ * Function prototypes
+ ******************************************************************************/
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+extern void I2c_SetSys(const I2cSys_t* const Sys);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
+/*****************************End of File ************************************/
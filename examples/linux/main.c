@@ -0,0 +1,205 @@
+/**
+ * @file main.c
+ * @author Mohamed Hassanin
+ * @brief The Linux userspace port run on the fake adapter (i2c_fake). Every
+ * transaction of the driver API is checked against the memory of the fake
+ * devices and against the number of I2C_RDWR ioctls it took:
+ *
+ *   gcc -Iexamples/linux -Isrc examples/linux/main.c examples/linux/i2c.c \
+ *     examples/linux/i2c_cfg.c examples/linux/i2c_fake.c src/i2c_smbus.c \
+ *     -o linux_demo
+ *
+ * @version 0.1
+ * @date 2021-05-27
+ */
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <stdio.h>
+#include <errno.h>
+#include "i2c.h"
+#include "i2c_fake.h"
+#include "i2c_smbus.h"
+/******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define CHECK(__CONDITION__) \
+do { \
+  if(!(__CONDITION__)) \
+    { \
+      printf("line %d: %s\n", __LINE__, #__CONDITION__); \
+      gErrors++; \
+    } \
+} while(0)
+/******************************************************************************
+ * module variables definitions
+ ******************************************************************************/
+static uint8_t gErrors;
+
+static uint8_t gDone;
+/******************************************************************************
+ * functions definitions
+ ******************************************************************************/
+/**
+ * @brief The ioctls and the messages since the last call.
+ */
+static void
+GetCalls(uint32_t* const Ioctls, uint32_t* const Messages)
+{
+  static I2cFakeStats_t Last;
+  I2cFakeStats_t Stats;
+
+  I2cFake_GetStats(&Stats);
+  *Ioctls = Stats.Ioctls - Last.Ioctls;
+  *Messages = Stats.Messages - Last.Messages;
+  Last = Stats;
+}
+
+static void
+Done(const I2c_t I2c, const I2cTransfer_t* const Transfer, const uint8_t Status)
+{
+  (void)I2c;
+  (void)Transfer;
+  gDone = Status;
+}
+
+int
+main(void)
+{
+  static const uint8_t Program[] =
+  {
+    I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_REG, I2C_OP_START, I2C_OP_ADDR_R,
+    I2C_OP_RX_ACK, 3, I2C_OP_RX_NACK, I2C_OP_STOP, I2C_OP_END
+  };
+  const uint8_t Addresses[3] = { 0x50, 0x51, 0x52 };
+  const uint8_t Values[3] = { 0x0A, 0x0B, 0x0C };
+  I2cFakeDevice_t* Device[3];
+  I2cTransfer_t Transfer;
+  uint8_t Data[64];
+  uint32_t Ioctls;
+  uint32_t Messages;
+  uint8_t Byte;
+  uint8_t i;
+
+  I2cFake_Init();
+  for(i = 0; i < 3; i++)
+    {
+      Device[i] = I2cFake_AddDevice(Addresses[i]);
+    }
+  I2c_SetSys(I2cFake_GetSys());
+  I2c_Init(I2c_GetConfig());
+
+  //a write: one message
+  CHECK(I2c_SendByte(I2C_0, 0x50, 0x10, 0x5A) == 1);
+  GetCalls(&Ioctls, &Messages);
+  CHECK(Device[0]->Memory[0x10] == 0x5A);
+  CHECK(Ioctls == 1 && Messages == 1);
+
+  //a burst read: the register, then the bytes after a repeated start
+  for(i = 0; i < 64; i++)
+    {
+      Device[1]->Memory[0x40 + i] = i;
+    }
+  CHECK(I2c_ReceiveBytes(I2C_0, 0x51, 0x40, Data, 64) == 1);
+  GetCalls(&Ioctls, &Messages);
+  CHECK(Data[0] == 0 && Data[63] == 63);
+  CHECK(Ioctls == 1 && Messages == 2);
+
+  //a program: the RX_ACK and RX_NACK bytes share the read message
+  Transfer.Program = Program;
+  Transfer.Address = 0x51;
+  Transfer.Register = 0x44;
+  Transfer.TxData = 0x0;
+  Transfer.RxData = Data;
+  Transfer.Callback = 0x0;
+  Transfer.Receive = 0x0;
+  CHECK(I2c_Transfer(I2C_0, &Transfer) == 1);
+  GetCalls(&Ioctls, &Messages);
+  CHECK(Data[0] == 4 && Data[3] == 7);
+  CHECK(Ioctls == 1 && Messages == 2);
+
+  //the read needs its data, so the write is another ioctl
+  Device[0]->Memory[0x20] = 0xF0;
+  CHECK(I2c_UpdateBits(I2C_0, 0x50, 0x20, 0x0F, 0x05) == 1);
+  GetCalls(&Ioctls, &Messages);
+  CHECK(Device[0]->Memory[0x20] == 0xF5);
+  CHECK(Ioctls == 2);
+
+  //three preloads and the latch, chained by repeated starts
+  CHECK(I2c_GroupUpdate(I2C_0, Addresses, 0x30, Values, 3, 0x06) == 1);
+  GetCalls(&Ioctls, &Messages);
+  CHECK(Device[0]->Memory[0x30] == 0x0A && Device[2]->Memory[0x30] == 0x0C);
+  CHECK(Device[1]->GeneralCall == 0x06);
+  CHECK(Ioctls == 1 && Messages == 4);
+
+  //the bytes of I2c_Start and I2c_Write wait for the stop bit
+  CHECK(I2c_Start(I2C_0, 0x52, 0) == 1);
+  CHECK(I2c_Write(I2C_0, 0x60) == 1);
+  CHECK(I2c_Write(I2C_0, 0x11) == 1);
+  CHECK(I2c_Write(I2C_0, 0x22) == 1);
+  GetCalls(&Ioctls, &Messages);
+  CHECK(Ioctls == 0);
+  I2c_Stop(I2C_0);
+  GetCalls(&Ioctls, &Messages);
+  CHECK(I2c_GetResult(I2C_0) == 1);
+  CHECK(Device[2]->Memory[0x60] == 0x11 && Device[2]->Memory[0x61] == 0x22);
+  CHECK(Ioctls == 1 && Messages == 1);
+
+  //a read of I2c_Read is given to the kernel with the messages before it
+  CHECK(I2c_Start(I2C_0, 0x52, 0) == 1);
+  CHECK(I2c_Write(I2C_0, 0x60) == 1);
+  CHECK(I2c_Start(I2C_0, 0x52, 1) == 1);
+  CHECK(I2c_Read(I2C_0, 1, &Byte) == 1);
+  CHECK(Byte == 0x11);
+  CHECK(I2c_Read(I2C_0, 0, &Byte) == 1);
+  CHECK(Byte == 0x22);
+  I2c_Stop(I2C_0);
+  GetCalls(&Ioctls, &Messages);
+  CHECK(Ioctls == 2 && Messages == 3);
+
+  //an SMBus block read: the byte count sizes the read message in the kernel
+  Device[2]->Memory[0x70] = 3;
+  Device[2]->Memory[0x71] = 0xA1;
+  Device[2]->Memory[0x72] = 0xA2;
+  Device[2]->Memory[0x73] = 0xA3;
+  CHECK(I2cSmbus_BlockRead(I2C_0, 0x52, 0x70, Data, &Byte, 0) == 1);
+  GetCalls(&Ioctls, &Messages);
+  CHECK(Byte == 3 && Data[0] == 0xA1 && Data[2] == 0xA3);
+  CHECK(Ioctls == 1 && Messages == 2);
+
+  //a byte count above the SMBus limit
+  Device[2]->Memory[0x70] = I2C_SMBUS_BLOCK_MAX + 1;
+  CHECK(I2cSmbus_BlockRead(I2C_0, 0x52, 0x70, Data, &Byte, 0) == 7);
+  GetCalls(&Ioctls, &Messages);
+  CHECK(Ioctls == 1);
+
+  //the errors
+  CHECK(I2c_SendByte(I2C_0, 0x33, 0x00, 0x00) == 3);
+  I2cFake_FailNext(EAGAIN);
+  CHECK(I2c_SendByte(I2C_0, 0x50, 0x00, 0x00) == 2);
+  I2cFake_FailNext(EREMOTEIO);
+  CHECK(I2c_SendByte(I2C_0, 0x50, 0x00, 0x00) == 4);
+  I2cFake_FailNext(EREMOTEIO);
+  CHECK(I2c_ReceiveByte(I2C_0, 0x50, 0x00, &Byte) == 5);
+  CHECK(I2c_Start(I2C_0, 0x33, 0) == 1);
+  I2c_Stop(I2C_0);
+  CHECK(I2c_GetResult(I2C_0) == 3);
+  //the bus is released after an error
+  CHECK(I2c_SendByte(I2C_0, 0x50, 0x10, 0xA5) == 1);
+  CHECK(Device[0]->Memory[0x10] == 0xA5);
+  GetCalls(&Ioctls, &Messages);
+  CHECK(Ioctls == 6);
+
+  //an asynchronous transfer runs in I2c_Poll
+  Transfer.Callback = Done;
+  CHECK(I2c_TransferAsync(I2C_0, &Transfer) == 1);
+  CHECK(I2c_GetResult(I2C_0) == I2C_PENDING);
+  CHECK(I2c_SendByte(I2C_0, 0x50, 0x10, 0x00) == 6);
+  I2c_Poll();
+  CHECK(gDone == 1 && I2c_GetResult(I2C_0) == 1);
+
+  printf("%u errors\n", gErrors);
+
+  return gErrors == 0 ? 0 : 1;
+}
+/*****************************End of File ************************************/
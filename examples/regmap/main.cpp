@@ -0,0 +1,181 @@
+/**
+ * @file main.cpp
+ * @author Mohamed Hassanin
+ * @brief The register map of an accelerometer (i2c_regmap.hpp), run on the
+ * host model of the TWI. The bus bytes of every access are counted by the
+ * bus recorder and checked against the compile-time plan:
+ *
+ *   gcc -c -DI2C_SIM -Isrc -Itest/support examples/atmega32a/i2c.c \
+ *     examples/atmega32a/i2c_cfg.c src/i2c_rec.c test/support/twi_sim.c
+ *   g++ -std=c++20 -DI2C_SIM -Isrc -Itest/support \
+ *     examples/regmap/main.cpp i2c.o i2c_cfg.o i2c_rec.o twi_sim.o \
+ *     -o regmap_demo
+ *
+ * @version 0.1
+ * @date 2021-05-25
+ */
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <cstdio>
+#include "i2c_regmap.hpp"
+#include "i2c_rec.h"
+#include "twi_sim.h"
+/******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define ACCEL_ADDRESS 0x19
+
+#define CHECK(__CONDITION__) \
+do { \
+  if(!(__CONDITION__)) \
+    { \
+      std::printf("line %d: %s\n", __LINE__, #__CONDITION__); \
+      gErrors++; \
+    } \
+} while(0)
+/******************************************************************************
+ * Typedefs
+ ******************************************************************************/
+using WHO_AM_I = I2cRegister<0x0F, 1, I2cAccess::READ_ONLY>;
+using CTRL1 = I2cRegister<0x20, 1, I2cAccess::READ_WRITE, false, 0x07>;
+using CTRL2 = I2cRegister<0x21>;
+using CTRL3 = I2cRegister<0x22>;
+using CTRL4 = I2cRegister<0x23>;
+using STATUS = I2cRegister<0x27, 1, I2cAccess::READ_ONLY, true>;
+using OUT_X = I2cRegister<0x28, 2, I2cAccess::READ_ONLY, true, 0,
+                          I2cOrder::LSB_FIRST>;
+using OUT_Y = I2cRegister<0x2A, 2, I2cAccess::READ_ONLY, true, 0,
+                          I2cOrder::LSB_FIRST>;
+using OUT_Z = I2cRegister<0x2C, 2, I2cAccess::READ_ONLY, true, 0,
+                          I2cOrder::LSB_FIRST>;
+using FIFO_CTRL = I2cRegister<0x2E, 1, I2cAccess::READ_WRITE, true>;
+using FIFO_WTM = I2cRegister<0x2F, 1, I2cAccess::WRITE_ONLY>;
+using INT1_SRC = I2cRegister<0x31, 1, I2cAccess::READ_ONLY, true>;
+
+using Id = I2cField<WHO_AM_I, 0, 8>;
+using Enable = I2cField<CTRL1, 0, 3>;
+using Odr = I2cField<CTRL1, 4, 4>;
+using HighPass = I2cField<CTRL2, 0, 8>;
+using HighRes = I2cField<CTRL4, 3, 1>;
+using Scale = I2cField<CTRL4, 4, 2>;
+using DataReady = I2cField<STATUS, 3, 1>;
+using X = I2cField<OUT_X, 0, 16>;
+using Y = I2cField<OUT_Y, 0, 16>;
+using Z = I2cField<OUT_Z, 0, 16>;
+using FifoMode = I2cField<FIFO_CTRL, 6, 2>;
+using Watermark = I2cField<FIFO_WTM, 0, 5>;
+using Interrupt = I2cField<INT1_SRC, 0, 7>;
+
+using Accel = I2cRegMap<ACCEL_ADDRESS, WHO_AM_I, CTRL1, CTRL2, CTRL3, CTRL4,
+                        STATUS, OUT_X, OUT_Y, OUT_Z, FIFO_CTRL, FIFO_WTM,
+                        INT1_SRC>;
+
+//two fields of one register: one byte, nothing read
+static_assert(Accel::GetWriteCost<Odr, Enable>() == 3);
+//CTRL1 and CTRL4: the gap is sent from RAM instead of a second transaction
+static_assert(Accel::GetWriteCost<Odr, Scale>() == 6);
+//a partial write of a volatile register reads it first
+static_assert(Accel::GetWriteCost<FifoMode>() == 3 + 4);
+//the write-only byte goes in the same burst, only FIFO_CTRL is taken from
+//the read
+static_assert(Accel::GetWriteCost<FifoMode, Watermark>() == 4 + 5);
+//the fields of the registers which aren't volatile come from RAM
+static_assert(Accel::GetReadCost<Odr, Scale>() == 0);
+//a read-only register is read from the device, volatile or not
+static_assert(Accel::GetReadCost<Id>() == 3 + 1);
+//the status and the 3 axes in one burst
+static_assert(Accel::GetReadCost<DataReady, X, Y, Z>() == 3 + 7);
+//the burst doesn't go over FIFO_CTRL (volatile) and the unmapped registers
+static_assert(Accel::GetReadCost<Z, Interrupt>() == 5 + 4);
+/******************************************************************************
+ * module variables definitions
+ ******************************************************************************/
+static uint8_t gErrors;
+/******************************************************************************
+ * functions definitions
+ ******************************************************************************/
+/**
+ * @brief The bytes sent and received since the last call, without the
+ * start and the stop bits.
+ */
+static uint16_t
+GetBusBytes(void)
+{
+  uint8_t Log[I2C_REC_SIZE];
+  uint16_t Length;
+  uint16_t Bytes = 0;
+  uint16_t i;
+
+  Length = I2cRec_Read(Log, sizeof(Log));
+  for(i = 0; i < Length; i += I2C_REC_RECORD_SIZE)
+    {
+      Bytes += (Log[i] & 0x0F) != I2C_OP_START && (Log[i] & 0x0F) != I2C_OP_STOP;
+    }
+
+  return Bytes;
+}
+
+int
+main(void)
+{
+  TwiSimDevice_t* Model;
+  Id Identity;
+  Odr Rate;
+  Scale Range;
+  DataReady Ready;
+  X Ax;
+  Y Ay;
+  Z Az;
+
+  TwiSim_Init();
+  Model = TwiSim_AddDevice(I2C_0, ACCEL_ADDRESS);
+  Model->Memory[0x20] = 0x07;
+  I2c_Init(I2c_GetConfig());
+  I2cRec_Init();
+
+  CHECK(Accel::Write(I2C_0, Odr{ 5 }, Enable{ 7 }) == 1);
+  CHECK(GetBusBytes() == (Accel::GetWriteCost<Odr, Enable>()));
+  CHECK(Model->Memory[0x20] == 0x57);
+
+  CHECK(Accel::Write(I2C_0, Scale{ 2 }, HighRes{ 1 }, Odr{ 9 }) == 1);
+  CHECK(GetBusBytes() == (Accel::GetWriteCost<Scale, HighRes, Odr>()));
+  CHECK(Model->Memory[0x20] == 0x97 && Model->Memory[0x23] == 0x28);
+
+  Model->Memory[0x2E] = 0x1F;
+  CHECK(Accel::Write(I2C_0, FifoMode{ 2 }) == 1);
+  CHECK(GetBusBytes() == Accel::GetWriteCost<FifoMode>());
+  CHECK(Model->Memory[0x2E] == 0x9F);
+
+  //a write-only register doesn't read back what was written to it
+  Model->Memory[0x2F] = 0xFF;
+  CHECK(Accel::Write(I2C_0, FifoMode{ 1 }, Watermark{ 0x0A }) == 1);
+  CHECK(GetBusBytes() == (Accel::GetWriteCost<FifoMode, Watermark>()));
+  CHECK(Model->Memory[0x2E] == 0x5F && Model->Memory[0x2F] == 0x0A);
+
+  CHECK(Accel::Read(I2C_0, Rate, Range) == 1);
+  CHECK(GetBusBytes() == 0);
+  CHECK(Rate.Value == 9 && Range.Value == 2);
+
+  Model->Memory[0x0F] = 0x33;
+  CHECK(Accel::Read(I2C_0, Identity) == 1);
+  CHECK(GetBusBytes() == Accel::GetReadCost<Id>());
+  CHECK(Identity.Value == 0x33);
+
+  Model->Memory[0x27] = 0x08;
+  Model->Memory[0x28] = 0x34;
+  Model->Memory[0x29] = 0x12;
+  Model->Memory[0x2A] = 0xCD;
+  Model->Memory[0x2B] = 0xAB;
+  Model->Memory[0x2C] = 0x01;
+  Model->Memory[0x2D] = 0x80;
+  CHECK(Accel::Read(I2C_0, Ready, Ax, Ay, Az) == 1);
+  CHECK(GetBusBytes() == (Accel::GetReadCost<DataReady, X, Y, Z>()));
+  CHECK(Ready.Value == 1 && Ax.Value == 0x1234 && Ay.Value == 0xABCD &&
+        Az.Value == 0x8001);
+
+  std::printf("%u errors\n", gErrors);
+
+  return gErrors == 0 ? 0 : 1;
+}
+/*****************************End of File ************************************/
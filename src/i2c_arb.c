@@ -0,0 +1,312 @@
+/**
+ * @file i2c_arb.c
+ * @author Mohamed Hassanin
+ * @brief I2C bus arbiter. It serializes the transactions of several
+ * clients sharing the I2C peripherals. At each STOP boundary the request
+ * with the highest priority, then the earliest deadline, gets the bus.
+ * Long requests are split into chunks of I2C_ARB_CHUNK bytes, so an urgent
+ * request waits at most one chunk.
+ * @version 0.1
+ * @date 2021-05-08
+ */
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <inttypes.h>
+#include "i2c_arb.h"
+#include "i2c_queue.h"
+/******************************************************************************
+ * module variables definitions
+ ******************************************************************************/
+/**
+ * The waiting requests in the order of their submission.
+ */
+static I2cRequest_t* gQueue[I2C_ARB_QUEUE_SIZE];
+
+static uint8_t gQueueLength;
+
+/**
+ * The number of updates since the initialization. It's the time base of
+ * the deadlines.
+ */
+static uint16_t gTicks;
+/******************************************************************************
+ * functions prototypes
+ ******************************************************************************/
+static uint8_t I2cArb_Pick(const uint8_t* const Busy);
+inline static uint8_t I2cArb_IsBefore(const I2cRequest_t* const A,
+                                      const I2cRequest_t* const B);
+static uint8_t I2cArb_RunChunk(I2cRequest_t* const Request);
+static void I2cArb_Remove(const uint8_t Index);
+static void I2cArb_Drain(void);
+static void I2cArb_Complete(I2cRequest_t* const Request);
+/******************************************************************************
+ * functions definitions
+ ******************************************************************************/
+/******************************************************************************
+* Function : I2cArb_Init()
+*//**
+* \b Description:
+* initialize the arbiter <br>
+* PRE-CONDITION: I2c_Init and I2cQueue_Init are called <br>
+* POST-CONDITION: The queue is empty <br>
+* @return void
+ ******************************************************************************/
+extern void
+I2cArb_Init(void)
+{
+  gQueueLength = 0;
+  gTicks = 0;
+}
+
+/******************************************************************************
+* Function : I2cArb_Submit()
+*//**
+* \b Description:
+* Queue a request. It's started by a later call of I2cArb_Update. It must
+* only be called from the context of I2cArb_Update, the ISRs and the other
+* contexts use I2cQueue_Submit. <br>
+* PRE-CONDITION: The request isn't already queued <br>
+* POST-CONDITION: The status of the request is I2C_ARB_PENDING <br>
+* @param Request the request to queue
+* @return uint8_t 1 if the request is queued, 0 otherwise, e.g. if its
+* registers go past the register 255.
+ ******************************************************************************/
+extern uint8_t
+I2cArb_Submit(I2cRequest_t* const Request)
+{
+  if(!(Request != 0x0 && Request->I2c < I2C_MAX)) return 0;
+  if(!(Request->Data != 0x0 || Request->Length == 0)) return 0;
+  if(!(Request->Dir == I2C_ARB_WRITE || Request->Length != 0)) return 0;
+  //the register of a chunk is a byte, it mustn't wrap to the register 0
+  if(!(Request->Register + Request->Length <= 256)) return 0;
+  if(gQueueLength == I2C_ARB_QUEUE_SIZE) return 0;
+
+  Request->Done = 0;
+  Request->Status = I2C_ARB_PENDING;
+  Request->Due = gTicks + Request->Deadline;
+
+  gQueue[gQueueLength] = Request;
+  gQueueLength++;
+
+  return 1;
+}
+
+/******************************************************************************
+* Function : I2cArb_Update()
+*//**
+* \b Description:
+* Take the requests of the submission queue, then run up to
+* I2C_ARB_CHUNKS_PER_UPDATE transactions. The next request is picked again
+* after every transaction. A peripheral found busy is skipped until the
+* next update, the requests of the other ones still run. It's meant to be
+* called periodically by the scheduler. <br>
+* @return void
+ ******************************************************************************/
+extern void
+I2cArb_Update(void)
+{
+  uint8_t Busy[I2C_MAX] = { 0 };
+  uint8_t Chunks = 0;
+  uint8_t Index;
+  uint8_t Finished;
+  I2cRequest_t* Request;
+
+  gTicks++;
+
+  I2cArb_Drain();
+
+  while(Chunks < I2C_ARB_CHUNKS_PER_UPDATE)
+    {
+      Index = I2cArb_Pick(Busy);
+      if(Index == I2C_ARB_QUEUE_SIZE) break;
+
+      Request = gQueue[Index];
+      Finished = I2cArb_RunChunk(Request);
+      if(Finished == 2)
+        {
+          //the peripheral is taken by an asynchronous transfer, its chunks
+          //are retried by the next update
+          Busy[Request->I2c] = 1;
+          continue;
+        }
+
+      Chunks++;
+      if(Finished != 0)
+        {
+          I2cArb_Remove(Index);
+          I2cArb_Complete(Request);
+        }
+    }
+}
+
+/******************************************************************************
+* Function : I2cArb_Pick()
+*//**
+* \b Description:
+* Utility function to find the request to run next. <br>
+* @param Busy 1 for each peripheral whose requests are skipped
+* @return uint8_t the index of the request in the queue, I2C_ARB_QUEUE_SIZE
+* if there's none to run.
+ ******************************************************************************/
+static uint8_t
+I2cArb_Pick(const uint8_t* const Busy)
+{
+  uint8_t Best = I2C_ARB_QUEUE_SIZE;
+  uint8_t i;
+
+  for(i = 0; i < gQueueLength; i++)
+    {
+      if(Busy[gQueue[i]->I2c] != 0) continue;
+
+      if(Best == I2C_ARB_QUEUE_SIZE || I2cArb_IsBefore(gQueue[i], gQueue[Best]))
+        {
+          Best = i;
+        }
+    }
+
+  return Best;
+}
+
+/******************************************************************************
+* Function : I2cArb_IsBefore()
+*//**
+* \b Description:
+* Utility function to compare two requests. The requests with the same
+* priority and deadline keep the order of their submission. <br>
+* @param A the first request
+* @param B the second request
+* @return uint8_t 1 if A must run before B, 0 otherwise.
+ ******************************************************************************/
+inline static uint8_t
+I2cArb_IsBefore(const I2cRequest_t* const A, const I2cRequest_t* const B)
+{
+  if(A->Priority != B->Priority)
+    {
+      return A->Priority < B->Priority;
+    }
+
+  //the difference handles the wrap around of the ticks
+  return (int16_t)(A->Due - B->Due) < 0;
+}
+
+/******************************************************************************
+* Function : I2cArb_RunChunk()
+*//**
+* \b Description:
+* Utility function to run the next chunk of a request. The chunk starts at
+* the register following the last transferred byte. A chunk which isn't
+* started because the peripheral is busy (e.g. a data-ready read) leaves
+* the request as it is. <br>
+* @param Request the request to run
+* @return uint8_t 1 if the request is finished, 2 if the peripheral is busy,
+* 0 otherwise.
+ ******************************************************************************/
+static uint8_t
+I2cArb_RunChunk(I2cRequest_t* const Request)
+{
+  uint16_t Remaining = Request->Length - Request->Done;
+  uint8_t Length;
+  uint8_t Register;
+  uint8_t res;
+
+  Length = Remaining < I2C_ARB_CHUNK ? Remaining : I2C_ARB_CHUNK;
+  Register = Request->Register + Request->Done;
+
+  if(Request->Dir == I2C_ARB_WRITE)
+    {
+      res = I2c_SendBytes(Request->I2c, Request->Address, Register,
+                          &Request->Data[Request->Done], Length);
+    }
+  else
+    {
+      res = I2c_ReceiveBytes(Request->I2c, Request->Address, Register,
+                             &Request->Data[Request->Done], Length);
+    }
+
+  if(res == 6) return 2;
+
+  if(res != 1)
+    {
+      Request->Status = res;
+      return 1;
+    }
+
+  Request->Done += Length;
+  if(Request->Done == Request->Length)
+    {
+      Request->Status = 1;
+      return 1;
+    }
+
+  return 0;
+}
+
+/******************************************************************************
+* Function : I2cArb_Remove()
+*//**
+* \b Description:
+* Utility function to remove a request from the queue keeping the order of
+* the other requests. <br>
+* @param Index the index of the request in the queue
+* @return void
+ ******************************************************************************/
+static void
+I2cArb_Remove(const uint8_t Index)
+{
+  uint8_t i;
+
+  for(i = Index; i < gQueueLength - 1; i++)
+    {
+      gQueue[i] = gQueue[i + 1];
+    }
+
+  gQueueLength--;
+}
+
+/******************************************************************************
+* Function : I2cArb_Drain()
+*//**
+* \b Description:
+* Utility function to move the requests of the submission queue into the
+* arbiter while there's room. The invalid requests are completed with
+* status 0. <br>
+* @return void
+ ******************************************************************************/
+static void
+I2cArb_Drain(void)
+{
+  I2cRequest_t* Request;
+  uint8_t res;
+
+  while(gQueueLength < I2C_ARB_QUEUE_SIZE)
+    {
+      Request = I2cQueue_Receive();
+      if(Request == 0x0) break;
+
+      res = I2cArb_Submit(Request);
+      if(res == 0)
+        {
+          Request->Status = 0;
+          I2cArb_Complete(Request);
+        }
+    }
+}
+
+/******************************************************************************
+* Function : I2cArb_Complete()
+*//**
+* \b Description:
+* Utility function to notify the client of a completed request. <br>
+* @param Request the completed request
+* @return void
+ ******************************************************************************/
+static void
+I2cArb_Complete(I2cRequest_t* const Request)
+{
+  if(Request->Callback != 0x0)
+    {
+      Request->Callback(Request);
+    }
+}
+/*****************************End of File ************************************/
@@ -0,0 +1,65 @@
+/**
+ * @file i2c_arb.h
+ * @author Mohamed Hassanin
+ * @brief I2C bus arbiter header file.
+ * @version 0.1
+ * @date 2021-05-08
+ */
+#ifndef I2C_ARB_H
+#define I2C_ARB_H
+/******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define I2C_ARB_PENDING 0xFF /**< The request is waiting or in progress */
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "i2c.h"
+/******************************************************************************
+ * Typedefs
+ ******************************************************************************/
+typedef enum
+{
+  I2C_ARB_WRITE, /**< Write the data into the device registers */
+  I2C_ARB_READ, /**< Read the device registers into the data */
+}I2cArbDir_t;
+
+typedef struct I2cRequest I2cRequest_t;
+
+/**
+ * A transaction request submitted to the arbiter. The memory of the request
+ * and its data must stay valid until the request is completed.
+ */
+struct I2cRequest
+{
+  I2c_t I2c; /**< the I2c peripheral id */
+  uint8_t Address; /**< the 7-bit address of the device */
+  uint8_t Register; /**< the first register to access */
+  uint8_t* Data; /**< the bytes to write or a buffer to receive the bytes */
+  uint16_t Length; /**< the number of bytes, up to the register 255 */
+  I2cArbDir_t Dir; /**< the direction of the transfer */
+  uint8_t Priority; /**< the priority of the request, 0 is the highest */
+  uint16_t Deadline; /**< the deadline in updates from the submission */
+  void (*Callback)(I2cRequest_t* const Request); /**< called on completion,
+                                                   it can be null */
+  uint16_t Done; /**< the number of bytes transferred */
+  uint8_t Status; /**< I2C_ARB_PENDING or the result of the driver */
+  uint16_t Due; /**< the absolute deadline, used by the arbiter */
+};
+/******************************************************************************
+ * Function prototypes
+ ******************************************************************************/
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+extern void I2cArb_Init(void);
+extern uint8_t I2cArb_Submit(I2cRequest_t* const Request);
+extern void I2cArb_Update(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
+/*****************************End of File ************************************/
@@ -0,0 +1,242 @@
+/**
+ * @file i2c_budget.c
+ * @author Mohamed Hassanin
+ * @brief I2C worst-case time estimator. It walks a transaction program and
+ * adds the SCL periods of every step at the configured speed of the device,
+ * the CPU cycles of every step and the timeout budget of a failing step, so
+ * a time-triggered schedule can be checked before it runs.
+ * @version 0.1
+ * @date 2021-05-18
+ */
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <inttypes.h>
+#include "i2c_budget.h"
+/******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#if I2C_CPU_CLK < 1000000ul || (I2C_CPU_CLK % 1000000ul) != 0
+#error "I2C_CPU_CLK must be a whole number of MHz"
+#endif
+
+#define I2C_BUDGET_CYCLES_PER_US (I2C_CPU_CLK / 1000000ul)
+
+#define I2C_BUDGET_BYTE_PERIODS 9 /**< 8 data bits and the ACK bit */
+#define I2C_BUDGET_EDGE_PERIODS 1 /**< a start or a stop bit, setup and hold */
+/******************************************************************************
+ * functions prototypes
+ ******************************************************************************/
+static uint32_t I2cBudget_GetSpeed(const I2c_t I2c, const uint8_t Address);
+inline static uint32_t I2cBudget_ToUs(const uint32_t Cycles);
+/******************************************************************************
+ * functions definitions
+ ******************************************************************************/
+/******************************************************************************
+* Function : I2cBudget_Estimate()
+*//**
+* \b Description:
+* Compute the worst-case times of a transaction program. The SCL period is
+* taken from the device configuration table, or the peripheral one if the
+* device isn't listed, like the driver does. Clock stretching by the device
+* isn't included. <br>
+* PRE-CONDITION: I2c_Init is called with the table of I2c_GetConfig <br>
+* @param I2c the id of the I2C peripheral
+* @param Transfer the program and its operands
+* @param Budget a pointer to receive the times in
+* @return uint8_t 1 if the program is valid, 0 otherwise.
+ ******************************************************************************/
+extern uint8_t
+I2cBudget_Estimate(const I2c_t I2c,
+                   const I2cTransfer_t* const Transfer,
+                   I2cBudget_t* const Budget)
+{
+  if(!(I2c < I2C_MAX && Transfer != 0x0 && Transfer->Program != 0x0 &&
+      Budget != 0x0)) return 0;
+
+  const uint8_t* Pc = Transfer->Program;
+  uint32_t Periods = 0;
+  uint32_t Steps = 0;
+  uint32_t FastSteps = 0;
+  uint32_t Period;
+  uint32_t Bus;
+  uint32_t Done;
+  uint32_t Speed;
+  uint8_t Count;
+  uint8_t Op;
+
+  for(Op = *Pc; Op != I2C_OP_END; Op = *Pc)
+    {
+      Pc++;
+      Count = 1;
+      if(Op == I2C_OP_TX || Op == I2C_OP_TX_GC || Op == I2C_OP_RX_ACK)
+        {
+          Count = *Pc;
+          Pc++;
+        }
+      else if(Op == I2C_OP_RX_BLOCK)
+        {
+          //the largest block: the byte count, the data and the bytes after it
+          if(*Pc > 255 - I2C_RX_BLOCK_MAX - 1) return 0;
+          Count = 1 + I2C_RX_BLOCK_MAX + *Pc;
+          Pc++;
+        }
+
+      switch(Op)
+      {
+        case I2C_OP_START:
+        case I2C_OP_STOP:
+          Periods += I2C_BUDGET_EDGE_PERIODS;
+        break;
+
+        case I2C_OP_ADDR_W:
+        case I2C_OP_ADDR_R:
+        case I2C_OP_REG:
+        case I2C_OP_TX:
+        case I2C_OP_TX_GC:
+        case I2C_OP_RX_ACK:
+        case I2C_OP_RX_NACK:
+        case I2C_OP_RX_BLOCK:
+          Periods += (uint32_t)Count * I2C_BUDGET_BYTE_PERIODS;
+        break;
+
+        default:
+        return 0;
+      }
+
+      //the data phase but its last byte runs in the fast path
+      if(I2C_FAST_DATA == 1 && Count > 1 &&
+         (Op == I2C_OP_TX || Op == I2C_OP_RX_ACK))
+        {
+          FastSteps += Count - 1;
+          Count = 1;
+        }
+      //the byte count and the first byte of the block are steps
+      else if(I2C_FAST_DATA == 1 && Op == I2C_OP_RX_BLOCK)
+        {
+          FastSteps += Count - 3;
+          Count = 3;
+        }
+
+      Steps += Count;
+    }
+
+  Speed = I2cBudget_GetSpeed(I2c, Transfer->Address);
+  if(Speed == 0) return 0;
+
+  //the hardware rounds the period down, so rounding it up is safe
+  Period = (I2C_CPU_CLK + Speed - 1) / Speed;
+  Bus = Periods * Period;
+
+  //every step is issued, then noticed at most one poll after it finishes
+  Done = Bus + Steps * (I2C_STEP_CYCLES + I2C_POLL_CYCLES) +
+         FastSteps * (I2C_FAST_STEP_CYCLES + I2C_FAST_POLL_CYCLES);
+
+  Budget->BusUs = I2cBudget_ToUs(Bus);
+  Budget->DoneUs = I2cBudget_ToUs(Done);
+#if I2C_WAIT_STRATEGY == I2C_WAIT_SLEEP
+  //the fast path spins for the whole byte
+  Budget->CpuUs = I2cBudget_ToUs(Steps * I2C_STEP_CYCLES + FastSteps *
+                                 (I2C_BUDGET_BYTE_PERIODS * Period +
+                                  I2C_FAST_STEP_CYCLES +
+                                  I2C_FAST_POLL_CYCLES));
+#else
+  Budget->CpuUs = Budget->DoneUs;
+#endif
+  //the engine stops at the first failing step, then sends a stop bit
+  Budget->WorstUs = I2cBudget_ToUs(Done +
+                                   (uint32_t)I2C_TIMEOUT * I2C_POLL_CYCLES +
+                                   I2C_STEP_CYCLES);
+
+  return 1;
+}
+
+/******************************************************************************
+* Function : I2cBudget_CheckSchedule()
+*//**
+* \b Description:
+* Check that the transactions of every task of a schedule fit in the slot of
+* the task, even if all of them time out. It's meant to be run offline, or
+* once at start-up, on the schedule table. <br>
+* POST-CONDITION: The worst time of every task is set. It's
+* I2C_BUDGET_INVALID if a program of the task is invalid. <br>
+* @param Tasks the tasks of the schedule
+* @param Count the number of the tasks
+* @return uint8_t the number of the tasks which would overrun their slots.
+ ******************************************************************************/
+extern uint8_t
+I2cBudget_CheckSchedule(I2cBudgetTask_t* const Tasks, const uint8_t Count)
+{
+  if(!(Tasks != 0x0 || Count == 0)) return 0;
+
+  I2cBudget_t Budget;
+  uint8_t Overruns = 0;
+  uint8_t res;
+  uint8_t i;
+  uint8_t j;
+
+  for(i = 0; i < Count; i++)
+    {
+      Tasks[i].WorstUs = 0;
+
+      for(j = 0; j < Tasks[i].Count; j++)
+        {
+          res = I2cBudget_Estimate(Tasks[i].I2c, &Tasks[i].Transfers[j],
+                                   &Budget);
+          if(res == 0)
+            {
+              Tasks[i].WorstUs = I2C_BUDGET_INVALID;
+              break;
+            }
+          Tasks[i].WorstUs += Budget.WorstUs;
+        }
+
+      if(Tasks[i].WorstUs > Tasks[i].SlotUs)
+        {
+          Overruns++;
+        }
+    }
+
+  return Overruns;
+}
+
+/******************************************************************************
+* Function : I2cBudget_GetSpeed()
+*//**
+* \b Description:
+* Utility function to find the SCL frequency used for a device. <br>
+* @param I2c the id of the I2C peripheral
+* @param Address the address of the device
+* @return uint32_t the SCL frequency in Hz
+ ******************************************************************************/
+static uint32_t
+I2cBudget_GetSpeed(const I2c_t I2c, const uint8_t Address)
+{
+  const I2cDeviceConfig_t* const Devices = I2c_GetDeviceConfig();
+  uint8_t i;
+
+  for(i = 0; i < I2C_DEVICE_MAX; i++)
+    {
+      if(Devices[i].I2c == I2c && Devices[i].Address == Address)
+        {
+          return Devices[i].Speed;
+        }
+    }
+
+  return I2c_GetConfig()[I2c].Speed;
+}
+
+/******************************************************************************
+* Function : I2cBudget_ToUs()
+*//**
+* \b Description:
+* Utility function to convert CPU cycles to microseconds, rounded up. <br>
+* @param Cycles the CPU cycles
+* @return uint32_t the microseconds
+ ******************************************************************************/
+inline static uint32_t
+I2cBudget_ToUs(const uint32_t Cycles)
+{
+  return (Cycles + I2C_BUDGET_CYCLES_PER_US - 1) / I2C_BUDGET_CYCLES_PER_US;
+}
+/*****************************End of File ************************************/
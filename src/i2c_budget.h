@@ -0,0 +1,63 @@
+/**
+ * @file i2c_budget.h
+ * @author Mohamed Hassanin
+ * @brief I2C worst-case time estimator header file.
+ * @version 0.1
+ * @date 2021-05-18
+ */
+#ifndef I2C_BUDGET_H
+#define I2C_BUDGET_H
+/******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define I2C_BUDGET_INVALID 0xFFFFFFFFul /**< The time of an invalid program */
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "i2c.h"
+/******************************************************************************
+ * Typedefs
+ ******************************************************************************/
+/**
+ * The times of one transaction in microseconds, rounded up.
+ */
+typedef struct
+{
+  uint32_t BusUs; /**< the time the bus is busy */
+  uint32_t DoneUs; /**< the time the call blocks if it succeeds */
+  uint32_t CpuUs; /**< the CPU time the call takes if it succeeds */
+  uint32_t WorstUs; /**< the longest time the call blocks, a timeout
+                      included */
+}I2cBudget_t;
+
+/**
+ * A task of an offline schedule and the transactions it runs in its slot.
+ */
+typedef struct
+{
+  I2c_t I2c; /**< the I2c peripheral id */
+  const I2cTransfer_t* Transfers; /**< the transactions of the task */
+  uint8_t Count; /**< the number of the transactions */
+  uint32_t SlotUs; /**< the time reserved for the transactions */
+  uint32_t WorstUs; /**< the longest time of the transactions, set by
+                      I2cBudget_CheckSchedule */
+}I2cBudgetTask_t;
+/******************************************************************************
+ * Function prototypes
+ ******************************************************************************/
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+extern uint8_t I2cBudget_Estimate(const I2c_t I2c,
+                                  const I2cTransfer_t* const Transfer,
+                                  I2cBudget_t* const Budget);
+extern uint8_t I2cBudget_CheckSchedule(I2cBudgetTask_t* const Tasks,
+                                       const uint8_t Count);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
+/*****************************End of File ************************************/
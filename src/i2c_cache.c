@@ -0,0 +1,338 @@
+/**
+ * @file i2c_cache.c
+ * @author Mohamed Hassanin
+ * @brief I2C read-ahead cache for memory devices (EEPROMs, register files).
+ * A read which misses fetches the whole aligned line with one sequential
+ * read, so the following reads of the neighbouring bytes are served from
+ * RAM without a transaction. The lines are shared by the devices and the
+ * oldest fetched line is replaced first.
+ * @version 0.1
+ * @date 2021-05-20
+ */
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <inttypes.h>
+#include "i2c_cache.h"
+/******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#if I2C_CACHE_LINE_SIZE < 1 || \
+    (I2C_CACHE_LINE_SIZE & (I2C_CACHE_LINE_SIZE - 1)) != 0 || \
+    I2C_CACHE_LINE_SIZE > 128
+#error "I2C_CACHE_LINE_SIZE must be a power of two from 1 to 128"
+#endif
+
+#if I2C_CACHE_LINES == 0 || I2C_CACHE_LINES > 255
+#error "I2C_CACHE_LINES must be between 1 and 255"
+#endif
+
+#define I2C_CACHE_MASK ((uint8_t)(I2C_CACHE_LINE_SIZE - 1)) /**< the offset
+                                                                in a line */
+/******************************************************************************
+ * typedefs
+ ******************************************************************************/
+typedef struct
+{
+  uint8_t Valid; /**< 1 if the line holds the bytes of a device */
+  I2cDevice_t Device; /**< the device of the bytes */
+  uint8_t Base; /**< the register of the first byte, it's aligned */
+  uint8_t Data[I2C_CACHE_LINE_SIZE]; /**< the bytes */
+}I2cCacheLine_t;
+/******************************************************************************
+ * module variables definitions
+ ******************************************************************************/
+static I2cCacheLine_t gLine[I2C_CACHE_LINES];
+
+static uint8_t gNext; /**< the next line to replace */
+
+static I2cCacheStats_t gStats;
+/******************************************************************************
+ * functions prototypes
+ ******************************************************************************/
+static I2cCacheLine_t* I2cCache_Find(const I2cDevice_t Device,
+                                     const uint8_t Base);
+static void I2cCache_Observe(const I2c_t I2c,
+                             const uint8_t Address,
+                             const uint8_t Register,
+                             const uint16_t Length);
+static uint8_t I2cCache_Fill(const I2cDevice_t Device,
+                             const uint8_t Base,
+                             I2cCacheLine_t** const Line);
+/******************************************************************************
+ * functions definitions
+ ******************************************************************************/
+/******************************************************************************
+* Function : I2cCache_Init()
+*//**
+* \b Description:
+* initialize the cache. It's set as the write observer of the driver, so
+* the registers written by the programs of the driver are dropped. <br>
+* PRE-CONDITION: I2c_Init is called <br>
+* POST-CONDITION: All the lines are invalid <br>
+* @return void
+ ******************************************************************************/
+extern void
+I2cCache_Init(void)
+{
+  uint8_t i;
+
+  for(i = 0; i < I2C_CACHE_LINES; i++)
+    {
+      gLine[i].Valid = 0;
+    }
+
+  gNext = 0;
+  gStats.Hits = 0;
+  gStats.Misses = 0;
+
+  I2c_SetWriteObserver(I2cCache_Observe);
+}
+
+/******************************************************************************
+* Function : I2cCache_Read()
+*//**
+* \b Description:
+* Read successive registers of a device through the cache. The lines which
+* aren't cached are read from the device, a whole line at a time. <br>
+* @param Device the device, its bus and address are taken from the device
+* configuration table
+* @param Register the first register to read
+* @param Data a pointer to receive the bytes in
+* @param Length the number of the bytes to read. The last register must not
+* be beyond 255.
+* @return uint8_t 1 the operations is done successfully, the result of
+* I2c_ReceiveBytes otherwise.
+ ******************************************************************************/
+extern uint8_t
+I2cCache_Read(const I2cDevice_t Device,
+              const uint8_t Register,
+              uint8_t* const Data,
+              const uint8_t Length)
+{
+  if(!(Device < I2C_DEVICE_MAX && (Data != 0x0 || Length == 0))) return 0;
+  if(!((uint16_t)Register + Length <= 256)) return 0;
+
+  I2cCacheLine_t* Line;
+  uint8_t Offset = Register & I2C_CACHE_MASK;
+  uint8_t Base = Register - Offset;
+  uint8_t Done = 0;
+  uint8_t Count;
+  uint8_t res;
+
+  while(Done < Length)
+    {
+      Line = I2cCache_Find(Device, Base);
+      if(Line == 0x0)
+        {
+          res = I2cCache_Fill(Device, Base, &Line);
+          if(res != 1) return res;
+        }
+      else
+        {
+          gStats.Hits++;
+        }
+
+      Count = I2C_CACHE_LINE_SIZE - Offset;
+      if(Count > Length - Done)
+        {
+          Count = Length - Done;
+        }
+
+      for(; Count != 0; Count--)
+        {
+          Data[Done] = Line->Data[Offset];
+          Offset++;
+          Done++;
+        }
+
+      Base += I2C_CACHE_LINE_SIZE;
+      Offset = 0;
+    }
+
+  return 1;
+}
+
+/******************************************************************************
+* Function : I2cCache_Write()
+*//**
+* \b Description:
+* Write successive registers of a device and invalidate the lines holding
+* them. The lines aren't updated because a device may not store the bytes
+* as sent, e.g. an EEPROM wraps the writes around its page. <br>
+* @param Device the device, its bus and address are taken from the device
+* configuration table
+* @param Register the first register to write
+* @param Data the bytes to write
+* @param Length the number of the bytes to write, 0 only sends the register
+* and drops no line
+* @return uint8_t the result of I2c_SendBytes
+ ******************************************************************************/
+extern uint8_t
+I2cCache_Write(const I2cDevice_t Device,
+               const uint8_t Register,
+               const uint8_t* const Data,
+               const uint8_t Length)
+{
+  if(!(Device < I2C_DEVICE_MAX)) return 0;
+
+  const I2cDeviceConfig_t* const Config = &I2c_GetDeviceConfig()[Device];
+
+  //no register changes, and a Length of 0 would drop the whole device
+  if(Length == 0)
+    {
+      return I2c_SendBytes(Config->I2c, Config->Address, Register, Data, 0);
+    }
+
+  //even a failed write may have changed some bytes
+  I2cCache_Invalidate(Device, Register, Length);
+
+  return I2c_SendBytes(Config->I2c, Config->Address, Register, Data, Length);
+}
+
+/******************************************************************************
+* Function : I2cCache_Invalidate()
+*//**
+* \b Description:
+* Drop the cached registers of a device. It must be called after the
+* registers are changed without the driver, e.g. by I2c_Write or by the
+* device itself. <br>
+* @param Device the device
+* @param Register the first changed register
+* @param Length the number of the changed registers. 0 drops all the
+* registers of the device.
+* @return void
+ ******************************************************************************/
+extern void
+I2cCache_Invalidate(const I2cDevice_t Device,
+                    const uint8_t Register,
+                    const uint8_t Length)
+{
+  const uint16_t First = Register & ~I2C_CACHE_MASK;
+  const uint16_t End = (uint16_t)Register + Length;
+  uint8_t i;
+
+  for(i = 0; i < I2C_CACHE_LINES; i++)
+    {
+      if(gLine[i].Valid != 0 && gLine[i].Device == Device &&
+        (Length == 0 || (gLine[i].Base >= First && gLine[i].Base < End)))
+        {
+          gLine[i].Valid = 0;
+        }
+    }
+}
+
+/******************************************************************************
+* Function : I2cCache_GetStats()
+*//**
+* \b Description:
+* Get the hits and the misses since the initialization. <br>
+* @param Stats a pointer to receive the statistics in
+* @return void
+ ******************************************************************************/
+extern void
+I2cCache_GetStats(I2cCacheStats_t* const Stats)
+{
+  if(!(Stats != 0x0)) return;
+
+  *Stats = gStats;
+}
+
+/******************************************************************************
+* Function : I2cCache_Observe()
+*//**
+* \b Description:
+* Utility function to drop the registers written by a program of the
+* driver from the devices at its bus and address. <br>
+* @param I2c the id of the I2C peripheral
+* @param Address the address of the device
+* @param Register the first written register
+* @param Length the number of the written registers
+* @return void
+ ******************************************************************************/
+static void
+I2cCache_Observe(const I2c_t I2c,
+                 const uint8_t Address,
+                 const uint8_t Register,
+                 const uint16_t Length)
+{
+  const I2cDeviceConfig_t* const Config = I2c_GetDeviceConfig();
+  uint8_t i;
+
+  for(i = 0; i < I2C_DEVICE_MAX; i++)
+    {
+      if(Config[i].I2c == I2c && Config[i].Address == Address)
+        {
+          //the writes beyond 255 wrap around, so they drop the whole device
+          I2cCache_Invalidate(Config[i].Device, Register,
+                              Length > 255 ? 0 : Length);
+        }
+    }
+}
+
+/******************************************************************************
+* Function : I2cCache_Find()
+*//**
+* \b Description:
+* Utility function to find the line of a device register. <br>
+* @param Device the device
+* @param Base the first register of the line
+* @return I2cCacheLine_t* the line, null if it isn't cached.
+ ******************************************************************************/
+static I2cCacheLine_t*
+I2cCache_Find(const I2cDevice_t Device, const uint8_t Base)
+{
+  uint8_t i;
+
+  for(i = 0; i < I2C_CACHE_LINES; i++)
+    {
+      if(gLine[i].Valid != 0 && gLine[i].Device == Device &&
+        gLine[i].Base == Base)
+        {
+          return &gLine[i];
+        }
+    }
+
+  return 0x0;
+}
+
+/******************************************************************************
+* Function : I2cCache_Fill()
+*//**
+* \b Description:
+* Utility function to read a line from a device into the oldest line. <br>
+* @param Device the device
+* @param Base the first register of the line
+* @param Line a pointer to receive the filled line in
+* @return uint8_t the result of I2c_ReceiveBytes
+ ******************************************************************************/
+static uint8_t
+I2cCache_Fill(const I2cDevice_t Device,
+              const uint8_t Base,
+              I2cCacheLine_t** const Line)
+{
+  const I2cDeviceConfig_t* const Config = &I2c_GetDeviceConfig()[Device];
+  I2cCacheLine_t* const Victim = &gLine[gNext];
+  uint8_t res;
+
+  gNext++;
+  if(gNext == I2C_CACHE_LINES)
+    {
+      gNext = 0;
+    }
+
+  gStats.Misses++;
+
+  Victim->Valid = 0;
+  res = I2c_ReceiveBytes(Config->I2c, Config->Address, Base, Victim->Data,
+                         I2C_CACHE_LINE_SIZE);
+  if(res != 1) return res;
+
+  Victim->Device = Device;
+  Victim->Base = Base;
+  Victim->Valid = 1;
+  *Line = Victim;
+
+  return 1;
+}
+/*****************************End of File ************************************/
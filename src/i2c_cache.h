@@ -0,0 +1,48 @@
+/**
+ * @file i2c_cache.h
+ * @author Mohamed Hassanin
+ * @brief I2C read-ahead cache header file.
+ * @version 0.1
+ * @date 2021-05-20
+ */
+#ifndef I2C_CACHE_H
+#define I2C_CACHE_H
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "i2c.h"
+/******************************************************************************
+ * Typedefs
+ ******************************************************************************/
+typedef struct
+{
+  uint32_t Hits; /**< Number of lines served from RAM */
+  uint32_t Misses; /**< Number of lines read from the devices */
+}I2cCacheStats_t;
+/******************************************************************************
+ * Function prototypes
+ ******************************************************************************/
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+extern void I2cCache_Init(void);
+extern uint8_t I2cCache_Read(const I2cDevice_t Device,
+                             const uint8_t Register,
+                             uint8_t* const Data,
+                             const uint8_t Length);
+extern uint8_t I2cCache_Write(const I2cDevice_t Device,
+                              const uint8_t Register,
+                              const uint8_t* const Data,
+                              const uint8_t Length);
+extern void I2cCache_Invalidate(const I2cDevice_t Device,
+                                const uint8_t Register,
+                                const uint8_t Length);
+extern void I2cCache_GetStats(I2cCacheStats_t* const Stats);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
+/*****************************End of File ************************************/
@@ -24,7 +24,36 @@
 static const I2cConfig_t I2cConfig[] =
 {
   //TODO: configure your UART peripherals
-  { I2C_0, 100000 }
+  { I2C_0, 100000 },
+#ifdef I2C_SIM
+  { I2C_1, 100000 }
+#endif
+};
+
+/**
+* The following array contains the configuration data for each device
+* that runs at an SCL speed other than the speed of its I2C peripheral.
+* Each row represents a device. Each column is representing a member of the
+* I2cDeviceConfig_t structure. This table is read in by I2c_Init, where the
+* SCL register values of each device are computed once.
+*/
+static const I2cDeviceConfig_t I2cDeviceConfig[] =
+{
+  //TODO: configure your devices
+  { I2C_DEVICE_0, I2C_0, 0x50, 400000 },
+  { I2C_DEVICE_1, I2C_0, 0x52, 50000 }
+};
+
+/**
+* The following array contains the configuration data for each device
+* data-ready line. Each row represents a line. Each column is representing a
+* member of the I2cDrdyConfig_t structure. This table is read in by
+* I2cDrdy_Init, where the burst read of each line is prepared once.
+*/
+static const I2cDrdyConfig_t I2cDrdyConfig[] =
+{
+  //TODO: configure your data-ready lines
+  { I2C_DRDY_0, I2C_DEVICE_0, 0x28, 6 }
 };
 /******************************************************************************
 * Function Definitions
@@ -55,4 +84,37 @@ I2c_GetConfig(void)
   */
   return (const I2cConfig_t *) I2cConfig;
 }
+
+/******************************************************************************
+* Function : I2c_GetDeviceConfig()
+*//**
+* \b Description:
+* This function is used to get the device configuration handle of the I2C <br>
+* POST-CONDITION: A constant pointer to the first member of the device
+* configuration table will be returned. <br>
+* @return A pointer to the device configuration table.
+* @see I2c_Init
+ ******************************************************************************/
+extern const I2cDeviceConfig_t *
+I2c_GetDeviceConfig(void)
+{
+  return (const I2cDeviceConfig_t *) I2cDeviceConfig;
+}
+
+/******************************************************************************
+* Function : I2c_GetDrdyConfig()
+*//**
+* \b Description:
+* This function is used to get the data-ready configuration handle of the
+* I2C <br>
+* POST-CONDITION: A constant pointer to the first member of the data-ready
+* configuration table will be returned. <br>
+* @return A pointer to the data-ready configuration table.
+* @see I2cDrdy_Init
+ ******************************************************************************/
+extern const I2cDrdyConfig_t *
+I2c_GetDrdyConfig(void)
+{
+  return (const I2cDrdyConfig_t *) I2cDrdyConfig;
+}
 /*****************************End of File ************************************/
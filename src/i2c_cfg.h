@@ -17,6 +17,235 @@
  * TODO: change this as required.
  */
 #define I2C_TIMEOUT 3000
+
+/**
+ * @brief The CPU clock in Hz.
+ * TODO: change this as required.
+ */
+#define I2C_CPU_CLK 12000000ul
+
+/**
+ * @brief The worst-case CPU cycles of one step of a transaction: writing the
+ * command, checking the status and moving to the next op. It's used by the
+ * estimator of i2c_budget.
+ * TODO: measure it for the MCU and the compiler options.
+ */
+#define I2C_STEP_CYCLES 120
+
+/**
+ * @brief The worst-case CPU cycles of one iteration of the wait loop. The
+ * longest a failing step can block is I2C_TIMEOUT iterations. In
+ * I2C_WAIT_SLEEP, it's the period of the slowest wake-up source instead.
+ * TODO: measure it for the MCU and the compiler options.
+ */
+#define I2C_POLL_CYCLES 20
+
+/**
+ * @brief Set to 1 to run the data phase of the blocking transfers (the
+ * bytes of I2C_OP_TX and I2C_OP_RX_ACK but the last one) in a tight loop
+ * which spins on the flag and loads the next byte right away. It keeps the
+ * bus busy between the bytes, but the CPU spins for the whole burst even in
+ * I2C_WAIT_SLEEP.
+ * TODO: change this as required.
+ */
+#define I2C_FAST_DATA 1
+
+/**
+ * @brief The worst-case CPU cycles of the fast data path from the flag to
+ * the next command, and of one iteration of its poll loop. The bus idles
+ * for at most their sum between two bytes of the data phase.
+ * TODO: measure them for the MCU and the compiler options.
+ */
+#define I2C_FAST_STEP_CYCLES 16
+#define I2C_FAST_POLL_CYCLES 8
+
+#define I2C_WAIT_POLL 0 /**< Busy poll the flag until the hardware finishes */
+#define I2C_WAIT_SLEEP 1 /**< Sleep in idle mode until the I2C interrupt fires */
+
+/**
+ * @brief The strategy used to wait for the hardware to finish working.
+ * In I2C_WAIT_SLEEP, the global interrupts must be enabled and I2C_TIMEOUT
+ * counts the wake-ups instead of the polls, so another interrupt (e.g. the
+ * scheduler tick) must be running to detect a stuck bus. It can be set by
+ * the build, like the tests of the sleep do.
+ * TODO: change this as required.
+ */
+#ifndef I2C_WAIT_STRATEGY
+#define I2C_WAIT_STRATEGY I2C_WAIT_POLL
+#endif
+
+/**
+ * @brief Set to 1 to advance the asynchronous transfers (I2c_TransferAsync)
+ * from the I2C interrupt, 0 to advance them from I2c_Poll. It can be set by
+ * the build.
+ * TODO: change this as required.
+ */
+#ifndef I2C_ASYNC_IRQ
+#define I2C_ASYNC_IRQ 0
+#endif
+
+/**
+ * @brief Set to 1 to count the CPU cycles spent asleep and spinning while
+ * waiting for the hardware. See I2c_GetWaitStats. It can be set by the
+ * build.
+ */
+#ifndef I2C_WAIT_STATS
+#define I2C_WAIT_STATS 0
+#endif
+
+/**
+ * @brief A free running 16-bit counter incremented every CPU cycle. It's
+ * used by the wait statistics (I2C_WAIT_STATS) and the bus recorder.
+ * The host simulation (I2C_SIM) counts the cycles of its clock.
+ * TODO: map it to a timer clocked by the system clock.
+ */
+#ifdef I2C_SIM
+#define I2C_GET_CYCLES() ((uint16_t)TwiSim_GetClock())
+#else
+#define I2C_GET_CYCLES() ((uint16_t)0)
+#endif
+
+/**
+ * @brief Set to 1 to give every step of the transactions to the recorder
+ * set by I2c_SetRecorder, 0 to compile the calls out.
+ */
+#define I2C_RECORDER 1
+
+/**
+ * @brief The number of bytes of the log of the bus recorder (i2c_rec), 5
+ * bytes per step. It must be a power of two and at most 32768.
+ * TODO: change this as required.
+ */
+#define I2C_REC_SIZE 256
+
+/**
+ * @brief The maximum number of requests waiting in the arbiter.
+ * TODO: change this as required.
+ */
+#define I2C_ARB_QUEUE_SIZE 8
+
+/**
+ * @brief The maximum number of bytes transferred in one transaction by the
+ * arbiter. Longer requests are split so that urgent requests can get in
+ * between the chunks.
+ * TODO: change this as required.
+ */
+#define I2C_ARB_CHUNK 16
+
+/**
+ * @brief The maximum number of transactions run by one call of
+ * I2cArb_Update. It bounds the execution time of the update.
+ * TODO: change this as required.
+ */
+#define I2C_ARB_CHUNKS_PER_UPDATE 4
+
+/**
+ * @brief The maximum number of requests waiting in the submission queue. It
+ * must be a power of two and at most 128.
+ * TODO: change this as required.
+ */
+#define I2C_QUEUE_SIZE 8
+
+/**
+ * @brief Set to 1 to compute the SMBus PEC with a 16 entries table instead
+ * of a 256 entries one. It saves 240 bytes for two lookups per byte.
+ * TODO: change this as required.
+ */
+#define I2C_SMBUS_PEC_NIBBLE_TABLE 0
+
+/**
+ * @brief The number of bytes of a line of the read-ahead cache (i2c_cache).
+ * A miss reads the whole aligned line. It must be a power of two and at
+ * most 128.
+ * TODO: change this as required.
+ */
+#define I2C_CACHE_LINE_SIZE 16
+
+/**
+ * @brief The number of lines of the read-ahead cache. They're shared by all
+ * the devices.
+ * TODO: change this as required.
+ */
+#define I2C_CACHE_LINES 4
+
+/**
+ * @brief The samples buffered per device by the data-ready acquisition
+ * (i2c_drdy), and the maximum size in bytes of a sample. The depth must be
+ * a power of two and at most 128.
+ * TODO: change this as required.
+ */
+#define I2C_DRDY_DEPTH 4
+#define I2C_DRDY_SAMPLE_SIZE 6
+
+/**
+ * @brief A free running 32-bit time taken by i2c_drdy at the data-ready
+ * edge and at the end of the read of a sample. The host simulation
+ * (I2C_SIM) counts the cycles of its clock.
+ * TODO: map it to the time base of the application.
+ */
+#ifdef I2C_SIM
+#define I2C_DRDY_GET_TIME() TwiSim_GetClock()
+#else
+#define I2C_DRDY_GET_TIME() ((uint32_t)0)
+#endif
+
+/**
+ * @brief The number and the size in bytes of the static coroutine frames of
+ * the tasks of i2c_co.hpp. A task whose frame doesn't fit isn't started.
+ * Every co_await of a transfer takes about 10 pointers and 12 bytes of the
+ * frame.
+ * TODO: change this as required.
+ */
+#define I2C_CO_FRAMES 4
+#define I2C_CO_FRAME_SIZE 512
+
+/**
+ * @brief Set to 1 to decode the 16-bit samples of i2c_sample 8 at a time
+ * with the vector extensions of GCC (SSE2 or NEON), 0 for a scalar loop.
+ * The AVR has no vector unit, the host simulation (I2C_SIM) uses them. It
+ * can be set by the build.
+ */
+#ifndef I2C_SAMPLE_VECTOR
+#ifdef I2C_SIM
+#define I2C_SAMPLE_VECTOR 1
+#else
+#define I2C_SAMPLE_VECTOR 0
+#endif
+#endif
+
+/**
+ * @brief The descriptors (an asynchronous transfer or a request of the
+ * arbiter) and the data buffers of the static pool (i2c_pool), and the
+ * bytes of a buffer. There are at most 254 of each.
+ * TODO: shrink them to the peaks of I2cPool_GetStats.
+ */
+#define I2C_POOL_DESCRIPTOR_COUNT 8
+#define I2C_POOL_BUFFER_COUNT 4
+#define I2C_POOL_BUFFER_SIZE 16
+
+/**
+ * @brief The bytes of RAM the pool may take with its bookkeeping. It's
+ * checked at compile time. A descriptor is the larger of I2cTransfer_t and
+ * I2cRequest_t.
+ * TODO: change this as required.
+ */
+#define I2C_POOL_RAM_BUDGET 512
+
+/**
+ * @brief The type, entering and exiting of a critical section. Entering
+ * saves the state of the interrupts in a variable of I2C_CRITICAL_STATE
+ * and disables them, exiting restores the saved state. The host simulation
+ * (I2C_SIM) runs the interrupt made pending by TwiSim_SetInterrupt on exit.
+ * TODO: implement them for the MCU.
+ */
+#define I2C_CRITICAL_STATE uint8_t
+#define I2C_ENTER_CRITICAL(__STATE__) do { (__STATE__) = 0; } while(0)
+#ifdef I2C_SIM
+#define I2C_EXIT_CRITICAL(__STATE__) \
+do { (void)(__STATE__); TwiSim_ExitCritical(); } while(0)
+#else
+#define I2C_EXIT_CRITICAL(__STATE__) do { (void)(__STATE__); } while(0)
+#endif
 /******************************************************************************
  * Includes
  ******************************************************************************/
@@ -33,14 +262,60 @@ typedef enum
 {
   /* TODO: Populate this list based on the MCU */
   I2C_0,
+#ifdef I2C_SIM
+  I2C_1, /* the second bus of the host simulation */
+#endif
   I2C_MAX
 }I2c_t;
 
+/**
+* Defines an enumerated list of all the devices connected to the I2C
+* peripherals that need their own SCL speed. The last element is used to
+* specify the maximum number of enumerated labels.
+*/
+typedef enum
+{
+  /* TODO: Populate this list based on the devices on the buses */
+  I2C_DEVICE_0,
+  I2C_DEVICE_1,
+  I2C_DEVICE_MAX
+}I2cDevice_t;
+
+/**
+* Defines an enumerated list of all the devices whose data-ready line is
+* connected to an external interrupt, see i2c_drdy. The last element is used
+* to specify the maximum number of enumerated labels.
+*/
+typedef enum
+{
+  /* TODO: Populate this list based on the data-ready lines */
+  I2C_DRDY_0,
+  I2C_DRDY_MAX
+}I2cDrdySource_t;
+
 typedef struct
 {
   I2c_t I2c; /**< the I2c peripheral id */
-  uint32_t Speed; /**< the speed of the I2C SCL clock rate in Hz (max 400KHz) */
+  uint32_t Speed; /**< the speed of the I2C SCL clock rate in Hz (max 400KHz).
+                    It's used for the devices not listed in the device table */
 }I2cConfig_t;
+
+typedef struct
+{
+  I2cDevice_t Device; /**< the device id */
+  I2c_t I2c; /**< the I2c peripheral the device is connected to */
+  uint8_t Address; /**< the 7-bit address of the device */
+  uint32_t Speed; /**< the maximum SCL clock rate of the device in Hz
+                    (max 400KHz) */
+}I2cDeviceConfig_t;
+
+typedef struct
+{
+  I2cDrdySource_t Source; /**< the data-ready line id */
+  I2cDevice_t Device; /**< the device of the line, from the device table */
+  uint8_t Register; /**< the first register of a sample */
+  uint8_t Length; /**< the bytes of a sample (max I2C_DRDY_SAMPLE_SIZE) */
+}I2cDrdyConfig_t;
 /******************************************************************************
  * Function prototypes
  ******************************************************************************/
@@ -49,6 +324,12 @@ extern "C"{
 #endif
 
 extern const I2cConfig_t* I2c_GetConfig(void);
+extern const I2cDeviceConfig_t* I2c_GetDeviceConfig(void);
+extern const I2cDrdyConfig_t* I2c_GetDrdyConfig(void);
+#ifdef I2C_SIM
+extern uint32_t TwiSim_GetClock(void); /**< see twi_sim.h */
+extern void TwiSim_ExitCritical(void); /**< see twi_sim.h */
+#endif
 
 #ifdef __cplusplus
 } // extern "C"
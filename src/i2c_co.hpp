@@ -0,0 +1,406 @@
+/**
+ * @file i2c_co.hpp
+ * @author Mohamed Hassanin
+ * @brief C++20 coroutine layer over the asynchronous transfers. A device
+ * state machine is written as an I2cTask which awaits the transfers of an
+ * I2cBus:
+ *
+ *   I2cTask Sensor(I2cBus& Bus)
+ *   {
+ *     uint8_t Data[6];
+ *     co_await Bus.Write(0x1D, 0x2A, &Config, 1);
+ *     for(;;)
+ *       {
+ *         if(co_await Bus.Read(0x1D, 0x01, Data, 6) == 1) { ... }
+ *       }
+ *   }
+ *
+ * The awaiting task is suspended while its transfer runs, so many tasks
+ * share a bus without blocking: their transfers are started one after the
+ * other in the order they're awaited. The tasks are resumed by
+ * I2cBus::Poll, never from the I2C interrupt. The frames of the tasks are
+ * taken from a static pool (I2C_CO_FRAMES, I2C_CO_FRAME_SIZE), there's no
+ * heap. It needs a compiler with the <coroutine> header.
+ * @version 0.1
+ * @date 2021-05-24
+ */
+#ifndef I2C_CO_HPP
+#define I2C_CO_HPP
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <coroutine>
+#include <cstddef>
+#include "i2c.h"
+/******************************************************************************
+ * Classes
+ ******************************************************************************/
+/**
+ * @brief The static pool of the coroutine frames. It's only used from the
+ * main loop: the tasks are created and destroyed there.
+ */
+class I2cFramePool
+{
+public:
+  static void* Allocate(const std::size_t Size) noexcept
+  {
+    if(!(Size <= I2C_CO_FRAME_SIZE)) return nullptr;
+
+    for(uint8_t i = 0; i < I2C_CO_FRAMES; i++)
+      {
+        if(Used[i] == 0)
+          {
+            Used[i] = 1;
+            return Frame[i];
+          }
+      }
+
+    return nullptr;
+  }
+
+  static void Free(void* const Block) noexcept
+  {
+    for(uint8_t i = 0; i < I2C_CO_FRAMES; i++)
+      {
+        if(Block == Frame[i])
+          {
+            Used[i] = 0;
+          }
+      }
+  }
+
+  static uint8_t GetUsed() noexcept
+  {
+    uint8_t Count = 0;
+
+    for(uint8_t i = 0; i < I2C_CO_FRAMES; i++)
+      {
+        Count += Used[i];
+      }
+
+    return Count;
+  }
+
+private:
+  alignas(std::max_align_t) static inline uint8_t
+    Frame[I2C_CO_FRAMES][I2C_CO_FRAME_SIZE];
+  static inline uint8_t Used[I2C_CO_FRAMES];
+};
+
+/**
+ * @brief A device state machine. It runs until its first co_await when it's
+ * called. Its frame is freed when the task is destroyed. A task whose frame
+ * doesn't fit in the pool isn't valid and never runs.
+ */
+class I2cTask
+{
+public:
+  struct promise_type
+  {
+    static void* operator new(const std::size_t Size) noexcept
+    {
+      return I2cFramePool::Allocate(Size);
+    }
+
+    static void operator delete(void* const Block) noexcept
+    {
+      I2cFramePool::Free(Block);
+    }
+
+    static I2cTask get_return_object_on_allocation_failure() noexcept
+    {
+      return I2cTask();
+    }
+
+    I2cTask get_return_object() noexcept
+    {
+      return I2cTask(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept {}
+  };
+
+  I2cTask() noexcept = default;
+
+  I2cTask(I2cTask&& Other) noexcept : Handle(Other.Handle)
+  {
+    Other.Handle = nullptr;
+  }
+
+  I2cTask& operator=(I2cTask&& Other) noexcept
+  {
+    if(this != &Other)
+      {
+        Destroy();
+        Handle = Other.Handle;
+        Other.Handle = nullptr;
+      }
+    return *this;
+  }
+
+  I2cTask(const I2cTask&) = delete;
+  I2cTask& operator=(const I2cTask&) = delete;
+
+  ~I2cTask() { Destroy(); }
+
+  bool IsValid() const noexcept { return Handle != nullptr; }
+  bool IsDone() const noexcept { return Handle == nullptr || Handle.done(); }
+
+private:
+  explicit I2cTask(const std::coroutine_handle<promise_type> Frame) noexcept :
+    Handle(Frame)
+  {
+  }
+
+  //a task mustn't be destroyed while its transfer runs
+  void Destroy() noexcept
+  {
+    if(Handle != nullptr)
+      {
+        Handle.destroy();
+        Handle = nullptr;
+      }
+  }
+
+  std::coroutine_handle<promise_type> Handle = nullptr;
+};
+
+class I2cBus;
+
+/**
+ * @brief A transfer awaited by a task. co_await gives its result, see
+ * I2c_Transfer. It lives in the frame of the task while it runs.
+ */
+class I2cAwait
+{
+public:
+  bool await_ready() const noexcept { return Status != I2C_PENDING; }
+  inline void await_suspend(const std::coroutine_handle<> Task) noexcept;
+  uint8_t await_resume() const noexcept { return Status; }
+
+private:
+  friend class I2cBus;
+
+  I2cAwait(I2cBus& Owner, const uint8_t Result) noexcept :
+    Transfer{ nullptr, 0, 0, nullptr, nullptr, nullptr, nullptr },
+    Bus(&Owner), Status(Result)
+  {
+  }
+
+  I2cTransfer_t Transfer; /**< the first member, see I2cBus::Done */
+  I2cBus* Bus;
+  I2cAwait* Next = nullptr; /**< the next request of the same list */
+  std::coroutine_handle<> Task;
+  uint8_t Program[10]; /**< the program of Read and Write */
+  uint8_t Status;
+};
+
+/**
+ * @brief The transfers of the tasks on an I2C peripheral. Poll must be
+ * called from the main loop. There must be one I2cBus per peripheral, and
+ * the blocking functions of the driver mustn't be used on it meanwhile.
+ */
+class I2cBus
+{
+public:
+  explicit I2cBus(const I2c_t Id) noexcept : I2c(Id) {}
+
+  I2cBus(const I2cBus&) = delete;
+  I2cBus& operator=(const I2cBus&) = delete;
+
+  /**
+   * @brief Read successive registers of a device, see I2c_ReceiveBytes.
+   */
+  I2cAwait Read(const uint8_t Address,
+                  const uint8_t Register,
+                  uint8_t* const Data,
+                  const uint8_t Length) noexcept
+  {
+    I2cAwait Request(*this, (Data != nullptr && Length != 0) ?
+                       I2C_PENDING : 0);
+    uint8_t i = 0;
+
+    Request.Program[i++] = I2C_OP_START;
+    Request.Program[i++] = I2C_OP_ADDR_W;
+    Request.Program[i++] = I2C_OP_REG;
+    Request.Program[i++] = I2C_OP_START;
+    Request.Program[i++] = I2C_OP_ADDR_R;
+    if(Length > 1)
+      {
+        Request.Program[i++] = I2C_OP_RX_ACK;
+        Request.Program[i++] = Length - 1;
+      }
+    Request.Program[i++] = I2C_OP_RX_NACK;
+    Request.Program[i++] = I2C_OP_STOP;
+    Request.Program[i] = I2C_OP_END;
+
+    Request.Transfer.Address = Address;
+    Request.Transfer.Register = Register;
+    Request.Transfer.RxData = Data;
+
+    return Request;
+  }
+
+  /**
+   * @brief Write successive registers of a device, see I2c_SendBytes.
+   */
+  I2cAwait Write(const uint8_t Address,
+                   const uint8_t Register,
+                   const uint8_t* const Data,
+                   const uint8_t Length) noexcept
+  {
+    I2cAwait Request(*this, (Data != nullptr || Length == 0) ?
+                       I2C_PENDING : 0);
+
+    Request.Program[0] = I2C_OP_START;
+    Request.Program[1] = I2C_OP_ADDR_W;
+    Request.Program[2] = I2C_OP_REG;
+    Request.Program[3] = I2C_OP_TX;
+    Request.Program[4] = Length;
+    Request.Program[5] = I2C_OP_STOP;
+    Request.Program[6] = I2C_OP_END;
+
+    Request.Transfer.Address = Address;
+    Request.Transfer.Register = Register;
+    Request.Transfer.TxData = Data;
+
+    return Request;
+  }
+
+  /**
+   * @brief Run a program, see I2c_Transfer. Its callback isn't called.
+   */
+  I2cAwait Run(const I2cTransfer_t& Transfer) noexcept
+  {
+    I2cAwait Request(*this, Transfer.Program != nullptr ? I2C_PENDING : 0);
+
+    Request.Transfer = Transfer;
+
+    return Request;
+  }
+
+  /**
+   * @brief Advance the transfers and resume the tasks whose transfer ended.
+   */
+  void Poll() noexcept
+  {
+    I2C_CRITICAL_STATE State;
+    I2cAwait* Request;
+
+    I2c_Poll();
+
+    //a transfer which found the peripheral busy is retried
+    I2C_ENTER_CRITICAL(State);
+    StartNext();
+    I2C_EXIT_CRITICAL(State);
+
+    for(;;)
+      {
+        I2C_ENTER_CRITICAL(State);
+        Request = ReadyHead;
+        if(Request != nullptr)
+          {
+            ReadyHead = Request->Next;
+          }
+        I2C_EXIT_CRITICAL(State);
+
+        if(Request == nullptr) break;
+
+        Request->Task.resume();
+      }
+  }
+
+private:
+  friend class I2cAwait;
+
+  void Submit(I2cAwait* const Request, const std::coroutine_handle<> Task)
+    noexcept
+  {
+    I2C_CRITICAL_STATE State;
+
+    if(Request->Transfer.Program == nullptr)
+      {
+        Request->Transfer.Program = Request->Program;
+      }
+    Request->Transfer.Callback = Done;
+    Request->Task = Task;
+    Request->Next = nullptr;
+
+    I2C_ENTER_CRITICAL(State);
+    Append(&WaitHead, Request);
+    StartNext();
+    I2C_EXIT_CRITICAL(State);
+  }
+
+  //PRE-CONDITION: in a critical section or in the I2C interrupt
+  void StartNext() noexcept
+  {
+    I2cAwait* Request;
+    uint8_t res;
+
+    while(Current == nullptr && WaitHead != nullptr)
+      {
+        Request = WaitHead;
+        WaitHead = Request->Next;
+        Current = Request;
+
+        res = I2c_TransferAsync(I2c, &Request->Transfer);
+        if(res == 6)
+          {
+            Request->Next = WaitHead;
+            WaitHead = Request;
+            Current = nullptr;
+            return;
+          }
+
+        if(res != 1)
+          {
+            Request->Status = res;
+            Current = nullptr;
+            Append(&ReadyHead, Request);
+          }
+      }
+  }
+
+  static void Append(I2cAwait** Head, I2cAwait* const Request) noexcept
+  {
+    Request->Next = nullptr;
+    while(*Head != nullptr)
+      {
+        Head = &(*Head)->Next;
+      }
+    *Head = Request;
+  }
+
+  //the callback of the driver, it may run in the I2C interrupt
+  static void Done(const I2c_t,
+                   const I2cTransfer_t* const Transfer,
+                   const uint8_t Status) noexcept
+  {
+    I2cAwait* const Request = reinterpret_cast<I2cAwait*>(
+      const_cast<I2cTransfer_t*>(Transfer));
+    I2cBus* const Bus = Request->Bus;
+
+    Request->Status = Status;
+    Bus->Current = nullptr;
+    Append(&Bus->ReadyHead, Request);
+    Bus->StartNext();
+  }
+
+  const I2c_t I2c;
+  I2cAwait* Current = nullptr; /**< the request of the running transfer */
+  I2cAwait* WaitHead = nullptr; /**< the requests waiting for the bus */
+  I2cAwait* ReadyHead = nullptr; /**< the requests to resume */
+};
+
+inline void
+I2cAwait::await_suspend(const std::coroutine_handle<> Task) noexcept
+{
+  Bus->Submit(this, Task);
+}
+
+#endif
+/*****************************End of File ************************************/
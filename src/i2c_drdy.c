@@ -0,0 +1,344 @@
+/**
+ * @file i2c_drdy.c
+ * @author Mohamed Hassanin
+ * @brief I2C data-ready acquisition. The external interrupt of the
+ * data-ready line of a device calls I2cDrdy_Trigger, which stamps the edge
+ * and starts the burst read of the sample (the I2c_GetDrdyConfig table) as
+ * an asynchronous transfer right away, so the device isn't polled and the
+ * sample is read as soon as the bus allows. The bytes go straight into the
+ * buffer of the line, a ring of stamped samples taken with I2cDrdy_Read.
+ * A line whose bus is busy waits: it's started when a read of this module
+ * ends, or by I2cDrdy_Poll for the other transfers.
+ * @version 0.1
+ * @date 2021-05-26
+ */
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <inttypes.h>
+#include "i2c_drdy.h"
+/******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#if (I2C_DRDY_DEPTH & (I2C_DRDY_DEPTH - 1)) != 0 || I2C_DRDY_DEPTH > 128
+#error "I2C_DRDY_DEPTH must be a power of two and at most 128"
+#endif
+
+#define I2C_DRDY_MASK (I2C_DRDY_DEPTH - 1) /**< wraps an index into the ring */
+
+#define I2C_DRDY_IDLE 0 /**< no edge to serve */
+#define I2C_DRDY_WAITING 1 /**< an edge is seen, the bus is busy */
+#define I2C_DRDY_READING 2 /**< the read of the sample runs */
+/******************************************************************************
+ * typedefs
+ ******************************************************************************/
+typedef struct
+{
+  I2cTransfer_t Transfer; /**< the burst read, the first member, see
+                            I2cDrdy_Done */
+  I2c_t I2c; /**< the bus of the device */
+  uint8_t Program[10]; /**< the program of the burst read */
+  volatile uint8_t State; /**< I2C_DRDY_IDLE, WAITING or READING */
+  uint32_t Time; /**< the time of the edge being served */
+  I2cDrdySample_t Ring[I2C_DRDY_DEPTH]; /**< the samples */
+  volatile uint8_t Head; /**< the next sample to read from the device */
+  volatile uint8_t Tail; /**< the next sample to take */
+  I2cDrdyStats_t Stats;
+}I2cDrdyLine_t;
+/******************************************************************************
+ * module variables definitions
+ ******************************************************************************/
+static I2cDrdyLine_t gLine[I2C_DRDY_MAX];
+/******************************************************************************
+ * functions prototypes
+ ******************************************************************************/
+static uint8_t I2cDrdy_Start(const I2cDrdySource_t Source);
+static void I2cDrdy_Done(const I2c_t I2c,
+                         const I2cTransfer_t* const Transfer,
+                         const uint8_t Status);
+/******************************************************************************
+ * functions definitions
+ ******************************************************************************/
+/******************************************************************************
+* Function : I2cDrdy_Init()
+*//**
+* \b Description:
+* initialize the data-ready lines and prepare their burst reads. A line
+* whose sample is empty or longer than I2C_DRDY_SAMPLE_SIZE is ignored. <br>
+* PRE-CONDITION: I2c_Init is called <br>
+* PRE-CONDITION: The data-ready interrupts are disabled <br>
+* POST-CONDITION: The buffers are empty <br>
+* @param Config the table of the lines, see I2c_GetDrdyConfig
+* @return void
+ ******************************************************************************/
+extern void
+I2cDrdy_Init(const I2cDrdyConfig_t* const Config)
+{
+  if(!(Config != 0x0)) return;
+
+  const I2cDeviceConfig_t* Device;
+  I2cDrdyLine_t* Line;
+  uint8_t Source;
+  uint8_t i;
+
+  for(Source = 0; Source < I2C_DRDY_MAX; Source++)
+    {
+      Line = &gLine[Config[Source].Source];
+      Device = &I2c_GetDeviceConfig()[Config[Source].Device];
+
+      Line->I2c = Device->I2c;
+      Line->State = I2C_DRDY_IDLE;
+      Line->Head = 0;
+      Line->Tail = 0;
+      Line->Stats.Samples = 0;
+      Line->Stats.Missed = 0;
+      Line->Stats.Overruns = 0;
+      Line->Stats.Errors = 0;
+      Line->Stats.MaxLatency = 0;
+
+      Line->Transfer.Program = 0x0;
+      Line->Transfer.Address = Device->Address;
+      Line->Transfer.Register = Config[Source].Register;
+      Line->Transfer.TxData = 0x0;
+      Line->Transfer.RxData = 0x0;
+      Line->Transfer.Callback = I2cDrdy_Done;
+      Line->Transfer.Receive = 0x0;
+
+      if(!(Config[Source].Length != 0 &&
+           Config[Source].Length <= I2C_DRDY_SAMPLE_SIZE)) continue;
+
+      i = 0;
+      Line->Program[i++] = I2C_OP_START;
+      Line->Program[i++] = I2C_OP_ADDR_W;
+      Line->Program[i++] = I2C_OP_REG;
+      Line->Program[i++] = I2C_OP_START;
+      Line->Program[i++] = I2C_OP_ADDR_R;
+      if(Config[Source].Length > 1)
+        {
+          Line->Program[i++] = I2C_OP_RX_ACK;
+          Line->Program[i++] = Config[Source].Length - 1;
+        }
+      Line->Program[i++] = I2C_OP_RX_NACK;
+      Line->Program[i++] = I2C_OP_STOP;
+      Line->Program[i] = I2C_OP_END;
+
+      Line->Transfer.Program = Line->Program;
+    }
+}
+
+/******************************************************************************
+* Function : I2cDrdy_Trigger()
+*//**
+* \b Description:
+* Serve a data-ready edge: stamp it and start the read of the sample if the
+* bus is free. It's meant to be called from the external interrupt of the
+* line. An edge seen while the previous one is served is counted as
+* missed, its data is read by the running read if the device allows. <br>
+* PRE-CONDITION: I2cDrdy_Init is called <br>
+* @param Source the data-ready line
+* @return void
+ ******************************************************************************/
+extern void
+I2cDrdy_Trigger(const I2cDrdySource_t Source)
+{
+  if(!(Source < I2C_DRDY_MAX && gLine[Source].Transfer.Program != 0x0))
+    {
+      return;
+    }
+
+  I2cDrdyLine_t* const Line = &gLine[Source];
+  I2C_CRITICAL_STATE State;
+
+  I2C_ENTER_CRITICAL(State);
+  if(Line->State == I2C_DRDY_IDLE)
+    {
+      Line->Time = I2C_DRDY_GET_TIME();
+      Line->State = I2C_DRDY_WAITING;
+    }
+  else
+    {
+      Line->Stats.Missed++;
+    }
+  I2C_EXIT_CRITICAL(State);
+
+  I2cDrdy_Start(Source);
+}
+
+/******************************************************************************
+* Function : I2cDrdy_Poll()
+*//**
+* \b Description:
+* Start the reads of the lines which wait for a bus taken by another
+* transfer. It's meant to be called from the main loop, next to I2c_Poll.
+* <br>
+* @return void
+ ******************************************************************************/
+extern void
+I2cDrdy_Poll(void)
+{
+  uint8_t Source;
+
+  for(Source = 0; Source < I2C_DRDY_MAX; Source++)
+    {
+      I2cDrdy_Start(Source);
+    }
+}
+
+/******************************************************************************
+* Function : I2cDrdy_Read()
+*//**
+* \b Description:
+* Take the oldest sample of a line. <br>
+* @param Source the data-ready line
+* @param Sample a pointer to receive the sample in
+* @return uint8_t 1 if a sample is taken, 0 if the buffer is empty.
+ ******************************************************************************/
+extern uint8_t
+I2cDrdy_Read(const I2cDrdySource_t Source, I2cDrdySample_t* const Sample)
+{
+  if(!(Source < I2C_DRDY_MAX && Sample != 0x0)) return 0;
+
+  I2cDrdyLine_t* const Line = &gLine[Source];
+  I2C_CRITICAL_STATE State;
+  uint8_t Available;
+
+  //a full buffer drops its oldest sample from the interrupt
+  I2C_ENTER_CRITICAL(State);
+  Available = Line->Head != Line->Tail;
+  if(Available != 0)
+    {
+      *Sample = Line->Ring[Line->Tail & I2C_DRDY_MASK];
+      Line->Tail = Line->Tail + 1;
+    }
+  I2C_EXIT_CRITICAL(State);
+
+  return Available;
+}
+
+/******************************************************************************
+* Function : I2cDrdy_GetCount()
+*//**
+* \b Description:
+* Get the number of the samples of a line waiting to be taken. <br>
+* @param Source the data-ready line
+* @return uint8_t the number of the samples
+ ******************************************************************************/
+extern uint8_t
+I2cDrdy_GetCount(const I2cDrdySource_t Source)
+{
+  if(!(Source < I2C_DRDY_MAX)) return 0;
+
+  return (uint8_t)(gLine[Source].Head - gLine[Source].Tail);
+}
+
+/******************************************************************************
+* Function : I2cDrdy_GetStats()
+*//**
+* \b Description:
+* Get the counters of a line since I2cDrdy_Init. <br>
+* @param Source the data-ready line
+* @param Stats a pointer to receive the counters in
+* @return void
+ ******************************************************************************/
+extern void
+I2cDrdy_GetStats(const I2cDrdySource_t Source, I2cDrdyStats_t* const Stats)
+{
+  if(!(Source < I2C_DRDY_MAX && Stats != 0x0)) return;
+
+  I2C_CRITICAL_STATE State;
+
+  I2C_ENTER_CRITICAL(State);
+  *Stats = gLine[Source].Stats;
+  I2C_EXIT_CRITICAL(State);
+}
+
+/******************************************************************************
+* Function : I2cDrdy_Start()
+*//**
+* \b Description:
+* Utility function to start the read of a line which waits for its bus. The
+* sample is read into the next slot of the ring, the oldest sample is
+* dropped if it's full. <br>
+* @param Source the data-ready line
+* @return uint8_t 1 if the read is started, 0 otherwise.
+ ******************************************************************************/
+static uint8_t
+I2cDrdy_Start(const I2cDrdySource_t Source)
+{
+  I2cDrdyLine_t* const Line = &gLine[Source];
+  I2C_CRITICAL_STATE State;
+  uint8_t Claimed;
+  uint8_t res;
+
+  I2C_ENTER_CRITICAL(State);
+  Claimed = Line->State == I2C_DRDY_WAITING;
+  if(Claimed != 0)
+    {
+      Line->State = I2C_DRDY_READING;
+      if((uint8_t)(Line->Head - Line->Tail) == I2C_DRDY_DEPTH)
+        {
+          Line->Tail = Line->Tail + 1;
+          Line->Stats.Overruns++;
+        }
+    }
+  I2C_EXIT_CRITICAL(State);
+
+  if(Claimed == 0) return 0;
+
+  Line->Transfer.RxData = Line->Ring[Line->Head & I2C_DRDY_MASK].Data;
+
+  res = I2c_TransferAsync(Line->I2c, &Line->Transfer);
+  if(res == 6)
+    {
+      Line->State = I2C_DRDY_WAITING;
+      return 0;
+    }
+
+  return 1;
+}
+
+/******************************************************************************
+* Function : I2cDrdy_Done()
+*//**
+* \b Description:
+* Utility function called when the read of a line ends, in the I2C
+* interrupt if I2C_ASYNC_IRQ is 1. It publishes the sample, then starts
+* the next line waiting for the bus. <br>
+* @param I2c the id of the I2C peripheral
+* @param Transfer the burst read of the line
+* @param Status the result of the read, see I2c_Transfer
+* @return void
+ ******************************************************************************/
+static void
+I2cDrdy_Done(const I2c_t I2c,
+             const I2cTransfer_t* const Transfer,
+             const uint8_t Status)
+{
+  //the transfer is the first member of its line
+  I2cDrdyLine_t* const Line = (I2cDrdyLine_t*)Transfer;
+  I2cDrdySample_t* const Sample = &Line->Ring[Line->Head & I2C_DRDY_MASK];
+  uint8_t Source;
+
+  if(Status == 1)
+    {
+      Sample->Time = Line->Time;
+      Sample->Done = I2C_DRDY_GET_TIME();
+      if(Sample->Done - Sample->Time > Line->Stats.MaxLatency)
+        {
+          Line->Stats.MaxLatency = Sample->Done - Sample->Time;
+        }
+      Line->Stats.Samples++;
+      Line->Head = Line->Head + 1;
+    }
+  else
+    {
+      Line->Stats.Errors++;
+    }
+  Line->State = I2C_DRDY_IDLE;
+
+  for(Source = 0; Source < I2C_DRDY_MAX; Source++)
+    {
+      if(gLine[Source].I2c == I2c && I2cDrdy_Start(Source) != 0) break;
+    }
+}
+/*****************************End of File ************************************/
@@ -0,0 +1,59 @@
+/**
+ * @file i2c_drdy.h
+ * @author Mohamed Hassanin
+ * @brief I2C data-ready acquisition header file.
+ * @version 0.1
+ * @date 2021-05-26
+ */
+#ifndef I2C_DRDY_H
+#define I2C_DRDY_H
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "i2c.h"
+/******************************************************************************
+ * Typedefs
+ ******************************************************************************/
+/**
+ * @brief A sample read after a data-ready edge.
+ */
+typedef struct
+{
+  uint32_t Time; /**< I2C_DRDY_GET_TIME() at the edge */
+  uint32_t Done; /**< I2C_DRDY_GET_TIME() at the end of the read */
+  uint8_t Data[I2C_DRDY_SAMPLE_SIZE]; /**< the registers of the sample */
+}I2cDrdySample_t;
+
+typedef struct
+{
+  uint32_t Samples; /**< Number of samples read */
+  uint16_t Missed; /**< Number of edges seen while a read was waiting or
+                     running */
+  uint16_t Overruns; /**< Number of samples dropped because the buffer was
+                       full, the oldest one is dropped */
+  uint16_t Errors; /**< Number of failed reads */
+  uint32_t MaxLatency; /**< the longest time from an edge to the end of its
+                         read */
+}I2cDrdyStats_t;
+/******************************************************************************
+ * Function prototypes
+ ******************************************************************************/
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+extern void I2cDrdy_Init(const I2cDrdyConfig_t* const Config);
+extern void I2cDrdy_Trigger(const I2cDrdySource_t Source);
+extern void I2cDrdy_Poll(void);
+extern uint8_t I2cDrdy_Read(const I2cDrdySource_t Source,
+                            I2cDrdySample_t* const Sample);
+extern uint8_t I2cDrdy_GetCount(const I2cDrdySource_t Source);
+extern void I2cDrdy_GetStats(const I2cDrdySource_t Source,
+                             I2cDrdyStats_t* const Stats);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
+/*****************************End of File ************************************/
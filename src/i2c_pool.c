@@ -0,0 +1,302 @@
+/**
+ * @file i2c_pool.c
+ * @author Mohamed Hassanin
+ * @brief I2C static descriptor and buffer pool. The descriptors of the
+ * queued and asynchronous transfers and their data buffers come from fixed
+ * arrays sized in i2c_cfg.h, so there's no heap. The free slots of each
+ * pool are a stack of their indexes: an allocation pops one and a free
+ * pushes it back, both in a constant time inside a short critical section,
+ * so the ISRs can use the pool. The RAM taken is checked against
+ * I2C_POOL_RAM_BUDGET at compile time, and the high-water mark of each
+ * pool is kept to shrink it to the measured peak.
+ * @version 0.1
+ * @date 2021-05-29
+ */
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <inttypes.h>
+#include <string.h>
+#include "i2c_pool.h"
+/******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#if I2C_POOL_DESCRIPTOR_COUNT < 1 || I2C_POOL_DESCRIPTOR_COUNT > 254
+#error "I2C_POOL_DESCRIPTOR_COUNT must be from 1 to 254"
+#endif
+
+#if I2C_POOL_BUFFER_COUNT < 1 || I2C_POOL_BUFFER_COUNT > 254
+#error "I2C_POOL_BUFFER_COUNT must be from 1 to 254"
+#endif
+
+#if I2C_POOL_BUFFER_SIZE < 1
+#error "I2C_POOL_BUFFER_SIZE must be at least 1"
+#endif
+
+#define I2C_POOL_NONE 0xFF /**< No free slot */
+/******************************************************************************
+ * typedefs
+ ******************************************************************************/
+/**
+ * @brief All the memory of the pool, so its size is checked at once.
+ */
+typedef struct
+{
+  I2cDescriptor_t Descriptors[I2C_POOL_DESCRIPTOR_COUNT];
+  uint8_t Buffers[I2C_POOL_BUFFER_COUNT][I2C_POOL_BUFFER_SIZE];
+  uint8_t FreeDescriptors[I2C_POOL_DESCRIPTOR_COUNT]; /**< the indexes of the
+                                                        free descriptors, a
+                                                        stack */
+  uint8_t FreeBuffers[I2C_POOL_BUFFER_COUNT]; /**< the indexes of the free
+                                                buffers, a stack */
+  uint8_t AllocatedDescriptors[I2C_POOL_DESCRIPTOR_COUNT]; /**< 1 while a
+                                                             descriptor is
+                                                             allocated */
+  uint8_t AllocatedBuffers[I2C_POOL_BUFFER_COUNT]; /**< 1 while a buffer is
+                                                     allocated */
+  I2cPoolStats_t Stats[I2C_POOL_MAX]; /**< the top of a stack is the number
+                                        of its slots less Used */
+}I2cPool_t;
+
+_Static_assert(sizeof(I2cPool_t) <= I2C_POOL_RAM_BUDGET,
+               "the pool takes more RAM than I2C_POOL_RAM_BUDGET");
+/******************************************************************************
+ * module variables definitions
+ ******************************************************************************/
+static I2cPool_t gPool;
+/******************************************************************************
+ * functions prototypes
+ ******************************************************************************/
+static uint8_t I2cPool_Take(const I2cPoolId_t Pool,
+                            uint8_t* const Free,
+                            uint8_t* const Allocated,
+                            const uint8_t Slots);
+static uint8_t I2cPool_Give(const I2cPoolId_t Pool,
+                            uint8_t* const Free,
+                            uint8_t* const Allocated,
+                            const uint8_t Slots,
+                            const uint8_t Index);
+/******************************************************************************
+ * functions definitions
+ ******************************************************************************/
+/******************************************************************************
+* Function : I2cPool_Init()
+*//**
+* \b Description:
+* initialize the pool: all the slots are free and the statistics are reset.
+* <br>
+* PRE-CONDITION: No slot is in use <br>
+* @return void
+ ******************************************************************************/
+extern void
+I2cPool_Init(void)
+{
+  uint8_t i;
+
+  for(i = 0; i < I2C_POOL_DESCRIPTOR_COUNT; i++)
+    {
+      gPool.FreeDescriptors[i] = i;
+      gPool.AllocatedDescriptors[i] = 0;
+    }
+
+  for(i = 0; i < I2C_POOL_BUFFER_COUNT; i++)
+    {
+      gPool.FreeBuffers[i] = i;
+      gPool.AllocatedBuffers[i] = 0;
+    }
+
+  for(i = 0; i < I2C_POOL_MAX; i++)
+    {
+      gPool.Stats[i].Used = 0;
+      gPool.Stats[i].Peak = 0;
+      gPool.Stats[i].Failures = 0;
+    }
+}
+
+/******************************************************************************
+* Function : I2cPool_Alloc()
+*//**
+* \b Description:
+* Allocate a descriptor. It's zeroed. <br>
+* @return I2cDescriptor_t* the descriptor, null if they're all in use.
+ ******************************************************************************/
+extern I2cDescriptor_t*
+I2cPool_Alloc(void)
+{
+  const uint8_t Index = I2cPool_Take(I2C_POOL_DESCRIPTOR,
+                                     gPool.FreeDescriptors,
+                                     gPool.AllocatedDescriptors,
+                                     I2C_POOL_DESCRIPTOR_COUNT);
+
+  if(Index == I2C_POOL_NONE) return 0x0;
+
+  memset(&gPool.Descriptors[Index], 0, sizeof(I2cDescriptor_t));
+
+  return &gPool.Descriptors[Index];
+}
+
+/******************************************************************************
+* Function : I2cPool_Free()
+*//**
+* \b Description:
+* Free a descriptor, e.g. from the callback of its transfer or request.
+* The transfer or the request of a descriptor can be cast to it. <br>
+* @param Descriptor the descriptor
+* @return uint8_t 1 if it's freed, 0 if it isn't an allocated descriptor
+* of the pool (a foreign pointer or a double free).
+ ******************************************************************************/
+extern uint8_t
+I2cPool_Free(I2cDescriptor_t* const Descriptor)
+{
+  const uintptr_t Offset = (uintptr_t)Descriptor -
+                           (uintptr_t)gPool.Descriptors;
+
+  if(!(Offset < sizeof(gPool.Descriptors) &&
+       Offset % sizeof(I2cDescriptor_t) == 0)) return 0;
+
+  return I2cPool_Give(I2C_POOL_DESCRIPTOR, gPool.FreeDescriptors,
+                      gPool.AllocatedDescriptors, I2C_POOL_DESCRIPTOR_COUNT,
+                      (uint8_t)(Offset / sizeof(I2cDescriptor_t)));
+}
+
+/******************************************************************************
+* Function : I2cPool_AllocBuffer()
+*//**
+* \b Description:
+* Allocate a data buffer of I2C_POOL_BUFFER_SIZE bytes. <br>
+* @return uint8_t* the buffer, null if they're all in use.
+ ******************************************************************************/
+extern uint8_t*
+I2cPool_AllocBuffer(void)
+{
+  const uint8_t Index = I2cPool_Take(I2C_POOL_BUFFER,
+                                     gPool.FreeBuffers,
+                                     gPool.AllocatedBuffers,
+                                     I2C_POOL_BUFFER_COUNT);
+
+  if(Index == I2C_POOL_NONE) return 0x0;
+
+  return gPool.Buffers[Index];
+}
+
+/******************************************************************************
+* Function : I2cPool_FreeBuffer()
+*//**
+* \b Description:
+* Free a data buffer. <br>
+* @param Buffer the buffer
+* @return uint8_t 1 if it's freed, 0 if it isn't an allocated buffer of the
+* pool (a foreign pointer or a double free).
+ ******************************************************************************/
+extern uint8_t
+I2cPool_FreeBuffer(uint8_t* const Buffer)
+{
+  const uintptr_t Offset = (uintptr_t)Buffer - (uintptr_t)gPool.Buffers;
+
+  if(!(Offset < sizeof(gPool.Buffers) &&
+       Offset % I2C_POOL_BUFFER_SIZE == 0)) return 0;
+
+  return I2cPool_Give(I2C_POOL_BUFFER, gPool.FreeBuffers,
+                      gPool.AllocatedBuffers, I2C_POOL_BUFFER_COUNT,
+                      (uint8_t)(Offset / I2C_POOL_BUFFER_SIZE));
+}
+
+/******************************************************************************
+* Function : I2cPool_GetStats()
+*//**
+* \b Description:
+* Get the slots in use, the high-water mark and the failed allocations of
+* a pool since I2cPool_Init. <br>
+* @param Pool the pool
+* @param Stats a pointer to receive the statistics in
+* @return void
+ ******************************************************************************/
+extern void
+I2cPool_GetStats(const I2cPoolId_t Pool, I2cPoolStats_t* const Stats)
+{
+  if(!(Pool < I2C_POOL_MAX && Stats != 0x0)) return;
+
+  I2C_CRITICAL_STATE State;
+
+  I2C_ENTER_CRITICAL(State);
+  *Stats = gPool.Stats[Pool];
+  I2C_EXIT_CRITICAL(State);
+}
+
+/******************************************************************************
+* Function : I2cPool_Take()
+*//**
+* \b Description:
+* Utility function to pop a free slot of a pool. <br>
+* @param Pool the pool
+* @param Free the stack of the free slots of the pool
+* @param Allocated the flags of the slots of the pool
+* @param Slots the number of the slots of the pool
+* @return uint8_t the index of the slot, I2C_POOL_NONE if there's none.
+ ******************************************************************************/
+static uint8_t
+I2cPool_Take(const I2cPoolId_t Pool,
+             uint8_t* const Free,
+             uint8_t* const Allocated,
+             const uint8_t Slots)
+{
+  I2cPoolStats_t* const Stats = &gPool.Stats[Pool];
+  I2C_CRITICAL_STATE State;
+  uint8_t Index = I2C_POOL_NONE;
+
+  I2C_ENTER_CRITICAL(State);
+  if(Stats->Used < Slots)
+    {
+      Index = Free[Slots - Stats->Used - 1];
+      Allocated[Index] = 1;
+      Stats->Used++;
+      if(Stats->Used > Stats->Peak)
+        {
+          Stats->Peak = Stats->Used;
+        }
+    }
+  else
+    {
+      Stats->Failures++;
+    }
+  I2C_EXIT_CRITICAL(State);
+
+  return Index;
+}
+
+/******************************************************************************
+* Function : I2cPool_Give()
+*//**
+* \b Description:
+* Utility function to push a slot back onto the free ones of a pool. <br>
+* @param Pool the pool
+* @param Free the stack of the free slots of the pool
+* @param Allocated the flags of the slots of the pool
+* @param Slots the number of the slots of the pool
+* @param Index the index of the slot
+* @return uint8_t 1 if it's freed, 0 if it isn't allocated.
+ ******************************************************************************/
+static uint8_t
+I2cPool_Give(const I2cPoolId_t Pool,
+             uint8_t* const Free,
+             uint8_t* const Allocated,
+             const uint8_t Slots,
+             const uint8_t Index)
+{
+  I2cPoolStats_t* const Stats = &gPool.Stats[Pool];
+  I2C_CRITICAL_STATE State;
+  uint8_t Freed;
+
+  I2C_ENTER_CRITICAL(State);
+  Freed = Allocated[Index] != 0;
+  if(Freed != 0)
+    {
+      Allocated[Index] = 0;
+      Free[Slots - Stats->Used] = Index;
+      Stats->Used--;
+    }
+  I2C_EXIT_CRITICAL(State);
+
+  return Freed;
+}
+/*****************************End of File ************************************/
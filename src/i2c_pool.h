@@ -0,0 +1,61 @@
+/**
+ * @file i2c_pool.h
+ * @author Mohamed Hassanin
+ * @brief I2C static descriptor and buffer pool header file.
+ * @version 0.1
+ * @date 2021-05-29
+ */
+#ifndef I2C_POOL_H
+#define I2C_POOL_H
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "i2c_arb.h"
+/******************************************************************************
+ * Typedefs
+ ******************************************************************************/
+typedef enum
+{
+  I2C_POOL_DESCRIPTOR, /**< the descriptors, I2cPool_Alloc */
+  I2C_POOL_BUFFER, /**< the data buffers, I2cPool_AllocBuffer */
+  I2C_POOL_MAX
+}I2cPoolId_t;
+
+/**
+ * @brief A descriptor of the pool, for an asynchronous transfer or a
+ * request of the arbiter. Both are the first member, so a pointer to
+ * either can be cast back to the descriptor.
+ */
+typedef union
+{
+  I2cTransfer_t Transfer; /**< see I2c_TransferAsync */
+  I2cRequest_t Request; /**< see I2cArb_Submit and I2cQueue_Submit */
+}I2cDescriptor_t;
+
+typedef struct
+{
+  uint8_t Used; /**< Number of slots allocated */
+  uint8_t Peak; /**< the most slots allocated at once, the high-water mark */
+  uint16_t Failures; /**< Number of allocations which found no free slot */
+}I2cPoolStats_t;
+/******************************************************************************
+ * Function prototypes
+ ******************************************************************************/
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+extern void I2cPool_Init(void);
+extern I2cDescriptor_t* I2cPool_Alloc(void);
+extern uint8_t I2cPool_Free(I2cDescriptor_t* const Descriptor);
+extern uint8_t* I2cPool_AllocBuffer(void);
+extern uint8_t I2cPool_FreeBuffer(uint8_t* const Buffer);
+extern void I2cPool_GetStats(const I2cPoolId_t Pool,
+                             I2cPoolStats_t* const Stats);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
+/*****************************End of File ************************************/
@@ -0,0 +1,125 @@
+/**
+ * @file i2c_queue.c
+ * @author Mohamed Hassanin
+ * @brief I2C submission queue. It's a ring of requests filled by several
+ * producers (the main context and the ISRs) and drained by one consumer,
+ * the arbiter. The producers never block: a producer only reserves a slot
+ * inside a critical section of a few instructions, then fills it with the
+ * interrupts enabled and publishes it with a single byte write.
+ * @version 0.1
+ * @date 2021-05-10
+ */
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <inttypes.h>
+#include "i2c_queue.h"
+/******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#if (I2C_QUEUE_SIZE & (I2C_QUEUE_SIZE - 1)) != 0 || I2C_QUEUE_SIZE > 128
+#error "I2C_QUEUE_SIZE must be a power of two and at most 128"
+#endif
+
+#define I2C_QUEUE_MASK (I2C_QUEUE_SIZE - 1) /**< wraps an index into the ring */
+/******************************************************************************
+ * module variables definitions
+ ******************************************************************************/
+static I2cRequest_t* volatile gSlot[I2C_QUEUE_SIZE];
+
+/**
+ * Set by the producer after the slot is filled, cleared by the consumer
+ * after the slot is read. A byte is written atomically, the pointer isn't.
+ */
+static volatile uint8_t gReady[I2C_QUEUE_SIZE];
+
+static volatile uint8_t gHead; /**< the next slot to reserve, producers only */
+static volatile uint8_t gTail; /**< the next slot to read, consumer only */
+/******************************************************************************
+ * functions definitions
+ ******************************************************************************/
+/******************************************************************************
+* Function : I2cQueue_Init()
+*//**
+* \b Description:
+* initialize the submission queue <br>
+* POST-CONDITION: The queue is empty <br>
+* @return void
+ ******************************************************************************/
+extern void
+I2cQueue_Init(void)
+{
+  uint8_t i;
+
+  for(i = 0; i < I2C_QUEUE_SIZE; i++)
+    {
+      gReady[i] = 0;
+    }
+
+  gHead = 0;
+  gTail = 0;
+}
+
+/******************************************************************************
+* Function : I2cQueue_Submit()
+*//**
+* \b Description:
+* Queue a request. It's safe to call from the ISRs and from the main
+* context. It never blocks. <br>
+* POST-CONDITION: The status of the request is I2C_ARB_PENDING <br>
+* @param Request the request to queue
+* @return uint8_t 1 if the request is queued, 0 if the queue is full.
+ ******************************************************************************/
+extern uint8_t
+I2cQueue_Submit(I2cRequest_t* const Request)
+{
+  if(!(Request != 0x0)) return 0;
+
+  I2C_CRITICAL_STATE State;
+  uint8_t Head;
+  uint8_t Full;
+
+  I2C_ENTER_CRITICAL(State);
+  Head = gHead;
+  Full = (uint8_t)(Head - gTail) == I2C_QUEUE_SIZE;
+  if(Full == 0)
+    {
+      gHead = Head + 1;
+    }
+  I2C_EXIT_CRITICAL(State);
+
+  if(Full != 0) return 0;
+
+  Request->Status = I2C_ARB_PENDING;
+
+  Head &= I2C_QUEUE_MASK;
+  gSlot[Head] = Request;
+  gReady[Head] = 1;
+
+  return 1;
+}
+
+/******************************************************************************
+* Function : I2cQueue_Receive()
+*//**
+* \b Description:
+* Take the oldest request out of the queue. It must only be called from one
+* context, the consumer. A slot reserved but not yet filled by an
+* interrupted producer holds back the slots after it until it's filled. <br>
+* @return I2cRequest_t* the request, null if there's no ready request.
+ ******************************************************************************/
+extern I2cRequest_t*
+I2cQueue_Receive(void)
+{
+  uint8_t Tail = gTail & I2C_QUEUE_MASK;
+  I2cRequest_t* Request;
+
+  if(gReady[Tail] == 0) return 0x0;
+
+  Request = gSlot[Tail];
+  gReady[Tail] = 0;
+  gTail = gTail + 1;
+
+  return Request;
+}
+/*****************************End of File ************************************/
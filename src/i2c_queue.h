@@ -0,0 +1,30 @@
+/**
+ * @file i2c_queue.h
+ * @author Mohamed Hassanin
+ * @brief I2C submission queue header file.
+ * @version 0.1
+ * @date 2021-05-10
+ */
+#ifndef I2C_QUEUE_H
+#define I2C_QUEUE_H
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "i2c_arb.h"
+/******************************************************************************
+ * Function prototypes
+ ******************************************************************************/
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+extern void I2cQueue_Init(void);
+extern uint8_t I2cQueue_Submit(I2cRequest_t* const Request);
+extern I2cRequest_t* I2cQueue_Receive(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
+/*****************************End of File ************************************/
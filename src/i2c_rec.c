@@ -0,0 +1,166 @@
+/**
+ * @file i2c_rec.c
+ * @author Mohamed Hassanin
+ * @brief I2C bus recorder. Every step of the transactions is appended to a
+ * compact binary log in RAM, see I2C_REC_RECORD_SIZE for its format. The
+ * log is drained by I2cRec_Read, e.g. to a UART or a flash page, and can be
+ * replayed on the host by the TWI simulation (test/support/twi_replay).
+ * The gaps are counted by I2C_GET_CYCLES, so the ones longer than 65535
+ * cycles are folded.
+ * @version 0.1
+ * @date 2021-05-22
+ */
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <inttypes.h>
+#include "i2c_rec.h"
+/******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#if (I2C_REC_SIZE & (I2C_REC_SIZE - 1)) != 0 || I2C_REC_SIZE > 32768u || \
+    I2C_REC_SIZE < I2C_REC_RECORD_SIZE
+#error "I2C_REC_SIZE must be a power of two between 8 and 32768"
+#endif
+
+#define I2C_REC_MASK ((uint16_t)(I2C_REC_SIZE - 1)) /**< the index in the log */
+/******************************************************************************
+ * module variables definitions
+ ******************************************************************************/
+static uint8_t gLog[I2C_REC_SIZE];
+
+static uint16_t gHead; /**< the count of the bytes written */
+
+static uint16_t gTail; /**< the count of the bytes read */
+
+static uint16_t gLast; /**< the cycles of the previous record */
+
+static uint16_t gDropped; /**< the records lost because the log was full */
+/******************************************************************************
+ * functions definitions
+ ******************************************************************************/
+/******************************************************************************
+* Function : I2cRec_Init()
+*//**
+* \b Description:
+* Empty the log and start recording the steps of the transactions. <br>
+* PRE-CONDITION: I2c_Init is called <br>
+* POST-CONDITION: The recorder of the driver is I2cRec_Step <br>
+* @return void
+ ******************************************************************************/
+extern void
+I2cRec_Init(void)
+{
+  I2C_CRITICAL_STATE State;
+
+  I2C_ENTER_CRITICAL(State);
+  gHead = 0;
+  gTail = 0;
+  gDropped = 0;
+  gLast = I2C_GET_CYCLES();
+  I2C_EXIT_CRITICAL(State);
+
+  I2c_SetRecorder(I2cRec_Step);
+}
+
+/******************************************************************************
+* Function : I2cRec_Step()
+*//**
+* \b Description:
+* Append a step to the log. It's the recorder of the driver, see
+* I2c_SetRecorder. The step is dropped if the log is full. <br>
+* @param I2c the id of the I2C peripheral
+* @param Op the op of the step
+* @param Status the status code of the step
+* @param Data the byte sent or received by the step
+* @return void
+ ******************************************************************************/
+extern void
+I2cRec_Step(const I2c_t I2c,
+            const uint8_t Op,
+            const uint8_t Status,
+            const uint8_t Data)
+{
+  I2C_CRITICAL_STATE State;
+  uint16_t Now;
+  uint16_t Delta;
+
+  I2C_ENTER_CRITICAL(State);
+
+  Now = I2C_GET_CYCLES();
+  Delta = Now - gLast;
+  gLast = Now;
+
+  if((uint16_t)(gHead - gTail) > I2C_REC_SIZE - I2C_REC_RECORD_SIZE)
+    {
+      gDropped++;
+    }
+  else
+    {
+      gLog[gHead & I2C_REC_MASK] = (uint8_t)(I2c << 4) | (Op & 0x0F);
+      gLog[(gHead + 1) & I2C_REC_MASK] = Status;
+      gLog[(gHead + 2) & I2C_REC_MASK] = Data;
+      gLog[(gHead + 3) & I2C_REC_MASK] = (uint8_t)Delta;
+      gLog[(gHead + 4) & I2C_REC_MASK] = (uint8_t)(Delta >> 8);
+      gHead += I2C_REC_RECORD_SIZE;
+    }
+
+  I2C_EXIT_CRITICAL(State);
+}
+
+/******************************************************************************
+* Function : I2cRec_Read()
+*//**
+* \b Description:
+* Take the oldest records out of the log. Only whole records are taken. <br>
+* @param Data a pointer to receive the records in
+* @param Length the size of Data in bytes
+* @return uint16_t the number of the bytes taken, a multiple of
+* I2C_REC_RECORD_SIZE.
+ ******************************************************************************/
+extern uint16_t
+I2cRec_Read(uint8_t* const Data, const uint16_t Length)
+{
+  if(!(Data != 0x0)) return 0;
+
+  I2C_CRITICAL_STATE State;
+  uint16_t Tail = gTail;
+  uint16_t Count;
+  uint16_t i;
+
+  I2C_ENTER_CRITICAL(State);
+  Count = gHead - Tail;
+  I2C_EXIT_CRITICAL(State);
+
+  if(Count > Length)
+    {
+      Count = Length - Length % I2C_REC_RECORD_SIZE;
+    }
+
+  //the recorder only writes beyond the head, so the copy can be interrupted
+  for(i = 0; i < Count; i++)
+    {
+      Data[i] = gLog[(uint16_t)(Tail + i) & I2C_REC_MASK];
+    }
+
+  I2C_ENTER_CRITICAL(State);
+  gTail = Tail + Count;
+  I2C_EXIT_CRITICAL(State);
+
+  return Count;
+}
+
+/******************************************************************************
+* Function : I2cRec_GetDropped()
+*//**
+* \b Description:
+* Get the number of the records lost because the log was full since
+* I2cRec_Init. A replay of a log with lost records diverges. <br>
+* @return uint16_t the number of the lost records
+ ******************************************************************************/
+extern uint16_t
+I2cRec_GetDropped(void)
+{
+  return gDropped;
+}
+/*****************************End of File ************************************/
@@ -0,0 +1,46 @@
+/**
+ * @file i2c_rec.h
+ * @author Mohamed Hassanin
+ * @brief I2C bus recorder header file.
+ * @version 0.1
+ * @date 2021-05-22
+ */
+#ifndef I2C_REC_H
+#define I2C_REC_H
+/******************************************************************************
+ * Definitions
+ ******************************************************************************/
+/**
+ * @brief The size of a record in the log:
+ * byte 0: the peripheral id in the high nibble, the op in the low nibble
+ * byte 1: the status code of the step, I2C_NO_STATUS if the step timed out
+ * or has none (a stop bit)
+ * byte 2: the byte sent or received by the step
+ * byte 3, 4: the CPU cycles since the previous record, little-endian
+ */
+#define I2C_REC_RECORD_SIZE 5
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "i2c.h"
+/******************************************************************************
+ * Function prototypes
+ ******************************************************************************/
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+extern void I2cRec_Init(void);
+extern void I2cRec_Step(const I2c_t I2c,
+                        const uint8_t Op,
+                        const uint8_t Status,
+                        const uint8_t Data);
+extern uint16_t I2cRec_Read(uint8_t* const Data, const uint16_t Length);
+extern uint16_t I2cRec_GetDropped(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
+/*****************************End of File ************************************/
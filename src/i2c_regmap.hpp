@@ -0,0 +1,576 @@
+/**
+ * @file i2c_regmap.hpp
+ * @author Mohamed Hassanin
+ * @brief Compile-time register maps of the devices. A map lists the
+ * registers of a device (address, width, access, volatility, reset value)
+ * and the fields are typed slices of them:
+ *
+ *   using CTRL1 = I2cRegister<0x20, 1, I2cAccess::READ_WRITE, false, 0x07>;
+ *   using CTRL4 = I2cRegister<0x23>;
+ *   using OUT_X = I2cRegister<0x28, 2, I2cAccess::READ_ONLY, true, 0,
+ *                             I2cOrder::LSB_FIRST>;
+ *   using Odr = I2cField<CTRL1, 4, 4>;
+ *   using Scale = I2cField<CTRL4, 4, 2>;
+ *   using X = I2cField<OUT_X, 0, 16>;
+ *   using Accel = I2cRegMap<0x19, CTRL1, CTRL4, OUT_X>;
+ *
+ *   X Ax;
+ *   Accel::Write(I2C_0, Odr{ 5 }, Scale{ 2 });
+ *   Accel::Read(I2C_0, Ax);
+ *
+ * The transactions of an access are planned at compile time: the touched
+ * registers are grouped in bursts, and a burst goes over a short gap when
+ * it costs fewer bus bytes than a new transaction. A register which isn't
+ * volatile is only changed by the writes of the driver, so it's kept in RAM
+ * from its reset value: its fields are read from RAM and its other fields
+ * are merged from RAM when it's written. Only the volatile registers are
+ * read back to merge a partial write. A read-only register can't be changed
+ * by the driver, so it's always read from the device like a volatile one.
+ * @version 0.1
+ * @date 2021-05-25
+ */
+#ifndef I2C_REGMAP_HPP
+#define I2C_REGMAP_HPP
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <type_traits>
+#include "i2c.h"
+/******************************************************************************
+ * Definitions
+ ******************************************************************************/
+/**
+ * @brief The bytes of the header of a write (the address and the register)
+ * and of a read (the address, the register and the address again). A gap
+ * up to this size is sent or read instead of starting a new transaction.
+ */
+#define I2C_REGMAP_WRITE_HEADER 2
+#define I2C_REGMAP_READ_HEADER 3
+/******************************************************************************
+ * Classes
+ ******************************************************************************/
+enum class I2cAccess : uint8_t
+{
+  READ_ONLY,
+  WRITE_ONLY,
+  READ_WRITE,
+};
+
+/**
+ * @brief The order of the bytes of a register wider than a byte on the bus.
+ */
+enum class I2cOrder : uint8_t
+{
+  MSB_FIRST,
+  LSB_FIRST,
+};
+
+template<uint8_t Address_,
+         uint8_t Width_ = 1,
+         I2cAccess Access_ = I2cAccess::READ_WRITE,
+         bool Volatile_ = false,
+         uint32_t Reset_ = 0,
+         I2cOrder Order_ = I2cOrder::MSB_FIRST>
+struct I2cRegister
+{
+  static_assert(Width_ >= 1 && Width_ <= 4, "a register is 1 to 4 bytes");
+  static_assert(Address_ + Width_ <= 256, "a register ends beyond 0xFF");
+
+  static constexpr uint8_t Address = Address_;
+  static constexpr uint8_t Width = Width_;
+  static constexpr I2cAccess Access = Access_;
+  static constexpr bool Volatile = Volatile_;
+  static constexpr uint32_t Reset = Reset_;
+
+  /**
+   * @brief The shift of the value of the byte at Address + Offset.
+   */
+  static constexpr uint8_t GetShift(const uint8_t Offset)
+  {
+    return Order_ == I2cOrder::MSB_FIRST ? (Width - 1 - Offset) * 8 :
+                                           Offset * 8;
+  }
+};
+
+template<typename Register_, uint8_t Lsb_, uint8_t Bits_>
+struct I2cField
+{
+  static_assert(Bits_ >= 1 && Lsb_ + Bits_ <= Register_::Width * 8,
+                "the field doesn't fit in its register");
+
+  using Register = Register_;
+  using Value_t = std::conditional_t<(Bits_ <= 8), uint8_t,
+                  std::conditional_t<(Bits_ <= 16), uint16_t, uint32_t>>;
+
+  static constexpr uint8_t Lsb = Lsb_;
+  static constexpr uint32_t Mask =
+    (Bits_ == 32 ? 0xFFFFFFFFul : ((1ul << Bits_) - 1)) << Lsb_;
+
+  Value_t Value;
+};
+
+template<uint8_t Device, typename... Registers>
+class I2cRegMap
+{
+  static_assert(sizeof...(Registers) > 0, "the map has no register");
+
+  static constexpr uint16_t End =
+    [](){ uint16_t e = 0; ((e = Registers::Address + Registers::Width > e ?
+      Registers::Address + Registers::Width : e), ...); return e; }();
+
+  enum : uint8_t
+  {
+    IN_MAP = 1,
+    READABLE = 2,
+    WRITABLE = 4,
+    VOLATILE = 8,
+  };
+
+  struct Bytes
+  {
+    uint8_t Value[End];
+  };
+
+  template<uint8_t Count>
+  struct Plan
+  {
+    uint8_t First[Count ? Count : 1];
+    uint8_t Last[Count ? Count : 1];
+    uint8_t Read[Count ? Count : 1]; /**< 1 if a burst of a write is read
+                                       first */
+  };
+
+public:
+  /**
+   * @brief Write fields. The registers of the fields are sent in the
+   * fewest bursts, their other fields keep their values.
+   * @return uint8_t 1 if all the bursts are done, the result of the failed
+   * I2c_SendBytes or I2c_ReceiveBytes otherwise.
+   */
+  template<typename... Fields>
+  static uint8_t Write(const I2c_t I2c, const Fields... Values)
+  {
+    static_assert(sizeof...(Fields) > 0, "nothing to write");
+    static_assert((IsListed<typename Fields::Register>() && ...),
+                  "a field of another map");
+    static_assert(((Fields::Register::Access != I2cAccess::READ_ONLY) && ...),
+                  "a field of a read-only register");
+
+    constexpr Bytes Touched = GetTouched<Fields...>();
+    constexpr uint8_t Min = GetMin(Touched);
+    constexpr uint8_t Max = GetMax(Touched);
+    constexpr uint8_t Count = GetSegments(Touched, 0);
+    constexpr Plan<Count> Bursts = GetPlan<Count>(Touched, 0);
+
+    static_assert(IsWritable(Touched),
+                  "a partial write of a volatile register which can't be read");
+
+    uint8_t Image[Max - Min + 1];
+    uint8_t Fresh[Max - Min + 1];
+    uint8_t res;
+    uint8_t i;
+    uint16_t j;
+
+    for(i = 0; i <= Max - Min; i++)
+      {
+        Image[i] = Shadow.Value[Min + i];
+      }
+
+    //only the volatile bytes are taken from the device, the others of the
+    //burst (e.g. write-only ones) don't read back what was written
+    for(i = 0; i < Count; i++)
+      {
+        if(Bursts.Read[i] == 0) continue;
+
+        res = I2c_ReceiveBytes(I2c, Device, Bursts.First[i],
+                               &Fresh[Bursts.First[i] - Min],
+                               Bursts.Last[i] - Bursts.First[i] + 1);
+        if(res != 1) return res;
+
+        for(j = Bursts.First[i]; j <= Bursts.Last[i]; j++)
+          {
+            if((Kinds.Value[j] & (READABLE | VOLATILE)) == (READABLE | VOLATILE))
+              {
+                Image[j - Min] = Fresh[j - Min];
+              }
+          }
+      }
+
+    (Put<Fields>(Image, Min, Values), ...);
+
+    for(i = 0; i < Count; i++)
+      {
+        res = I2c_SendBytes(I2c, Device, Bursts.First[i],
+                            &Image[Bursts.First[i] - Min],
+                            Bursts.Last[i] - Bursts.First[i] + 1);
+        if(res != 1) return res;
+
+        Save(Image, Min, Bursts.First[i], Bursts.Last[i]);
+      }
+
+    return 1;
+  }
+
+  /**
+   * @brief Read fields. The fields of the registers which aren't volatile
+   * are taken from RAM, the volatile registers are read in the fewest
+   * bursts.
+   * @return uint8_t 1 if all the bursts are done, the result of the failed
+   * I2c_ReceiveBytes otherwise.
+   */
+  template<typename... Fields>
+  static uint8_t Read(const I2c_t I2c, Fields&... Values)
+  {
+    static_assert(sizeof...(Fields) > 0, "nothing to read");
+    static_assert((IsListed<typename Fields::Register>() && ...),
+                  "a field of another map");
+    static_assert(((Fields::Register::Access != I2cAccess::WRITE_ONLY ||
+                    !Fields::Register::Volatile) && ...),
+                  "a field of a volatile write-only register");
+
+    constexpr Bytes Touched = GetTouched<Fields...>();
+    constexpr uint8_t Min = GetMin(Touched);
+    constexpr uint8_t Max = GetMax(Touched);
+    constexpr uint8_t Count = GetSegments(Touched, 1);
+    constexpr Plan<Count> Bursts = GetPlan<Count>(Touched, 1);
+
+    uint8_t Image[Max - Min + 1];
+    uint8_t res;
+    uint8_t i;
+
+    for(i = 0; i <= Max - Min; i++)
+      {
+        Image[i] = Shadow.Value[Min + i];
+      }
+
+    for(i = 0; i < Count; i++)
+      {
+        res = I2c_ReceiveBytes(I2c, Device, Bursts.First[i],
+                               &Image[Bursts.First[i] - Min],
+                               Bursts.Last[i] - Bursts.First[i] + 1);
+        if(res != 1) return res;
+      }
+
+    (Get<Fields>(Image, Min, Values), ...);
+
+    return 1;
+  }
+
+  /**
+   * @brief The bus bytes (without the start and stop bits) of a write of
+   * fields, to check the packing at compile time.
+   */
+  template<typename... Fields>
+  static constexpr uint16_t GetWriteCost()
+  {
+    constexpr Bytes Touched = GetTouched<Fields...>();
+    constexpr uint8_t Count = GetSegments(Touched, 0);
+
+    return GetCost<Count>(GetPlan<Count>(Touched, 0), 0);
+  }
+
+  /**
+   * @brief The bus bytes (without the start and stop bits) of a read of
+   * fields.
+   */
+  template<typename... Fields>
+  static constexpr uint16_t GetReadCost()
+  {
+    constexpr Bytes Touched = GetTouched<Fields...>();
+    constexpr uint8_t Count = GetSegments(Touched, 1);
+
+    return GetCost<Count>(GetPlan<Count>(Touched, 1), 1);
+  }
+
+  /**
+   * @brief Set the registers kept in RAM to their reset values. It must be
+   * called after the device is reset.
+   */
+  static void Reset()
+  {
+    for(uint16_t i = 0; i < End; i++)
+      {
+        Shadow.Value[i] = Resets.Value[i];
+      }
+  }
+
+private:
+  template<typename Register>
+  static constexpr bool IsListed()
+  {
+    return (std::is_same_v<Register, Registers> || ...);
+  }
+
+  static constexpr Bytes GetKinds()
+  {
+    Bytes Kinds{};
+
+    ([&Kinds](){
+      for(uint8_t i = 0; i < Registers::Width; i++)
+        {
+          Kinds.Value[Registers::Address + i] = IN_MAP |
+            (Registers::Access != I2cAccess::WRITE_ONLY ? READABLE : 0) |
+            (Registers::Access != I2cAccess::READ_ONLY ? WRITABLE : 0) |
+            (Registers::Volatile || Registers::Access == I2cAccess::READ_ONLY ?
+             VOLATILE : 0);
+        }
+    }(), ...);
+
+    return Kinds;
+  }
+
+  static constexpr Bytes GetResets()
+  {
+    Bytes Values{};
+
+    ([&Values](){
+      for(uint8_t i = 0; i < Registers::Width; i++)
+        {
+          Values.Value[Registers::Address + i] =
+            (uint8_t)(Registers::Reset >> Registers::GetShift(i));
+        }
+    }(), ...);
+
+    return Values;
+  }
+
+  static constexpr Bytes Kinds = GetKinds();
+  static constexpr Bytes Resets = GetResets();
+
+  /**
+   * @brief The bits of every byte of the map touched by the fields.
+   */
+  template<typename... Fields>
+  static constexpr Bytes GetTouched()
+  {
+    Bytes Touched{};
+
+    ([&Touched](){
+      using Register = typename Fields::Register;
+      for(uint8_t i = 0; i < Register::Width; i++)
+        {
+          Touched.Value[Register::Address + i] |=
+            (uint8_t)(Fields::Mask >> Register::GetShift(i));
+        }
+    }(), ...);
+
+    return Touched;
+  }
+
+  static constexpr uint8_t GetMin(const Bytes& Touched)
+  {
+    uint16_t i = 0;
+
+    while(i + 1 < End && Touched.Value[i] == 0) i++;
+
+    return i;
+  }
+
+  static constexpr uint8_t GetMax(const Bytes& Touched)
+  {
+    uint16_t i = End - 1;
+
+    while(i > 0 && Touched.Value[i] == 0) i--;
+
+    return i;
+  }
+
+  /**
+   * @brief Whether a byte must be in a burst: a touched byte of a write, a
+   * touched volatile byte of a read.
+   */
+  static constexpr bool IsNeeded(const Bytes& Touched,
+                                 const uint16_t i,
+                                 const uint8_t ForRead)
+  {
+    return Touched.Value[i] != 0 &&
+      (ForRead == 0 || (Kinds.Value[i] & VOLATILE) != 0);
+  }
+
+  /**
+   * @brief Whether a burst can go over a byte it doesn't need: a write
+   * sends it from RAM again, a read mustn't pop a volatile register.
+   */
+  static constexpr bool IsGapFree(const uint16_t i, const uint8_t ForRead)
+  {
+    return ForRead == 0 ?
+      (Kinds.Value[i] & (IN_MAP | WRITABLE | VOLATILE)) == (IN_MAP | WRITABLE) :
+      (Kinds.Value[i] & (IN_MAP | READABLE | VOLATILE)) == (IN_MAP | READABLE);
+  }
+
+  /**
+   * @brief Walk the bursts of an access. Count is the size of Bursts, 0 to
+   * only count them.
+   */
+  template<uint8_t Count>
+  static constexpr uint8_t Walk(const Bytes& Touched,
+                                const uint8_t ForRead,
+                                Plan<Count>* const Bursts)
+  {
+    const uint8_t Header = ForRead ? I2C_REGMAP_READ_HEADER :
+                                     I2C_REGMAP_WRITE_HEADER;
+    uint8_t Segments = 0;
+    uint16_t First = 0;
+    uint16_t Last = 0;
+    uint16_t i = 0;
+    uint16_t j = 0;
+    uint16_t k = 0;
+    bool Mergeable = false;
+    bool NeedRead = false;
+
+    while(i < End)
+      {
+        if(!IsNeeded(Touched, i, ForRead))
+          {
+            i++;
+            continue;
+          }
+
+        First = i;
+        Last = i;
+        for(j = i + 1; j < End; j++)
+          {
+            if(!IsNeeded(Touched, j, ForRead)) continue;
+
+            Mergeable = j - Last - 1 <= Header;
+            for(k = Last + 1; k < j && Mergeable; k++)
+              {
+                Mergeable = IsGapFree(k, ForRead);
+              }
+            if(!Mergeable) break;
+
+            Last = j;
+          }
+
+        NeedRead = false;
+        for(k = First; k <= Last; k++)
+          {
+            NeedRead = NeedRead || ((Kinds.Value[k] & VOLATILE) != 0 &&
+                                    Touched.Value[k] != 0xFF);
+          }
+
+        if(Bursts != nullptr)
+          {
+            Bursts->First[Segments] = First;
+            Bursts->Last[Segments] = Last;
+            Bursts->Read[Segments] = ForRead == 0 && NeedRead;
+          }
+        Segments++;
+        i = Last + 1;
+      }
+
+    return Segments;
+  }
+
+  static constexpr uint8_t GetSegments(const Bytes& Touched,
+                                       const uint8_t ForRead)
+  {
+    return Walk<0>(Touched, ForRead, nullptr);
+  }
+
+  template<uint8_t Count>
+  static constexpr Plan<Count> GetPlan(const Bytes& Touched,
+                                       const uint8_t ForRead)
+  {
+    Plan<Count> Bursts{};
+
+    Walk<Count>(Touched, ForRead, &Bursts);
+
+    return Bursts;
+  }
+
+  template<uint8_t Count>
+  static constexpr uint16_t GetCost(const Plan<Count>& Bursts,
+                                    const uint8_t ForRead)
+  {
+    uint16_t Cost = 0;
+
+    for(uint8_t i = 0; i < Count; i++)
+      {
+        Cost += Bursts.Last[i] - Bursts.First[i] + 1 +
+          (ForRead ? I2C_REGMAP_READ_HEADER : I2C_REGMAP_WRITE_HEADER);
+        if(Bursts.Read[i] != 0)
+          {
+            Cost += Bursts.Last[i] - Bursts.First[i] + 1 +
+              I2C_REGMAP_READ_HEADER;
+          }
+      }
+
+    return Cost;
+  }
+
+  /**
+   * @brief Whether every partially written volatile byte can be read.
+   */
+  static constexpr bool IsWritable(const Bytes& Touched)
+  {
+    for(uint16_t i = 0; i < End; i++)
+      {
+        if(Touched.Value[i] != 0 && Touched.Value[i] != 0xFF &&
+          (Kinds.Value[i] & (VOLATILE | READABLE)) == VOLATILE)
+          {
+            return false;
+          }
+      }
+
+    return true;
+  }
+
+  template<typename Field>
+  static void Put(uint8_t* const Image,
+                  const uint8_t Min,
+                  const Field Value)
+  {
+    using Register = typename Field::Register;
+    const uint32_t Bits = ((uint32_t)Value.Value << Field::Lsb) & Field::Mask;
+    uint8_t* const Byte = &Image[Register::Address - Min];
+    uint8_t Mask;
+
+    for(uint8_t i = 0; i < Register::Width; i++)
+      {
+        Mask = (uint8_t)(Field::Mask >> Register::GetShift(i));
+        Byte[i] = (Byte[i] & ~Mask) |
+                  (uint8_t)(Bits >> Register::GetShift(i));
+      }
+  }
+
+  template<typename Field>
+  static void Get(const uint8_t* const Image,
+                  const uint8_t Min,
+                  Field& Value)
+  {
+    using Register = typename Field::Register;
+    const uint8_t* const Byte = &Image[Register::Address - Min];
+    uint32_t Bits = 0;
+
+    for(uint8_t i = 0; i < Register::Width; i++)
+      {
+        Bits |= (uint32_t)Byte[i] << Register::GetShift(i);
+      }
+
+    Value.Value = (typename Field::Value_t)((Bits & Field::Mask) >> Field::Lsb);
+  }
+
+  /**
+   * @brief Keep the written bytes which aren't volatile in RAM.
+   */
+  static void Save(const uint8_t* const Image,
+                   const uint8_t Min,
+                   const uint8_t First,
+                   const uint8_t Last)
+  {
+    for(uint16_t i = First; i <= Last; i++)
+      {
+        if((Kinds.Value[i] & VOLATILE) == 0)
+          {
+            Shadow.Value[i] = Image[i - Min];
+          }
+      }
+  }
+
+  static inline Bytes Shadow = GetResets(); /**< the registers which aren't
+                                              volatile */
+};
+
+#endif
+/*****************************End of File ************************************/
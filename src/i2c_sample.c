@@ -0,0 +1,273 @@
+/**
+ * @file i2c_sample.c
+ * @author Mohamed Hassanin
+ * @brief I2C sample reading and decoding. The FIFO of a sensor is read with
+ * one burst straight into the destination array, then its samples are
+ * decoded in place into native integers as described by their format
+ * (I2cSampleFormat_t): the bytes are ordered, the value is extracted and
+ * sign-extended. The data is only copied by the hardware and walked once.
+ * The 16-bit samples are decoded 8 at a time with the vector extensions of
+ * GCC if I2C_SAMPLE_VECTOR is 1, by a scalar loop otherwise.
+ * @version 0.1
+ * @date 2021-05-28
+ */
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <inttypes.h>
+#include <string.h>
+#include "i2c_sample.h"
+/******************************************************************************
+ * typedefs
+ ******************************************************************************/
+#if I2C_SAMPLE_VECTOR == 1
+typedef uint16_t I2cSampleVector_t __attribute__ ((vector_size (16)));
+#endif
+/******************************************************************************
+ * functions prototypes
+ ******************************************************************************/
+static uint8_t I2cSample_IsValid(const I2cSampleFormat_t* const Format);
+static void I2cSample_DecodeBytes(const I2cSampleFormat_t* const Format,
+                                  int16_t* const Samples,
+                                  const uint8_t Count);
+static void I2cSample_DecodeWords(const I2cSampleFormat_t* const Format,
+                                  int16_t* const Samples,
+                                  const uint8_t First,
+                                  const uint8_t Count);
+#if I2C_SAMPLE_VECTOR == 1
+static uint8_t I2cSample_DecodeVector(const I2cSampleFormat_t* const Format,
+                                      int16_t* const Samples,
+                                      const uint8_t Count);
+#endif
+/******************************************************************************
+ * functions definitions
+ ******************************************************************************/
+/******************************************************************************
+* Function : I2cSample_Read()
+*//**
+* \b Description:
+* Read samples from successive device registers using I2C starting from a
+* register, and decode them. The bytes are received straight into Samples,
+* then each one is replaced by its value. <br>
+* POST-CONDITION: Samples holds the values, an unsigned 16-bit value is
+* read back by casting it to uint16_t <br>
+* @param I2c the id of the I2C peripheral
+* @param Address the address of the device
+* @param Register the first register to read, e.g. the FIFO
+* @param Format the format of the samples
+* @param Samples a pointer to receive the values in
+* @param Count the number of the samples. It must be at least 1.
+* @return uint8_t 1 the operations is done successfully
+*                 2 start bit error
+*                 3 address error
+*                 4 register sending error
+*                 5 data receiving error
+*                 6 the peripheral is busy
+*                 0 the format is invalid
+ ******************************************************************************/
+extern uint8_t
+I2cSample_Read(const I2c_t I2c,
+               const uint8_t Address,
+               const uint8_t Register,
+               const I2cSampleFormat_t* const Format,
+               int16_t* const Samples,
+               const uint8_t Count)
+{
+  if(!(Format != 0x0 && Samples != 0x0 && Count != 0 &&
+       I2cSample_IsValid(Format) != 0)) return 0;
+
+  uint8_t Program[12];
+  I2cTransfer_t Transfer = { Program, Address, Register, 0x0,
+                             (uint8_t*)Samples, 0x0, 0x0 };
+  uint16_t Remaining;
+  uint8_t Chunk;
+  uint8_t i = 0;
+  uint8_t res;
+
+  Program[i++] = I2C_OP_START;
+  Program[i++] = I2C_OP_ADDR_W;
+  Program[i++] = I2C_OP_REG;
+  Program[i++] = I2C_OP_START;
+  Program[i++] = I2C_OP_ADDR_R;
+  //acknowledge all the bytes except the last one, at most 255 per op
+  for(Remaining = (uint16_t)Count * Format->Size - 1; Remaining != 0;
+      Remaining -= Chunk)
+    {
+      Chunk = Remaining > 255 ? 255 : (uint8_t)Remaining;
+      Program[i++] = I2C_OP_RX_ACK;
+      Program[i++] = Chunk;
+    }
+  Program[i++] = I2C_OP_RX_NACK;
+  Program[i++] = I2C_OP_STOP;
+  Program[i] = I2C_OP_END;
+
+  res = I2c_Transfer(I2c, &Transfer);
+  if(res == 1)
+    {
+      I2cSample_Decode(Format, Samples, Count);
+    }
+
+  return res;
+}
+
+/******************************************************************************
+* Function : I2cSample_Decode()
+*//**
+* \b Description:
+* Decode samples in place, e.g. the ones of an asynchronous transfer. The
+* bytes of the samples are read from the start of Samples, and replaced by
+* the values. <br>
+* @param Format the format of the samples
+* @param Samples the bytes of the samples, to replace with the values
+* @param Count the number of the samples
+* @return uint8_t 1 if the samples are decoded, 0 if the format is invalid.
+ ******************************************************************************/
+extern uint8_t
+I2cSample_Decode(const I2cSampleFormat_t* const Format,
+                 int16_t* const Samples,
+                 const uint8_t Count)
+{
+  if(!(Format != 0x0 && Samples != 0x0 &&
+       I2cSample_IsValid(Format) != 0)) return 0;
+
+  uint8_t First = 0;
+
+  if(Format->Size == 1)
+    {
+      I2cSample_DecodeBytes(Format, Samples, Count);
+      return 1;
+    }
+
+#if I2C_SAMPLE_VECTOR == 1
+  First = I2cSample_DecodeVector(Format, Samples, Count);
+#endif
+  I2cSample_DecodeWords(Format, Samples, First, Count);
+
+  return 1;
+}
+
+/******************************************************************************
+* Function : I2cSample_IsValid()
+*//**
+* \b Description:
+* Utility function to check that the value of a format fits in its
+* sample. <br>
+* @param Format the format of the samples
+* @return uint8_t 1 if the format is valid, 0 otherwise.
+ ******************************************************************************/
+static uint8_t
+I2cSample_IsValid(const I2cSampleFormat_t* const Format)
+{
+  return (Format->Size == 1 || Format->Size == 2) && Format->Bits != 0 &&
+         Format->Bits + Format->Shift <= 8 * Format->Size;
+}
+
+/******************************************************************************
+* Function : I2cSample_DecodeBytes()
+*//**
+* \b Description:
+* Utility function to decode the samples of one byte. The value of a
+* sample takes twice its room, so they're decoded from the last one. <br>
+* @param Format the format of the samples
+* @param Samples the bytes of the samples, to replace with the values
+* @param Count the number of the samples
+* @return void
+ ******************************************************************************/
+static void
+I2cSample_DecodeBytes(const I2cSampleFormat_t* const Format,
+                      int16_t* const Samples,
+                      const uint8_t Count)
+{
+  const uint8_t* const Raw = (const uint8_t*)Samples;
+  //the value is moved to the top of 16 bits, then back with its sign
+  const uint8_t Left = 16 - Format->Bits - Format->Shift;
+  const uint8_t Right = 16 - Format->Bits;
+  const uint16_t Sign = Format->Signed != 0 ? 1u << (Format->Bits - 1) : 0;
+  uint16_t Value;
+  uint8_t i;
+
+  for(i = Count; i != 0; i--)
+    {
+      Value = (uint16_t)(Raw[i - 1] << Left) >> Right;
+      Samples[i - 1] = (int16_t)((Value ^ Sign) - Sign);
+    }
+}
+
+/******************************************************************************
+* Function : I2cSample_DecodeWords()
+*//**
+* \b Description:
+* Utility function to decode the samples of two bytes one at a time. <br>
+* @param Format the format of the samples
+* @param Samples the bytes of the samples, to replace with the values
+* @param First the first sample to decode
+* @param Count the number of the samples
+* @return void
+ ******************************************************************************/
+static void
+I2cSample_DecodeWords(const I2cSampleFormat_t* const Format,
+                      int16_t* const Samples,
+                      const uint8_t First,
+                      const uint8_t Count)
+{
+  const uint8_t* Raw = (const uint8_t*)&Samples[First];
+  const uint8_t High = Format->BigEndian != 0 ? 0 : 1;
+  const uint8_t Left = 16 - Format->Bits - Format->Shift;
+  const uint8_t Right = 16 - Format->Bits;
+  const uint16_t Sign = Format->Signed != 0 ? 1u << (Format->Bits - 1) : 0;
+  uint16_t Value;
+  uint8_t i;
+
+  for(i = First; i < Count; i++)
+    {
+      Value = (uint16_t)(Raw[High] << 8 | Raw[High ^ 1]);
+      Value = (uint16_t)(Value << Left) >> Right;
+      Samples[i] = (int16_t)((Value ^ Sign) - Sign);
+      Raw += 2;
+    }
+}
+
+#if I2C_SAMPLE_VECTOR == 1
+/******************************************************************************
+* Function : I2cSample_DecodeVector()
+*//**
+* \b Description:
+* Utility function to decode the samples of two bytes 8 at a time. The
+* bytes are swapped if the order of the samples isn't the one of the CPU,
+* the value is extracted by two shifts and sign-extended by an exclusive or
+* and a subtraction, with no branch. <br>
+* @param Format the format of the samples
+* @param Samples the bytes of the samples, to replace with the values
+* @param Count the number of the samples
+* @return uint8_t the number of the samples decoded, the rest is left for
+* I2cSample_DecodeWords
+ ******************************************************************************/
+static uint8_t
+I2cSample_DecodeVector(const I2cSampleFormat_t* const Format,
+                       int16_t* const Samples,
+                       const uint8_t Count)
+{
+  const uint8_t Swap = (Format->BigEndian != 0) ==
+                       (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__);
+  const uint8_t Left = 16 - Format->Bits - Format->Shift;
+  const uint8_t Right = 16 - Format->Bits;
+  const uint16_t Sign = Format->Signed != 0 ? 1u << (Format->Bits - 1) : 0;
+  I2cSampleVector_t Value;
+  uint8_t i;
+
+  for(i = 0; Count - i >= 8; i += 8)
+    {
+      //the array of the samples may not be aligned to the vector
+      memcpy(&Value, &Samples[i], sizeof(Value));
+      if(Swap != 0)
+        {
+          Value = Value << 8 | Value >> 8;
+        }
+      Value = ((Value << Left) >> Right ^ Sign) - Sign;
+      memcpy(&Samples[i], &Value, sizeof(Value));
+    }
+
+  return i;
+}
+#endif
+/*****************************End of File ************************************/
@@ -0,0 +1,67 @@
+/**
+ * @file i2c_sample.h
+ * @author Mohamed Hassanin
+ * @brief I2C sample reading and decoding header file.
+ * @version 0.1
+ * @date 2021-05-28
+ */
+#ifndef I2C_SAMPLE_H
+#define I2C_SAMPLE_H
+/******************************************************************************
+ * Definitions
+ ******************************************************************************/
+/**
+ * @brief Some formats of the sensor FIFOs, to initialize an
+ * I2cSampleFormat_t.
+ */
+#define I2C_SAMPLE_S16_BE { 2, 1, 16, 0, 1 } /**< signed 16-bit big-endian */
+#define I2C_SAMPLE_S16_LE { 2, 0, 16, 0, 1 } /**< signed 16-bit little-endian */
+#define I2C_SAMPLE_S12_LJ_BE { 2, 1, 12, 4, 1 } /**< signed 12-bit
+                                                  left-justified big-endian */
+#define I2C_SAMPLE_U12_LJ_BE { 2, 1, 12, 4, 0 } /**< unsigned 12-bit
+                                                  left-justified big-endian */
+#define I2C_SAMPLE_S8 { 1, 0, 8, 0, 1 } /**< signed 8-bit */
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "i2c.h"
+/******************************************************************************
+ * Typedefs
+ ******************************************************************************/
+/**
+ * @brief The format of the samples of a device. A sample is Size bytes, its
+ * value is Bits bits starting at bit Shift, the other bits are ignored.
+ */
+typedef struct
+{
+  uint8_t Size; /**< the bytes of a sample, 1 or 2 */
+  uint8_t BigEndian; /**< 1 if the first byte is the most significant one */
+  uint8_t Bits; /**< the bits of the value, from 1 to 8 * Size */
+  uint8_t Shift; /**< the position of the least significant bit of the
+                   value: 0 if it's right-justified, 8 * Size - Bits if it's
+                   left-justified */
+  uint8_t Signed; /**< 1 if the value is two's complement */
+}I2cSampleFormat_t;
+/******************************************************************************
+ * Function prototypes
+ ******************************************************************************/
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+extern uint8_t I2cSample_Read(const I2c_t I2c,
+                              const uint8_t Address,
+                              const uint8_t Register,
+                              const I2cSampleFormat_t* const Format,
+                              int16_t* const Samples,
+                              const uint8_t Count);
+extern uint8_t I2cSample_Decode(const I2cSampleFormat_t* const Format,
+                                int16_t* const Samples,
+                                const uint8_t Count);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
+/*****************************End of File ************************************/
@@ -0,0 +1,500 @@
+/**
+ * @file i2c_smbus.c
+ * @author Mohamed Hassanin
+ * @brief SMBus block transfers and process calls on top of the I2C driver.
+ * Every transaction is one program run by I2c_Transfer, so it holds the bus
+ * from its start bit to its stop bit. The Packet Error Code (CRC-8,
+ * polynomial x^8 + x^2 + x + 1) is updated with every byte as it's sent or
+ * received, so checking a transfer doesn't need a second pass over the
+ * buffer.
+ * @version 0.1
+ * @date 2021-05-15
+ */
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <inttypes.h>
+#include "i2c_smbus.h"
+/******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define I2C_SMBUS_OPS_MAX 12 /**< The ops of the longest program, with its end */
+#define I2C_SMBUS_BLOCK_READ 0 /**< The length of a read of a block */
+
+#if I2C_RX_BLOCK_MAX != I2C_SMBUS_BLOCK_MAX
+#error "I2C_OP_RX_BLOCK must take the blocks of SMBus"
+#endif
+/******************************************************************************
+ * typedefs
+ ******************************************************************************/
+typedef struct
+{
+  I2cTransfer_t Transfer; /**< the program, the first member, see
+                            I2cSmbus_Receive */
+  uint8_t Tx[1 + I2C_SMBUS_BLOCK_MAX + 1]; /**< the bytes to send and the
+                                             PEC of a write */
+  uint8_t TxLength; /**< the bytes of Tx taken */
+  uint8_t* Rx; /**< where to save the received bytes, without the byte
+                 count and the PEC */
+  uint8_t RxLength; /**< the bytes to save, the byte count of a block once
+                      it's received */
+  uint8_t Received; /**< the bytes received after the byte count */
+  uint8_t Block; /**< 1 until the byte count of a block is received */
+  uint8_t Pec; /**< 1 if the transaction uses the Packet Error Code */
+  uint8_t Crc; /**< the Packet Error Code of the bytes moved so far */
+}I2cSmbusRun_t;
+/******************************************************************************
+ * module variables definitions
+ ******************************************************************************/
+#if I2C_SMBUS_PEC_NIBBLE_TABLE == 1
+/**
+ * The CRC-8 of every nibble shifted in from the top of the CRC.
+ */
+static const uint8_t gCrcTable[16] =
+{
+  0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15,
+  0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D,
+};
+#else
+/**
+ * The CRC-8 of every byte.
+ */
+static const uint8_t gCrcTable[256] =
+{
+  0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15,
+  0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D,
+  0x70, 0x77, 0x7E, 0x79, 0x6C, 0x6B, 0x62, 0x65,
+  0x48, 0x4F, 0x46, 0x41, 0x54, 0x53, 0x5A, 0x5D,
+  0xE0, 0xE7, 0xEE, 0xE9, 0xFC, 0xFB, 0xF2, 0xF5,
+  0xD8, 0xDF, 0xD6, 0xD1, 0xC4, 0xC3, 0xCA, 0xCD,
+  0x90, 0x97, 0x9E, 0x99, 0x8C, 0x8B, 0x82, 0x85,
+  0xA8, 0xAF, 0xA6, 0xA1, 0xB4, 0xB3, 0xBA, 0xBD,
+  0xC7, 0xC0, 0xC9, 0xCE, 0xDB, 0xDC, 0xD5, 0xD2,
+  0xFF, 0xF8, 0xF1, 0xF6, 0xE3, 0xE4, 0xED, 0xEA,
+  0xB7, 0xB0, 0xB9, 0xBE, 0xAB, 0xAC, 0xA5, 0xA2,
+  0x8F, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9D, 0x9A,
+  0x27, 0x20, 0x29, 0x2E, 0x3B, 0x3C, 0x35, 0x32,
+  0x1F, 0x18, 0x11, 0x16, 0x03, 0x04, 0x0D, 0x0A,
+  0x57, 0x50, 0x59, 0x5E, 0x4B, 0x4C, 0x45, 0x42,
+  0x6F, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7D, 0x7A,
+  0x89, 0x8E, 0x87, 0x80, 0x95, 0x92, 0x9B, 0x9C,
+  0xB1, 0xB6, 0xBF, 0xB8, 0xAD, 0xAA, 0xA3, 0xA4,
+  0xF9, 0xFE, 0xF7, 0xF0, 0xE5, 0xE2, 0xEB, 0xEC,
+  0xC1, 0xC6, 0xCF, 0xC8, 0xDD, 0xDA, 0xD3, 0xD4,
+  0x69, 0x6E, 0x67, 0x60, 0x75, 0x72, 0x7B, 0x7C,
+  0x51, 0x56, 0x5F, 0x58, 0x4D, 0x4A, 0x43, 0x44,
+  0x19, 0x1E, 0x17, 0x10, 0x05, 0x02, 0x0B, 0x0C,
+  0x21, 0x26, 0x2F, 0x28, 0x3D, 0x3A, 0x33, 0x34,
+  0x4E, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5C, 0x5B,
+  0x76, 0x71, 0x78, 0x7F, 0x6A, 0x6D, 0x64, 0x63,
+  0x3E, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2C, 0x2B,
+  0x06, 0x01, 0x08, 0x0F, 0x1A, 0x1D, 0x14, 0x13,
+  0xAE, 0xA9, 0xA0, 0xA7, 0xB2, 0xB5, 0xBC, 0xBB,
+  0x96, 0x91, 0x98, 0x9F, 0x8A, 0x8D, 0x84, 0x83,
+  0xDE, 0xD9, 0xD0, 0xD7, 0xC2, 0xC5, 0xCC, 0xCB,
+  0xE6, 0xE1, 0xE8, 0xEF, 0xFA, 0xFD, 0xF4, 0xF3,
+};
+#endif
+/******************************************************************************
+ * functions prototypes
+ ******************************************************************************/
+static void I2cSmbus_Begin(I2cSmbusRun_t* const Run,
+                           const uint8_t Address,
+                           const uint8_t Command,
+                           const uint8_t Pec);
+inline static void I2cSmbus_Put(I2cSmbusRun_t* const Run, const uint8_t Data);
+static uint8_t I2cSmbus_Run(const I2c_t I2c,
+                            I2cSmbusRun_t* const Run,
+                            uint8_t* const RxData,
+                            const uint8_t RxLength);
+static void I2cSmbus_Receive(const I2cTransfer_t* const Transfer,
+                             const uint8_t Data);
+/******************************************************************************
+ * functions definitions
+ ******************************************************************************/
+/******************************************************************************
+* Function : I2cSmbus_BlockWrite()
+*//**
+* \b Description: Write a block of bytes using the SMBus block write
+* protocol: command, byte count, the bytes and the optional PEC. <br>
+* @param I2c the id of the I2C peripheral
+* @param Address the address of the device
+* @param Command the command code
+* @param Data the bytes to write
+* @param Length the number of the bytes, from 1 to I2C_SMBUS_BLOCK_MAX
+* @param Pec 1 to append the Packet Error Code, 0 otherwise
+* @return uint8_t 1 the operations is done successfully
+*                 2 start bit error
+*                 3 address error
+*                 4 data sending error
+*                 6 the peripheral is busy
+ ******************************************************************************/
+extern uint8_t
+I2cSmbus_BlockWrite(const I2c_t I2c,
+                    const uint8_t Address,
+                    const uint8_t Command,
+                    const uint8_t* const Data,
+                    const uint8_t Length,
+                    const uint8_t Pec)
+{
+  if(!(I2c < I2C_MAX && Data != 0x0)) return 0;
+  if(!(Length != 0 && Length <= I2C_SMBUS_BLOCK_MAX)) return 0;
+
+  I2cSmbusRun_t Run;
+  uint8_t i;
+
+  I2cSmbus_Begin(&Run, Address, Command, Pec);
+  I2cSmbus_Put(&Run, Length);
+  for(i = 0; i < Length; i++)
+    {
+      I2cSmbus_Put(&Run, Data[i]);
+    }
+
+  return I2cSmbus_Run(I2c, &Run, 0x0, 0);
+}
+
+/******************************************************************************
+* Function : I2cSmbus_BlockRead()
+*//**
+* \b Description: Read a block of bytes using the SMBus block read
+* protocol. The byte count sent by the device is read first, then the
+* bytes and the optional PEC are received in the same transaction. <br>
+* @param I2c the id of the I2C peripheral
+* @param Address the address of the device
+* @param Command the command code
+* @param Data a buffer of I2C_SMBUS_BLOCK_MAX bytes to receive the bytes in
+* @param Length a pointer to receive the number of the bytes in
+* @param Pec 1 to receive and check the Packet Error Code, 0 otherwise
+* @return uint8_t 1 the operations is done successfully
+*                 2 start bit error
+*                 3 address error
+*                 4 command sending error
+*                 5 data receiving error
+*                 6 the peripheral is busy
+*                 7 invalid byte count
+*                 8 PEC error
+ ******************************************************************************/
+extern uint8_t
+I2cSmbus_BlockRead(const I2c_t I2c,
+                   const uint8_t Address,
+                   const uint8_t Command,
+                   uint8_t* const Data,
+                   uint8_t* const Length,
+                   const uint8_t Pec)
+{
+  if(!(I2c < I2C_MAX && Data != 0x0 && Length != 0x0)) return 0;
+
+  I2cSmbusRun_t Run;
+  uint8_t res;
+
+  I2cSmbus_Begin(&Run, Address, Command, Pec);
+
+  res = I2cSmbus_Run(I2c, &Run, Data, I2C_SMBUS_BLOCK_READ);
+  if(res != 1) return res;
+
+  *Length = Run.RxLength;
+
+  return 1;
+}
+
+/******************************************************************************
+* Function : I2cSmbus_ProcessCall()
+*//**
+* \b Description: Send a word and receive a word in one transaction using
+* the SMBus process call protocol. The words are sent low byte first. <br>
+* @param I2c the id of the I2C peripheral
+* @param Address the address of the device
+* @param Command the command code
+* @param Value the word to send
+* @param Result a pointer to receive the word in
+* @param Pec 1 to receive and check the Packet Error Code, 0 otherwise
+* @return uint8_t 1 the operations is done successfully
+*                 2 start bit error
+*                 3 address error
+*                 4 data sending error
+*                 5 data receiving error
+*                 6 the peripheral is busy
+*                 8 PEC error
+ ******************************************************************************/
+extern uint8_t
+I2cSmbus_ProcessCall(const I2c_t I2c,
+                     const uint8_t Address,
+                     const uint8_t Command,
+                     const uint16_t Value,
+                     uint16_t* const Result,
+                     const uint8_t Pec)
+{
+  if(!(I2c < I2C_MAX && Result != 0x0)) return 0;
+
+  I2cSmbusRun_t Run;
+  uint8_t Rx[2];
+  uint8_t res;
+
+  I2cSmbus_Begin(&Run, Address, Command, Pec);
+  I2cSmbus_Put(&Run, (uint8_t)Value);
+  I2cSmbus_Put(&Run, (uint8_t)(Value >> 8));
+
+  res = I2cSmbus_Run(I2c, &Run, Rx, 2);
+  if(res != 1) return res;
+
+  *Result = (uint16_t)Rx[1] << 8 | Rx[0];
+
+  return 1;
+}
+
+/******************************************************************************
+* Function : I2cSmbus_BlockProcessCall()
+*//**
+* \b Description: Send a block and receive a block in one transaction using
+* the SMBus block write-block read process call protocol. <br>
+* @param I2c the id of the I2C peripheral
+* @param Address the address of the device
+* @param Command the command code
+* @param TxData the bytes to write
+* @param TxLength the number of the bytes to write, from 1 to
+* I2C_SMBUS_BLOCK_MAX
+* @param RxData a buffer of I2C_SMBUS_BLOCK_MAX bytes to receive the bytes in
+* @param RxLength a pointer to receive the number of the received bytes in
+* @param Pec 1 to receive and check the Packet Error Code, 0 otherwise
+* @return uint8_t 1 the operations is done successfully
+*                 2 start bit error
+*                 3 address error
+*                 4 data sending error
+*                 5 data receiving error
+*                 6 the peripheral is busy
+*                 7 invalid byte count
+*                 8 PEC error
+ ******************************************************************************/
+extern uint8_t
+I2cSmbus_BlockProcessCall(const I2c_t I2c,
+                          const uint8_t Address,
+                          const uint8_t Command,
+                          const uint8_t* const TxData,
+                          const uint8_t TxLength,
+                          uint8_t* const RxData,
+                          uint8_t* const RxLength,
+                          const uint8_t Pec)
+{
+  if(!(I2c < I2C_MAX && TxData != 0x0 && RxData != 0x0 && RxLength != 0x0))
+    {
+      return 0;
+    }
+  if(!(TxLength != 0 && TxLength <= I2C_SMBUS_BLOCK_MAX)) return 0;
+
+  I2cSmbusRun_t Run;
+  uint8_t res;
+  uint8_t i;
+
+  I2cSmbus_Begin(&Run, Address, Command, Pec);
+  I2cSmbus_Put(&Run, TxLength);
+  for(i = 0; i < TxLength; i++)
+    {
+      I2cSmbus_Put(&Run, TxData[i]);
+    }
+
+  res = I2cSmbus_Run(I2c, &Run, RxData, I2C_SMBUS_BLOCK_READ);
+  if(res != 1) return res;
+
+  *RxLength = Run.RxLength;
+
+  return 1;
+}
+
+/******************************************************************************
+* Function : I2cSmbus_Crc8()
+*//**
+* \b Description: Update a Packet Error Code with one byte <br>
+* @param Crc the Packet Error Code of the previous bytes, 0 initially
+* @param Data the byte
+* @return uint8_t the updated Packet Error Code
+ ******************************************************************************/
+extern uint8_t
+I2cSmbus_Crc8(const uint8_t Crc, const uint8_t Data)
+{
+  uint8_t Result = Crc ^ Data;
+
+#if I2C_SMBUS_PEC_NIBBLE_TABLE == 1
+  Result = (uint8_t)(Result << 4) ^ gCrcTable[Result >> 4];
+  Result = (uint8_t)(Result << 4) ^ gCrcTable[Result >> 4];
+#else
+  Result = gCrcTable[Result];
+#endif
+
+  return Result;
+}
+
+/******************************************************************************
+* Function : I2cSmbus_Begin()
+*//**
+* \b Description: Utility function to start a transaction: the Packet Error
+* Code takes the address and the command code, which are sent first. <br>
+* @param Run the transaction
+* @param Address the address of the device
+* @param Command the command code
+* @param Pec 1 if the transaction uses the Packet Error Code, 0 otherwise
+* @return void
+ ******************************************************************************/
+static void
+I2cSmbus_Begin(I2cSmbusRun_t* const Run,
+               const uint8_t Address,
+               const uint8_t Command,
+               const uint8_t Pec)
+{
+  Run->Transfer.Address = Address;
+  Run->Transfer.Register = Command;
+  Run->TxLength = 0;
+  Run->Pec = Pec != 0;
+  Run->Crc = 0;
+
+  if(Run->Pec != 0)
+    {
+      Run->Crc = I2cSmbus_Crc8(Run->Crc, (uint8_t)(Address << 1));
+      Run->Crc = I2cSmbus_Crc8(Run->Crc, Command);
+    }
+}
+
+/******************************************************************************
+* Function : I2cSmbus_Put()
+*//**
+* \b Description: Utility function to add a byte to send after the command
+* code, and to the Packet Error Code. <br>
+* @param Run the transaction
+* @param Data the byte
+* @return void
+ ******************************************************************************/
+inline static void
+I2cSmbus_Put(I2cSmbusRun_t* const Run, const uint8_t Data)
+{
+  Run->Tx[Run->TxLength] = Data;
+  Run->TxLength++;
+
+  if(Run->Pec != 0)
+    {
+      Run->Crc = I2cSmbus_Crc8(Run->Crc, Data);
+    }
+}
+
+/******************************************************************************
+* Function : I2cSmbus_Run()
+*//**
+* \b Description: Utility function to run a transaction as one program: the
+* command, the bytes to send if any, then a repeated start and the bytes to
+* receive if any. The PEC is sent after the bytes of a write. The bytes of
+* a read are given to I2cSmbus_Receive as they're received, the PEC at the
+* end is right if the Packet Error Code of all the bytes with it is 0. <br>
+* @param I2c the id of the I2C peripheral
+* @param Run the transaction, its bytes to send are added
+* @param RxData a buffer to receive the bytes in, 0x0 for a write
+* @param RxLength the number of the bytes to receive, or
+* I2C_SMBUS_BLOCK_READ to receive the byte count then the block
+* @return uint8_t the result of I2c_Transfer, or 8 on a PEC error
+ ******************************************************************************/
+static uint8_t
+I2cSmbus_Run(const I2c_t I2c,
+             I2cSmbusRun_t* const Run,
+             uint8_t* const RxData,
+             const uint8_t RxLength)
+{
+  uint8_t Program[I2C_SMBUS_OPS_MAX];
+  uint8_t Length = 0;
+  uint8_t res;
+
+  Program[Length++] = I2C_OP_START;
+  Program[Length++] = I2C_OP_ADDR_W;
+  Program[Length++] = I2C_OP_REG;
+
+  if(RxData == 0x0 && Run->Pec != 0)
+    {
+      I2cSmbus_Put(Run, Run->Crc);
+    }
+  if(Run->TxLength != 0)
+    {
+      Program[Length++] = I2C_OP_TX;
+      Program[Length++] = Run->TxLength;
+    }
+
+  if(RxData != 0x0)
+    {
+      Program[Length++] = I2C_OP_START;
+      Program[Length++] = I2C_OP_ADDR_R;
+
+      if(RxLength == I2C_SMBUS_BLOCK_READ)
+        {
+          Program[Length++] = I2C_OP_RX_BLOCK;
+          Program[Length++] = Run->Pec;
+        }
+      else
+        {
+          if(RxLength + Run->Pec > 1)
+            {
+              Program[Length++] = I2C_OP_RX_ACK;
+              Program[Length++] = RxLength + Run->Pec - 1;
+            }
+          Program[Length++] = I2C_OP_RX_NACK;
+        }
+
+      if(Run->Pec != 0)
+        {
+          Run->Crc = I2cSmbus_Crc8(Run->Crc,
+                                   (uint8_t)(Run->Transfer.Address << 1 | 1));
+        }
+    }
+
+  Program[Length++] = I2C_OP_STOP;
+  Program[Length] = I2C_OP_END;
+
+  Run->Rx = RxData;
+  Run->RxLength = RxLength;
+  Run->Received = 0;
+  Run->Block = RxLength == I2C_SMBUS_BLOCK_READ;
+
+  Run->Transfer.Program = Program;
+  Run->Transfer.TxData = Run->Tx;
+  Run->Transfer.RxData = 0x0;
+  Run->Transfer.Callback = 0x0;
+  Run->Transfer.Receive = I2cSmbus_Receive;
+
+  res = I2c_Transfer(I2c, &Run->Transfer);
+  if(res != 1 || RxData == 0x0) return res;
+
+  return Run->Crc == 0 ? 1 : 8;
+}
+
+/******************************************************************************
+* Function : I2cSmbus_Receive()
+*//**
+* \b Description: Utility function to take a received byte of a
+* transaction: the byte count of a block, a byte saved in the buffer of the
+* caller, or the PEC. Each one updates the Packet Error Code. <br>
+* @param Transfer the program, the first member of its transaction
+* @param Data the received byte
+* @return void
+ ******************************************************************************/
+static void
+I2cSmbus_Receive(const I2cTransfer_t* const Transfer, const uint8_t Data)
+{
+  I2cSmbusRun_t* const Run = (I2cSmbusRun_t*)Transfer;
+
+  if(Run->Pec != 0)
+    {
+      Run->Crc = I2cSmbus_Crc8(Run->Crc, Data);
+    }
+
+  if(Run->Block != 0)
+    {
+      Run->Block = 0;
+      Run->RxLength = Data;
+      return;
+    }
+
+  //the PEC, or the NACKed byte after an invalid byte count
+  if(!(Run->Received < Run->RxLength &&
+       Run->RxLength <= I2C_SMBUS_BLOCK_MAX))
+    {
+      return;
+    }
+
+  Run->Rx[Run->Received] = Data;
+  Run->Received++;
+}
+/*****************************End of File ************************************/
@@ -0,0 +1,58 @@
+/**
+ * @file i2c_smbus.h
+ * @author Mohamed Hassanin
+ * @brief SMBus protocol header file.
+ * @version 0.1
+ * @date 2021-05-15
+ */
+#ifndef I2C_SMBUS_H
+#define I2C_SMBUS_H
+/******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define I2C_SMBUS_BLOCK_MAX 32 /**< The maximum length of an SMBus block */
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "i2c.h"
+/******************************************************************************
+ * Function prototypes
+ ******************************************************************************/
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+extern uint8_t I2cSmbus_BlockWrite(const I2c_t I2c,
+                                   const uint8_t Address,
+                                   const uint8_t Command,
+                                   const uint8_t* const Data,
+                                   const uint8_t Length,
+                                   const uint8_t Pec);
+extern uint8_t I2cSmbus_BlockRead(const I2c_t I2c,
+                                  const uint8_t Address,
+                                  const uint8_t Command,
+                                  uint8_t* const Data,
+                                  uint8_t* const Length,
+                                  const uint8_t Pec);
+extern uint8_t I2cSmbus_ProcessCall(const I2c_t I2c,
+                                    const uint8_t Address,
+                                    const uint8_t Command,
+                                    const uint16_t Value,
+                                    uint16_t* const Result,
+                                    const uint8_t Pec);
+extern uint8_t I2cSmbus_BlockProcessCall(const I2c_t I2c,
+                                         const uint8_t Address,
+                                         const uint8_t Command,
+                                         const uint8_t* const TxData,
+                                         const uint8_t TxLength,
+                                         uint8_t* const RxData,
+                                         uint8_t* const RxLength,
+                                         const uint8_t Pec);
+extern uint8_t I2cSmbus_Crc8(const uint8_t Crc, const uint8_t Data);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
+/*****************************End of File ************************************/
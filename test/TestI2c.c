@@ -0,0 +1,432 @@
+#include "unity.h"
+#include "i2c.h"
+#include "i2c_cfg.h"
+#include "i2c_budget.h"
+#include "twi_sim.h"
+#include "twi_fault.h"
+#include "i2c_memmap.h"
+
+#define DEVICE 0x50 /* listed in the device table at 400 kHz */
+
+#define OTHER_DEVICE 0x51 /* not listed, at the speed of the bus */
+
+#define SLOW_DEVICE 0x52 /* listed in the device table at 50 kHz */
+
+#define CYCLES_PER_US (I2C_CPU_CLK / 1000000ul)
+
+/* the longest a step which isn't delayed takes to be seen done */
+#define STEP_CYCLES \
+(9 * (I2C_CPU_CLK / 400000ul) + I2C_STEP_CYCLES + I2C_POLL_CYCLES)
+
+/* the longest the bus idles between two bytes of the generic path and of the
+ * fast data path */
+#define GAP_CYCLES (I2C_STEP_CYCLES + I2C_POLL_CYCLES)
+#define FAST_GAP_CYCLES (I2C_FAST_STEP_CYCLES + I2C_FAST_POLL_CYCLES)
+
+/* the longest wait of the driver for a step */
+#define TIMEOUT_CYCLES ((uint32_t)I2C_TIMEOUT * I2C_POLL_CYCLES)
+
+static const uint8_t gSendBytes[] =
+{
+  I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_REG, I2C_OP_TX, 4, I2C_OP_STOP,
+  I2C_OP_END
+};
+
+static const uint8_t gData[4] = { 0xDE, 0xAD, 0xBE, 0xEF };
+
+static TwiSimDevice_t* gDevice;
+
+static uint8_t gStarts; /* the start bits seen by CountSteps */
+static uint8_t gStops; /* the stop bits seen by CountSteps */
+static uint8_t gBitrates[16]; /* TWBR at each step seen by CountSteps */
+static uint8_t gSteps;
+
+void setUp(void)
+{
+  TwiSim_Init();
+  gDevice = TwiSim_AddDevice(I2C_0, DEVICE);
+  I2c_Init(I2c_GetConfig());
+}
+
+void tearDown(void)
+{
+}
+
+static uint8_t Send(void)
+{
+  return I2c_SendBytes(I2C_0, DEVICE, 0x10, gData, 4);
+}
+
+static uint32_t GetWorstCycles(void)
+{
+  I2cTransfer_t Transfer = { gSendBytes, DEVICE, 0x10, gData, 0x0, 0x0, 0x0 };
+  I2cBudget_t Budget;
+
+  I2cBudget_Estimate(I2C_0, &Transfer, &Budget);
+
+  return Budget.WorstUs * CYCLES_PER_US;
+}
+
+static void Inject(const TwiFaultKind_t Kind,
+                   const TwiFaultPhase_t Phase,
+                   const uint8_t Skip,
+                   const uint8_t Status,
+                   const uint32_t Cycles)
+{
+  TwiFault_t Fault = { Kind, Phase, Skip, Status, Cycles };
+
+  TwiFault_Arm(I2C_0, &Fault);
+}
+
+static void CountSteps(const I2c_t I2c, TwiSimStep_t* const Step)
+{
+  if(gSteps < sizeof(gBitrates))
+    {
+      gBitrates[gSteps] = gTwiSim[I2c].Twbr;
+    }
+  gSteps++;
+
+  if(Step->Command & (1 << TWSTO))
+    {
+      gStops++;
+    }
+  else if(Step->Command & (1 << TWSTA))
+    {
+      gStarts++;
+    }
+}
+
+static void StartCounting(void)
+{
+  gStarts = 0;
+  gStops = 0;
+  gSteps = 0;
+  TwiSim_SetHook(CountSteps);
+}
+
+/* the driver is usable again after the fault */
+static void CheckRecovered(void)
+{
+  gDevice->Memory[0x13] = 0;
+
+  TEST_ASSERT_EQUAL_UINT8(1, Send());
+  TEST_ASSERT_EQUAL_HEX8(0xEF, gDevice->Memory[0x13]);
+}
+
+void test_AddressNackIsReportedAfterItsStep(void)
+{
+  Inject(TWI_FAULT_NACK, TWI_FAULT_ADDRESS, 0, 0, 0);
+
+  TEST_ASSERT_EQUAL_UINT8(3, Send());
+  TEST_ASSERT_TRUE(TwiFault_IsInjected());
+  TEST_ASSERT_TRUE(TwiFault_GetLatency() <= STEP_CYCLES + I2C_STEP_CYCLES);
+
+  CheckRecovered();
+}
+
+void test_DataNackIsReportedAfterItsStep(void)
+{
+  //the register is the first data byte
+  Inject(TWI_FAULT_NACK, TWI_FAULT_DATA, 2, 0, 0);
+
+  TEST_ASSERT_EQUAL_UINT8(4, Send());
+  TEST_ASSERT_TRUE(TwiFault_GetLatency() <= STEP_CYCLES + I2C_STEP_CYCLES);
+
+  CheckRecovered();
+}
+
+void test_ReadAddressNackIsReported(void)
+{
+  uint8_t Data;
+
+  Inject(TWI_FAULT_NACK, TWI_FAULT_ADDRESS, 1, 0, 0);
+
+  TEST_ASSERT_EQUAL_UINT8(3, I2c_ReceiveByte(I2C_0, DEVICE, 0x10, &Data));
+  TEST_ASSERT_TRUE(TwiFault_GetLatency() <= STEP_CYCLES + I2C_STEP_CYCLES);
+
+  CheckRecovered();
+}
+
+void test_DelayedFlagWithinTheTimeoutIsWaitedFor(void)
+{
+  const uint32_t Delay = TIMEOUT_CYCLES / 2;
+
+  Inject(TWI_FAULT_DELAY, TWI_FAULT_DATA, 1, 0, Delay);
+
+  TEST_ASSERT_EQUAL_UINT8(1, Send());
+  TEST_ASSERT_TRUE(TwiFault_GetLatency() >= Delay);
+  TEST_ASSERT_TRUE(TwiFault_GetLatency() <= Delay + 5 * STEP_CYCLES);
+  TEST_ASSERT_EQUAL_HEX8(0xEF, gDevice->Memory[0x13]);
+}
+
+void test_DelayedFlagBeyondTheTimeoutIsReportedWithinTheBudget(void)
+{
+  Inject(TWI_FAULT_DELAY, TWI_FAULT_DATA, 1, 0, 2 * TIMEOUT_CYCLES);
+
+  TEST_ASSERT_EQUAL_UINT8(4, Send());
+  TEST_ASSERT_TRUE(TwiFault_GetLatency() >= TIMEOUT_CYCLES);
+  TEST_ASSERT_TRUE(TwiFault_GetLatency() <= TIMEOUT_CYCLES + 2 * STEP_CYCLES);
+  TEST_ASSERT_TRUE(TwiSim_GetClock() <= GetWorstCycles());
+
+  CheckRecovered();
+}
+
+void test_ArbitrationLossIsReportedAsAStartError(void)
+{
+  Inject(TWI_FAULT_STATUS, TWI_FAULT_START, 0, 0x38, 0);
+
+  TEST_ASSERT_EQUAL_UINT8(2, Send());
+  TEST_ASSERT_TRUE(TwiFault_GetLatency() <= STEP_CYCLES + I2C_STEP_CYCLES);
+
+  CheckRecovered();
+}
+
+void test_BusErrorDuringDataIsReported(void)
+{
+  Inject(TWI_FAULT_STATUS, TWI_FAULT_DATA, 2, 0x00, 0);
+
+  TEST_ASSERT_EQUAL_UINT8(4, Send());
+
+  CheckRecovered();
+}
+
+void test_BusHeldLowIsRecoveredByRetrying(void)
+{
+  const uint32_t Hold = 2 * TIMEOUT_CYCLES;
+  uint8_t Attempts = 0;
+  uint8_t res;
+
+  Inject(TWI_FAULT_BUS_LOW, TWI_FAULT_START, 0, 0, Hold);
+
+  do
+    {
+      res = Send();
+      Attempts++;
+      if(Attempts == 1)
+        {
+          //the first failure is reported within the budget of the call
+          TEST_ASSERT_EQUAL_UINT8(2, res);
+          TEST_ASSERT_TRUE(TwiSim_GetClock() <= GetWorstCycles());
+        }
+    }
+  while(res != 1 && Attempts < 5);
+
+  TEST_ASSERT_EQUAL_UINT8(1, res);
+  TEST_ASSERT_EQUAL_UINT8(3, Attempts);
+
+  //the retry after the release waits for at most one timeout
+  TEST_ASSERT_TRUE(TwiFault_GetLatency() >= Hold);
+  TEST_ASSERT_TRUE(TwiFault_GetLatency() <=
+                   Hold + TIMEOUT_CYCLES + 8 * STEP_CYCLES);
+  TEST_ASSERT_EQUAL_HEX8(0xEF, gDevice->Memory[0x13]);
+}
+
+void test_AsyncTransferOnABusHeldLowTimesOutInI2cPoll(void)
+{
+  I2cTransfer_t Transfer = { gSendBytes, DEVICE, 0x10, gData, 0x0, 0x0, 0x0 };
+  uint16_t Polls = 0;
+
+  Inject(TWI_FAULT_BUS_LOW, TWI_FAULT_START, 0, 0, TWI_SIM_NEVER);
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_TransferAsync(I2C_0, &Transfer));
+  while(I2c_GetResult(I2C_0) == I2C_PENDING)
+    {
+      I2c_Poll();
+      Polls++;
+    }
+
+  TEST_ASSERT_EQUAL_UINT8(2, I2c_GetResult(I2C_0));
+  TEST_ASSERT_EQUAL_UINT16(I2C_TIMEOUT, Polls);
+}
+
+void test_WriteDataPhaseKeepsTheBusBusy(void)
+{
+  uint8_t Data[32];
+  TwiSimGaps_t Gaps;
+  uint8_t i;
+
+  for(i = 0; i < 32; i++)
+    {
+      Data[i] = i;
+    }
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_SendBytes(I2C_0, DEVICE, 0x40, Data, 32));
+  TEST_ASSERT_EQUAL_HEX8(31, gDevice->Memory[0x5F]);
+  TwiSim_GetGaps(I2C_0, &Gaps);
+
+  //address -> register -> first byte, then 31 bytes in the fast path
+  TEST_ASSERT_EQUAL_UINT32(33, Gaps.Count);
+  TEST_ASSERT_TRUE(Gaps.Cycles <= 2 * GAP_CYCLES + 31 * FAST_GAP_CYCLES);
+}
+
+void test_ReadDataPhaseKeepsTheBusBusy(void)
+{
+  uint8_t Data[32];
+  TwiSimGaps_t Gaps;
+  uint8_t i;
+
+  for(i = 0; i < 32; i++)
+    {
+      gDevice->Memory[0x40 + i] = 0xA0 + i;
+    }
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_ReceiveBytes(I2C_0, DEVICE, 0x40, Data, 32));
+  TEST_ASSERT_EQUAL_HEX8(0xA0, Data[0]);
+  TEST_ASSERT_EQUAL_HEX8(0xBF, Data[31]);
+  TwiSim_GetGaps(I2C_0, &Gaps);
+
+  //address -> register, address -> first byte, 30 bytes in the fast path,
+  //then the NACKed byte
+  TEST_ASSERT_EQUAL_UINT32(33, Gaps.Count);
+  TEST_ASSERT_TRUE(Gaps.Cycles <= 3 * GAP_CYCLES + 30 * FAST_GAP_CYCLES);
+}
+
+void test_NackInTheFastPathIsReported(void)
+{
+  //the register and 2 bytes are acknowledged
+  Inject(TWI_FAULT_NACK, TWI_FAULT_DATA, 3, 0, 0);
+
+  TEST_ASSERT_EQUAL_UINT8(4, Send());
+  TEST_ASSERT_TRUE(TwiFault_GetLatency() <= STEP_CYCLES + I2C_STEP_CYCLES);
+
+  CheckRecovered();
+}
+
+void test_UpdateBitsWritesAChangedValueInOneTransaction(void)
+{
+  gDevice->Memory[0x20] = 0xA5;
+  StartCounting();
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_UpdateBits(I2C_0, DEVICE, 0x20, 0x0F, 0x03));
+  TEST_ASSERT_EQUAL_HEX8(0xA3, gDevice->Memory[0x20]);
+
+  //start, repeated start for the read, repeated start for the write, and
+  //a single stop at the end
+  TEST_ASSERT_EQUAL_UINT8(3, gStarts);
+  TEST_ASSERT_EQUAL_UINT8(1, gStops);
+}
+
+void test_UpdateBitsOnlyReadsAnUnchangedValue(void)
+{
+  gDevice->Memory[0x20] = 0xA3;
+  StartCounting();
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_UpdateBits(I2C_0, DEVICE, 0x20, 0x0F, 0x03));
+  TEST_ASSERT_EQUAL_HEX8(0xA3, gDevice->Memory[0x20]);
+
+  //the read then the stop, no write
+  TEST_ASSERT_EQUAL_UINT8(2, gStarts);
+  TEST_ASSERT_EQUAL_UINT8(1, gStops);
+  TEST_ASSERT_EQUAL_HEX8(0x21, gDevice->Pointer);
+}
+
+void test_UpdateBitsNackInTheReadPhaseSkipsTheWrite(void)
+{
+  gDevice->Memory[0x20] = 0xA5;
+  //the read address is NACKed
+  Inject(TWI_FAULT_NACK, TWI_FAULT_ADDRESS, 1, 0, 0);
+
+  TEST_ASSERT_EQUAL_UINT8(3, I2c_UpdateBits(I2C_0, DEVICE, 0x20, 0x0F, 0x03));
+  TEST_ASSERT_EQUAL_HEX8(0xA5, gDevice->Memory[0x20]);
+
+  CheckRecovered();
+}
+
+void test_UpdateBitsKeepsTheSpeedOfAnOwnedBus(void)
+{
+  uint8_t Bitrate;
+
+  TwiSim_AddDevice(I2C_0, OTHER_DEVICE);
+  gDevice->Memory[0x20] = 0xA5;
+
+  //the bus is owned at the speed of the bus, like I2c_Transfer the update
+  //mustn't switch to the speed of the device
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_Start(I2C_0, OTHER_DEVICE, 0));
+  Bitrate = gTwiSim[I2C_0].Twbr;
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_UpdateBits(I2C_0, DEVICE, 0x20, 0x0F, 0x03));
+  TEST_ASSERT_EQUAL_HEX8(Bitrate, gTwiSim[I2C_0].Twbr);
+  TEST_ASSERT_EQUAL_HEX8(0xA3, gDevice->Memory[0x20]);
+}
+
+void test_GroupUpdatePreloadsTheDevicesThenLatchesThem(void)
+{
+  const uint8_t Addresses[2] = { DEVICE, OTHER_DEVICE };
+  const uint8_t Data[2] = { 0x11, 0x22 };
+  TwiSimDevice_t* Other = TwiSim_AddDevice(I2C_0, OTHER_DEVICE);
+  uint8_t i;
+
+  StartCounting();
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_GroupUpdate(I2C_0, Addresses, 0x30, Data, 2,
+                                             0x06));
+  TEST_ASSERT_EQUAL_HEX8(0x11, gDevice->Memory[0x30]);
+  TEST_ASSERT_EQUAL_HEX8(0x22, Other->Memory[0x30]);
+  TEST_ASSERT_EQUAL_HEX8(0x06, gDevice->GeneralCall);
+  TEST_ASSERT_EQUAL_HEX8(0x06, Other->GeneralCall);
+
+  //two preloads and the latch chained by repeated starts
+  TEST_ASSERT_EQUAL_UINT8(3, gStarts);
+  TEST_ASSERT_EQUAL_UINT8(1, gStops);
+
+  //the 400 kHz device runs at the speed of the bus with the others
+  for(i = 0; i < gSteps; i++)
+    {
+      TEST_ASSERT_EQUAL_HEX8(gBitrates[0], gBitrates[i]);
+    }
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_SendByte(I2C_0, OTHER_DEVICE, 0x30, 0x22));
+  TEST_ASSERT_EQUAL_HEX8(gBitrates[0], gTwiSim[I2C_0].Twbr);
+}
+
+void test_GroupUpdateRunsAtTheLowestSpeedOfTheDevices(void)
+{
+  const uint8_t Addresses[2] = { DEVICE, SLOW_DEVICE };
+  const uint8_t Data[2] = { 0x11, 0x22 };
+  uint8_t SlowBitrate;
+  uint8_t i;
+
+  TwiSim_AddDevice(I2C_0, SLOW_DEVICE);
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_SendByte(I2C_0, SLOW_DEVICE, 0x30, 0x00));
+  SlowBitrate = gTwiSim[I2C_0].Twbr;
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_SendByte(I2C_0, DEVICE, 0x30, 0x00));
+  StartCounting();
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_GroupUpdate(I2C_0, Addresses, 0x30, Data, 2,
+                                             0x06));
+
+  //the 50 kHz device is slower than the bus and the 400 kHz device
+  //start, address, register and byte of each preload, then the latch
+  TEST_ASSERT_EQUAL_UINT8(4 + 4 + 4, gSteps);
+  for(i = 0; i < gSteps; i++)
+    {
+      TEST_ASSERT_EQUAL_HEX8(SlowBitrate, gBitrates[i]);
+    }
+}
+
+void test_GroupUpdateDecodesTheAckOfTheGeneralCall(void)
+{
+  //no device acknowledges the general call address
+  Inject(TWI_FAULT_NACK, TWI_FAULT_ADDRESS, 0, 0, 0);
+  TEST_ASSERT_EQUAL_UINT8(3, I2c_GroupUpdate(I2C_0, 0x0, 0x30, 0x0, 0, 0x06));
+  TEST_ASSERT_EQUAL_HEX8(0x00, gDevice->GeneralCall);
+
+  //a device may NACK the command of a general call
+  Inject(TWI_FAULT_NACK, TWI_FAULT_DATA, 0, 0, 0);
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_GroupUpdate(I2C_0, 0x0, 0x30, 0x0, 0, 0x06));
+
+  CheckRecovered();
+}
+
+void test_GroupUpdateWithoutDevicesOnlySendsTheCommand(void)
+{
+  gDevice->Memory[0x30] = 0x5A;
+  StartCounting();
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_GroupUpdate(I2C_0, 0x0, 0x30, 0x0, 0, 0x04));
+  TEST_ASSERT_EQUAL_HEX8(0x04, gDevice->GeneralCall);
+  TEST_ASSERT_EQUAL_HEX8(0x5A, gDevice->Memory[0x30]);
+
+  //start, the general call address, the command and the stop
+  TEST_ASSERT_EQUAL_UINT8(4, gSteps);
+  TEST_ASSERT_EQUAL_UINT8(1, gStarts);
+  TEST_ASSERT_EQUAL_UINT8(1, gStops);
+}
@@ -0,0 +1,261 @@
+#include "unity.h"
+#include "i2c.h"
+#include "i2c_cfg.h"
+#include "i2c_arb.h"
+#include "i2c_queue.h"
+#include "twi_sim.h"
+
+#define DEVICE 0x50
+
+/* longer than I2C_ARB_CHUNKS_PER_UPDATE chunks */
+#define LONG_LENGTH 100
+
+static const uint8_t gReadByte[] =
+{
+  I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_REG, I2C_OP_START, I2C_OP_ADDR_R,
+  I2C_OP_RX_NACK, I2C_OP_STOP, I2C_OP_END
+};
+
+static TwiSimDevice_t* gDevice;
+static I2cRequest_t* gOrder[4];
+static uint8_t gCompleted;
+static uint16_t gLongDone; /* the bytes of the long write when the urgent
+                              read completed */
+static I2cRequest_t gLong;
+static uint8_t gLongData[LONG_LENGTH];
+
+void setUp(void)
+{
+  uint8_t i;
+
+  TwiSim_Init();
+  gDevice = TwiSim_AddDevice(I2C_0, DEVICE);
+  I2c_Init(I2c_GetConfig());
+  I2cQueue_Init();
+  I2cArb_Init();
+  gCompleted = 0;
+  gLongDone = 0;
+
+  for(i = 0; i < LONG_LENGTH; i++)
+    {
+      gLongData[i] = i + 1;
+    }
+}
+
+void tearDown(void)
+{
+}
+
+static void Record(I2cRequest_t* const Request)
+{
+  gOrder[gCompleted] = Request;
+  gCompleted++;
+}
+
+static void RecordLongProgress(I2cRequest_t* const Request)
+{
+  gLongDone = gLong.Done;
+  Record(Request);
+}
+
+static void SetRequest(I2cRequest_t* const Request, const uint8_t Register,
+                       uint8_t* const Data, const uint16_t Length,
+                       const I2cArbDir_t Dir, const uint8_t Priority,
+                       const uint16_t Deadline)
+{
+  Request->I2c = I2C_0;
+  Request->Address = DEVICE;
+  Request->Register = Register;
+  Request->Data = Data;
+  Request->Length = Length;
+  Request->Dir = Dir;
+  Request->Priority = Priority;
+  Request->Deadline = Deadline;
+  Request->Callback = Record;
+}
+
+void test_HigherPriorityRunsFirst(void)
+{
+  I2cRequest_t Low;
+  I2cRequest_t High;
+  uint8_t LowData = 0x11;
+  uint8_t HighData = 0x22;
+
+  SetRequest(&Low, 0x10, &LowData, 1, I2C_ARB_WRITE, 3, 10);
+  SetRequest(&High, 0x20, &HighData, 1, I2C_ARB_WRITE, 0, 100);
+  TEST_ASSERT_EQUAL_UINT8(1, I2cArb_Submit(&Low));
+  TEST_ASSERT_EQUAL_UINT8(1, I2cArb_Submit(&High));
+
+  I2cArb_Update();
+
+  TEST_ASSERT_EQUAL_UINT8(2, gCompleted);
+  TEST_ASSERT_EQUAL_PTR(&High, gOrder[0]);
+  TEST_ASSERT_EQUAL_PTR(&Low, gOrder[1]);
+  TEST_ASSERT_EQUAL_UINT8(1, Low.Status);
+  TEST_ASSERT_EQUAL_UINT8(1, High.Status);
+  TEST_ASSERT_EQUAL_HEX8(0x11, gDevice->Memory[0x10]);
+  TEST_ASSERT_EQUAL_HEX8(0x22, gDevice->Memory[0x20]);
+}
+
+void test_EarlierDeadlineRunsFirstAcrossTheTickWrap(void)
+{
+  I2cRequest_t Late;
+  I2cRequest_t Early;
+  uint8_t LateData = 0x33;
+  uint8_t EarlyData = 0x44;
+  uint16_t i;
+
+  //the time base reaches 0xFFF0, an empty update only counts a tick
+  for(i = 0; i < 0xFFF0; i++)
+    {
+      I2cArb_Update();
+    }
+
+  //the late request is due at 0x0010 past the wrap, the early one at 0xFFF8
+  SetRequest(&Late, 0x10, &LateData, 1, I2C_ARB_WRITE, 1, 0x20);
+  SetRequest(&Early, 0x20, &EarlyData, 1, I2C_ARB_WRITE, 1, 0x08);
+  TEST_ASSERT_EQUAL_UINT8(1, I2cArb_Submit(&Late));
+  TEST_ASSERT_EQUAL_UINT8(1, I2cArb_Submit(&Early));
+  TEST_ASSERT_TRUE(Late.Due < Early.Due);
+
+  I2cArb_Update();
+
+  TEST_ASSERT_EQUAL_UINT8(2, gCompleted);
+  TEST_ASSERT_EQUAL_PTR(&Early, gOrder[0]);
+  TEST_ASSERT_EQUAL_PTR(&Late, gOrder[1]);
+}
+
+void test_UrgentReadRunsBetweenTheChunksOfALongWrite(void)
+{
+  I2cRequest_t Urgent;
+  uint8_t Data = 0;
+  uint16_t i;
+
+  gDevice->Memory[0xF0] = 0x5A;
+  SetRequest(&gLong, 0x00, gLongData, LONG_LENGTH, I2C_ARB_WRITE, 2, 100);
+  SetRequest(&Urgent, 0xF0, &Data, 1, I2C_ARB_READ, 0, 1);
+  Urgent.Callback = RecordLongProgress;
+  TEST_ASSERT_EQUAL_UINT8(1, I2cArb_Submit(&gLong));
+
+  I2cArb_Update();
+  TEST_ASSERT_EQUAL_UINT16(I2C_ARB_CHUNKS_PER_UPDATE * I2C_ARB_CHUNK,
+                           gLong.Done);
+  TEST_ASSERT_EQUAL_UINT8(I2C_ARB_PENDING, gLong.Status);
+
+  //the read is submitted while the write is half done, it gets the bus at
+  //the next STOP boundary
+  TEST_ASSERT_EQUAL_UINT8(1, I2cArb_Submit(&Urgent));
+  I2cArb_Update();
+
+  TEST_ASSERT_EQUAL_UINT8(2, gCompleted);
+  TEST_ASSERT_EQUAL_PTR(&Urgent, gOrder[0]);
+  TEST_ASSERT_EQUAL_UINT16(I2C_ARB_CHUNKS_PER_UPDATE * I2C_ARB_CHUNK,
+                           gLongDone);
+  TEST_ASSERT_EQUAL_HEX8(0x5A, Data);
+  TEST_ASSERT_EQUAL_PTR(&gLong, gOrder[1]);
+  TEST_ASSERT_EQUAL_UINT8(1, gLong.Status);
+  TEST_ASSERT_EQUAL_UINT16(LONG_LENGTH, gLong.Done);
+
+  for(i = 0; i < LONG_LENGTH; i++)
+    {
+      TEST_ASSERT_EQUAL_HEX8(gLongData[i], gDevice->Memory[i]);
+    }
+}
+
+void test_BusyPeripheralRetriesTheChunkAtTheNextUpdate(void)
+{
+  I2cTransfer_t Transfer = { 0 };
+  uint8_t Data = 0;
+
+  SetRequest(&gLong, 0x00, gLongData, LONG_LENGTH, I2C_ARB_WRITE, 2, 100);
+  TEST_ASSERT_EQUAL_UINT8(1, I2cArb_Submit(&gLong));
+  I2cArb_Update();
+  TEST_ASSERT_EQUAL_UINT16(I2C_ARB_CHUNKS_PER_UPDATE * I2C_ARB_CHUNK,
+                           gLong.Done);
+
+  //a data-ready read takes the bus before the next update
+  Transfer.Program = gReadByte;
+  Transfer.Address = DEVICE;
+  Transfer.Register = 0xF0;
+  Transfer.RxData = &Data;
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_TransferAsync(I2C_0, &Transfer));
+
+  //the chunk isn't started, the request isn't failed
+  I2cArb_Update();
+  TEST_ASSERT_EQUAL_UINT8(0, gCompleted);
+  TEST_ASSERT_EQUAL_UINT8(I2C_ARB_PENDING, gLong.Status);
+  TEST_ASSERT_EQUAL_UINT16(I2C_ARB_CHUNKS_PER_UPDATE * I2C_ARB_CHUNK,
+                           gLong.Done);
+
+  while(I2c_GetResult(I2C_0) == I2C_PENDING)
+    {
+      I2c_Poll();
+    }
+
+  I2cArb_Update();
+  TEST_ASSERT_EQUAL_UINT8(1, gCompleted);
+  TEST_ASSERT_EQUAL_UINT8(1, gLong.Status);
+  TEST_ASSERT_EQUAL_UINT16(LONG_LENGTH, gLong.Done);
+  TEST_ASSERT_EQUAL_HEX8(gLongData[LONG_LENGTH - 1],
+                         gDevice->Memory[LONG_LENGTH - 1]);
+}
+
+void test_OtherBusRunsWhileOnePeripheralIsBusy(void)
+{
+  TwiSimDevice_t* const Other = TwiSim_AddDevice(I2C_1, DEVICE);
+  I2cTransfer_t Transfer = { 0 };
+  I2cRequest_t Request;
+  uint8_t OtherData = 0x66;
+  uint8_t Data = 0;
+
+  //the urgent request waits for I2C_0, the later one has its own bus
+  SetRequest(&gLong, 0x00, gLongData, LONG_LENGTH, I2C_ARB_WRITE, 0, 1);
+  SetRequest(&Request, 0x40, &OtherData, 1, I2C_ARB_WRITE, 3, 100);
+  Request.I2c = I2C_1;
+  TEST_ASSERT_EQUAL_UINT8(1, I2cArb_Submit(&gLong));
+  TEST_ASSERT_EQUAL_UINT8(1, I2cArb_Submit(&Request));
+
+  Transfer.Program = gReadByte;
+  Transfer.Address = DEVICE;
+  Transfer.Register = 0xF0;
+  Transfer.RxData = &Data;
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_TransferAsync(I2C_0, &Transfer));
+
+  I2cArb_Update();
+  TEST_ASSERT_EQUAL_UINT8(1, gCompleted);
+  TEST_ASSERT_EQUAL_PTR(&Request, gOrder[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x66, Other->Memory[0x40]);
+  TEST_ASSERT_EQUAL_UINT16(0, gLong.Done);
+  TEST_ASSERT_EQUAL_UINT8(I2C_ARB_PENDING, gLong.Status);
+
+  while(I2c_GetResult(I2C_0) == I2C_PENDING)
+    {
+      I2c_Poll();
+    }
+
+  I2cArb_Update();
+  TEST_ASSERT_EQUAL_UINT16(I2C_ARB_CHUNKS_PER_UPDATE * I2C_ARB_CHUNK,
+                           gLong.Done);
+}
+
+void test_RequestPastTheLastRegisterIsRejected(void)
+{
+  I2cRequest_t Request;
+  uint16_t i;
+
+  //0xF0 + 17 would wrap to the register 0x00
+  SetRequest(&Request, 0xF0, gLongData, 17, I2C_ARB_WRITE, 1, 10);
+  TEST_ASSERT_EQUAL_UINT8(0, I2cArb_Submit(&Request));
+
+  //up to the register 0xFF
+  Request.Length = 16;
+  TEST_ASSERT_EQUAL_UINT8(1, I2cArb_Submit(&Request));
+  I2cArb_Update();
+
+  TEST_ASSERT_EQUAL_UINT8(1, Request.Status);
+  for(i = 0; i < 16; i++)
+    {
+      TEST_ASSERT_EQUAL_HEX8(gLongData[i], gDevice->Memory[0xF0 + i]);
+    }
+  TEST_ASSERT_EQUAL_HEX8(0, gDevice->Memory[0x00]);
+}
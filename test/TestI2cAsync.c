@@ -0,0 +1,173 @@
+#include "unity.h"
+#include "i2c.h"
+#include "i2c_cfg.h"
+#include "i2c_memmap.h"
+#include "twi_sim.h"
+
+#if I2C_ASYNC_IRQ != 1
+#error "TestI2cAsync must be built with I2C_ASYNC_IRQ set to 1"
+#endif
+
+#define DEVICE 0x50
+
+static const uint8_t gStartStop[] =
+{
+  I2C_OP_START, I2C_OP_STOP, I2C_OP_END
+};
+
+static const uint8_t gStopOnly[] =
+{
+  I2C_OP_STOP, I2C_OP_END
+};
+
+static const uint8_t gSendBytes[] =
+{
+  I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_REG, I2C_OP_TX, 4, I2C_OP_STOP,
+  I2C_OP_END
+};
+
+static const uint8_t gBytes0[] = { 0x11, 0x22, 0x33, 0x44 };
+static const uint8_t gBytes1[] = { 0xAA, 0xBB, 0xCC, 0xDD };
+
+static uint8_t gEnded[I2C_MAX]; /* the callbacks of each bus */
+static uint8_t gStatus[I2C_MAX]; /* the status of the last one */
+
+void setUp(void)
+{
+  uint8_t i;
+
+  TwiSim_Init();
+  I2c_Init(I2c_GetConfig());
+
+  for(i = 0; i < I2C_MAX; i++)
+    {
+      gEnded[i] = 0;
+      gStatus[i] = 0;
+    }
+}
+
+void tearDown(void)
+{
+}
+
+static void Ended(const I2c_t I2c, const I2cTransfer_t* const Transfer,
+                  const uint8_t Status)
+{
+  (void)Transfer;
+
+  gEnded[I2c]++;
+  gStatus[I2c] = Status;
+}
+
+/* the I2C interrupt of a bus, if its flag is set */
+static void Interrupt(const I2c_t I2c)
+{
+  TwiSim_Poll(I2c);
+  if(gTwiSim[I2c].Twcr & (1 << TWINT))
+    {
+      I2c_IrqHandler(I2c);
+    }
+}
+
+/* the interrupts of the start bit, which end the program as soon as the
+ * critical section of I2c_TransferAsync is left */
+static void FinishProgram(void)
+{
+  //the critical section of the lock, the program isn't loaded yet
+  if((gTwiSim[I2C_0].Twcr & (1 << TWSTA)) == 0)
+    {
+      TwiSim_SetInterrupt(FinishProgram);
+      return;
+    }
+
+  while(I2c_GetResult(I2C_0) == I2C_PENDING)
+    {
+      Interrupt(I2C_0);
+    }
+}
+
+static void SetTransfer(I2cTransfer_t* const Transfer,
+                        const uint8_t* const Program,
+                        const uint8_t* const TxData)
+{
+  Transfer->Program = Program;
+  Transfer->Address = DEVICE;
+  Transfer->Register = 0x10;
+  Transfer->TxData = TxData;
+  Transfer->RxData = 0x0;
+  Transfer->Callback = Ended;
+  Transfer->Receive = 0x0;
+}
+
+void test_ProgramEndedByTheInterruptEndsOnce(void)
+{
+  I2cTransfer_t Transfer;
+
+  SetTransfer(&Transfer, gStartStop, 0x0);
+  TwiSim_SetInterrupt(FinishProgram);
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_TransferAsync(I2C_0, &Transfer));
+
+  TEST_ASSERT_EQUAL_UINT8(1, gEnded[I2C_0]);
+  TEST_ASSERT_EQUAL_UINT8(1, gStatus[I2C_0]);
+
+  //the bus is free for the next program
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_TransferAsync(I2C_0, &Transfer));
+  while(I2c_GetResult(I2C_0) == I2C_PENDING)
+    {
+      Interrupt(I2C_0);
+    }
+  TEST_ASSERT_EQUAL_UINT8(2, gEnded[I2C_0]);
+}
+
+void test_ProgramEndedByTheLoadEndsOnce(void)
+{
+  I2cTransfer_t Transfer;
+
+  SetTransfer(&Transfer, gStopOnly, 0x0);
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_TransferAsync(I2C_0, &Transfer));
+  TEST_ASSERT_EQUAL_UINT8(1, gEnded[I2C_0]);
+  TEST_ASSERT_EQUAL_UINT8(1, gStatus[I2C_0]);
+
+  //a late interrupt doesn't step the ended program
+  gTwiSim[I2C_0].Twcr |= 1 << TWINT;
+  I2c_IrqHandler(I2C_0);
+  TEST_ASSERT_EQUAL_UINT8(1, gEnded[I2C_0]);
+}
+
+void test_ProgramsOfTwoBusesRunTogether(void)
+{
+  TwiSimDevice_t* const Device0 = TwiSim_AddDevice(I2C_0, DEVICE);
+  TwiSimDevice_t* const Device1 = TwiSim_AddDevice(I2C_1, DEVICE);
+  I2cTransfer_t Transfer0;
+  I2cTransfer_t Transfer1;
+
+  SetTransfer(&Transfer0, gSendBytes, gBytes0);
+  SetTransfer(&Transfer1, gSendBytes, gBytes1);
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_TransferAsync(I2C_0, &Transfer0));
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_TransferAsync(I2C_1, &Transfer1));
+
+  while(I2c_GetResult(I2C_0) == I2C_PENDING ||
+        I2c_GetResult(I2C_1) == I2C_PENDING)
+    {
+      Interrupt(I2C_0);
+      Interrupt(I2C_1);
+    }
+
+  TEST_ASSERT_EQUAL_UINT8(1, gEnded[I2C_0]);
+  TEST_ASSERT_EQUAL_UINT8(1, gEnded[I2C_1]);
+  TEST_ASSERT_EQUAL_UINT8(1, gStatus[I2C_0]);
+  TEST_ASSERT_EQUAL_UINT8(1, gStatus[I2C_1]);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(gBytes0, &Device0->Memory[0x10], 4);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(gBytes1, &Device1->Memory[0x10], 4);
+
+  //each device only got the bytes of its own bus
+  TEST_ASSERT_EQUAL_UINT8(0x10 + 4, Device0->Pointer);
+  TEST_ASSERT_EQUAL_UINT8(0x10 + 4, Device1->Pointer);
+
+  //the steps of the two buses overlapped
+  TEST_ASSERT_TRUE(TwiSim_GetClock() <
+                   TwiSim_GetBusCycles(I2C_0) + TwiSim_GetBusCycles(I2C_1));
+}
@@ -0,0 +1,138 @@
+#include "unity.h"
+#include "i2c.h"
+#include "i2c_cfg.h"
+#include "i2c_budget.h"
+#include "twi_sim.h"
+
+#define FAST_DEVICE 0x50 /* listed in the device table at 400 kHz */
+#define SLOW_DEVICE 0x20 /* runs at the 100 kHz of the peripheral */
+
+#define CYCLES_PER_US (I2C_CPU_CLK / 1000000ul)
+
+static const uint8_t gSendBytes[] =
+{
+  I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_REG, I2C_OP_TX, 8, I2C_OP_STOP,
+  I2C_OP_END
+};
+
+static const uint8_t gReceiveBytes[] =
+{
+  I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_REG, I2C_OP_START, I2C_OP_ADDR_R,
+  I2C_OP_RX_ACK, 7, I2C_OP_RX_NACK, I2C_OP_STOP, I2C_OP_END
+};
+
+static uint8_t gData[8];
+
+void setUp(void)
+{
+  TwiSim_Init();
+  TwiSim_AddDevice(I2C_0, FAST_DEVICE);
+  TwiSim_AddDevice(I2C_0, SLOW_DEVICE);
+  I2c_Init(I2c_GetConfig());
+}
+
+void tearDown(void)
+{
+}
+
+static void CheckEstimate(const I2cTransfer_t* const Transfer,
+                          const uint32_t Clock,
+                          const uint32_t BusCycles)
+{
+  I2cBudget_t Budget;
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2cBudget_Estimate(I2C_0, Transfer, &Budget));
+
+  //the estimate bounds the simulated bus
+  TEST_ASSERT_TRUE(BusCycles <= Budget.BusUs * CYCLES_PER_US);
+  TEST_ASSERT_TRUE(Clock <= Budget.DoneUs * CYCLES_PER_US);
+  TEST_ASSERT_TRUE(Budget.DoneUs <= Budget.WorstUs);
+
+  //and it's tight: only the rounding and one poll per step are lost
+  TEST_ASSERT_UINT32_WITHIN(CYCLES_PER_US, BusCycles,
+                            Budget.BusUs * CYCLES_PER_US);
+  TEST_ASSERT_UINT32_WITHIN(12 * (I2C_POLL_CYCLES + I2C_STEP_CYCLES), Clock,
+                            Budget.DoneUs * CYCLES_PER_US);
+}
+
+void test_SendBytesFitsTheEstimate(void)
+{
+  I2cTransfer_t Transfer = { gSendBytes, FAST_DEVICE, 0x10, gData, 0x0, 0x0,
+                             0x0 };
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_SendBytes(I2C_0, FAST_DEVICE, 0x10, gData, 8));
+
+  CheckEstimate(&Transfer, TwiSim_GetClock(), TwiSim_GetBusCycles(I2C_0));
+}
+
+void test_ReceiveBytesFitsTheEstimateAtThePeripheralSpeed(void)
+{
+  I2cTransfer_t Transfer =
+    { gReceiveBytes, SLOW_DEVICE, 0x10, 0x0, gData, 0x0, 0x0 };
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_ReceiveBytes(I2C_0, SLOW_DEVICE, 0x10, gData, 8));
+
+  CheckEstimate(&Transfer, TwiSim_GetClock(), TwiSim_GetBusCycles(I2C_0));
+}
+
+void test_SlowDeviceTakesFourTimesTheBusTime(void)
+{
+  I2cTransfer_t Fast = { gSendBytes, FAST_DEVICE, 0, gData, 0x0, 0x0, 0x0 };
+  I2cTransfer_t Slow = { gSendBytes, SLOW_DEVICE, 0, gData, 0x0, 0x0, 0x0 };
+  I2cBudget_t FastBudget;
+  I2cBudget_t SlowBudget;
+
+  I2cBudget_Estimate(I2C_0, &Fast, &FastBudget);
+  I2cBudget_Estimate(I2C_0, &Slow, &SlowBudget);
+
+  TEST_ASSERT_UINT32_WITHIN(4, 4 * FastBudget.BusUs, SlowBudget.BusUs);
+}
+
+void test_FailedTransferFitsTheWorstCase(void)
+{
+  I2cTransfer_t Transfer = { gSendBytes, 0x31, 0x10, gData, 0x0, 0x0, 0x0 };
+  I2cBudget_t Budget;
+
+  TEST_ASSERT_EQUAL_UINT8(3, I2c_SendBytes(I2C_0, 0x31, 0x10, gData, 8));
+
+  I2cBudget_Estimate(I2C_0, &Transfer, &Budget);
+  TEST_ASSERT_TRUE(TwiSim_GetClock() <= Budget.WorstUs * CYCLES_PER_US);
+}
+
+void test_InvalidProgramIsRejected(void)
+{
+  const uint8_t Program[] = { I2C_OP_START, I2C_OP_MAX, I2C_OP_END };
+  I2cTransfer_t Transfer = { Program, FAST_DEVICE, 0, 0x0, 0x0, 0x0, 0x0 };
+  I2cBudget_t Budget;
+
+  TEST_ASSERT_EQUAL_UINT8(0, I2cBudget_Estimate(I2C_0, &Transfer, &Budget));
+  TEST_ASSERT_EQUAL_UINT8(0, I2cBudget_Estimate(I2C_MAX, &Transfer, &Budget));
+}
+
+void test_CheckScheduleFlagsTheTasksWhichOverrun(void)
+{
+  I2cTransfer_t Transfers[2] =
+  {
+    { gSendBytes, FAST_DEVICE, 0, gData, 0x0, 0x0, 0x0 },
+    { gReceiveBytes, SLOW_DEVICE, 0, 0x0, gData, 0x0, 0x0 },
+  };
+  const uint8_t Invalid[] = { I2C_OP_MAX };
+  I2cTransfer_t InvalidTransfer = { Invalid, FAST_DEVICE, 0, 0x0, 0x0, 0x0,
+                                    0x0 };
+  I2cBudgetTask_t Tasks[3] =
+  {
+    { I2C_0, Transfers, 2, 100000, 0 },
+    { I2C_0, Transfers, 2, 1000, 0 },
+    { I2C_0, &InvalidTransfer, 1, 100000, 0 },
+  };
+  I2cBudget_t First;
+  I2cBudget_t Second;
+
+  TEST_ASSERT_EQUAL_UINT8(2, I2cBudget_CheckSchedule(Tasks, 3));
+
+  I2cBudget_Estimate(I2C_0, &Transfers[0], &First);
+  I2cBudget_Estimate(I2C_0, &Transfers[1], &Second);
+  TEST_ASSERT_EQUAL_UINT32(First.WorstUs + Second.WorstUs, Tasks[0].WorstUs);
+  TEST_ASSERT_EQUAL_UINT32(Tasks[0].WorstUs, Tasks[1].WorstUs);
+  TEST_ASSERT_EQUAL_UINT32(I2C_BUDGET_INVALID, Tasks[2].WorstUs);
+}
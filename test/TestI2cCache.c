@@ -0,0 +1,162 @@
+#include "unity.h"
+#include "i2c.h"
+#include "i2c_cfg.h"
+#include "i2c_cache.h"
+#include "twi_sim.h"
+
+#define EEPROM_ADDRESS 0x50 /* the address of I2C_DEVICE_0 */
+
+static TwiSimDevice_t* gEeprom;
+
+void setUp(void)
+{
+  uint16_t i;
+
+  TwiSim_Init();
+  gEeprom = TwiSim_AddDevice(I2C_0, EEPROM_ADDRESS);
+  for(i = 0; i < 256; i++)
+    {
+      gEeprom->Memory[i] = (uint8_t)i;
+    }
+
+  I2c_Init(I2c_GetConfig());
+  I2cCache_Init();
+}
+
+void tearDown(void)
+{
+}
+
+void test_SequentialBytesAreReadOneLineAtATime(void)
+{
+  I2cCacheStats_t Stats;
+  uint8_t Data;
+  uint16_t i;
+
+  for(i = 0; i < 256; i++)
+    {
+      TEST_ASSERT_EQUAL_UINT8(1, I2cCache_Read(I2C_DEVICE_0, i, &Data, 1));
+      TEST_ASSERT_EQUAL_UINT8(i, Data);
+    }
+
+  I2cCache_GetStats(&Stats);
+  TEST_ASSERT_EQUAL_UINT32(256 / I2C_CACHE_LINE_SIZE, Stats.Misses);
+  TEST_ASSERT_EQUAL_UINT32(256 - 256 / I2C_CACHE_LINE_SIZE, Stats.Hits);
+}
+
+void test_ReadAcrossLinesIsServedFromTheCache(void)
+{
+  uint8_t Expected[24];
+  uint8_t Data[24];
+  I2cCacheStats_t Stats;
+  uint8_t i;
+
+  for(i = 0; i < sizeof(Expected); i++)
+    {
+      Expected[i] = 0x0C + i;
+    }
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2cCache_Read(I2C_DEVICE_0, 0x0C, Data, 24));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(Expected, Data, 24);
+  TEST_ASSERT_EQUAL_UINT8(1, I2cCache_Read(I2C_DEVICE_0, 0x0C, Data, 24));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(Expected, Data, 24);
+
+  I2cCache_GetStats(&Stats);
+  TEST_ASSERT_EQUAL_UINT32(3, Stats.Misses);
+}
+
+void test_WriteInvalidatesTheLine(void)
+{
+  const uint8_t New[2] = { 0xAA, 0xBB };
+  uint8_t Data[2];
+
+  I2cCache_Read(I2C_DEVICE_0, 0x21, Data, 2);
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2cCache_Write(I2C_DEVICE_0, 0x21, New, 2));
+  TEST_ASSERT_EQUAL_UINT8(1, I2cCache_Read(I2C_DEVICE_0, 0x21, Data, 2));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(New, Data, 2);
+}
+
+void test_EmptyWriteKeepsTheLines(void)
+{
+  I2cCacheStats_t Stats;
+  uint8_t Data;
+
+  I2cCache_Read(I2C_DEVICE_0, 0x00, &Data, 1);
+  I2cCache_Read(I2C_DEVICE_0, 0x40, &Data, 1);
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2cCache_Write(I2C_DEVICE_0, 0x00, 0x0, 0));
+  I2cCache_Read(I2C_DEVICE_0, 0x00, &Data, 1);
+  I2cCache_Read(I2C_DEVICE_0, 0x40, &Data, 1);
+
+  I2cCache_GetStats(&Stats);
+  TEST_ASSERT_EQUAL_UINT32(2, Stats.Misses);
+}
+
+void test_DirectWriteIsSeenAfterInvalidate(void)
+{
+  uint8_t Data;
+
+  I2cCache_Read(I2C_DEVICE_0, 0x40, &Data, 1);
+  I2c_SendByte(I2C_0, EEPROM_ADDRESS, 0x40, 0x55);
+
+  //the driver dropped the line of the written register
+  I2cCache_Read(I2C_DEVICE_0, 0x40, &Data, 1);
+  TEST_ASSERT_EQUAL_UINT8(0x55, Data);
+}
+
+void test_AsyncWriteDropsTheLinesOfItsRegisters(void)
+{
+  static const uint8_t Program[] =
+  {
+    I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_REG, I2C_OP_TX, 2, I2C_OP_STOP,
+    I2C_OP_END
+  };
+  const uint8_t New[2] = { 0xAA, 0xBB };
+  I2cTransfer_t Transfer = { Program, EEPROM_ADDRESS, 0x00, New, 0x0, 0x0,
+                             0x0 };
+  I2cCacheStats_t Stats;
+  uint8_t Data[2];
+
+  //the write spans the end of one line and the start of the next one
+  I2cCache_Read(I2C_DEVICE_0, 0x00, Data, 1);
+  I2cCache_Read(I2C_DEVICE_0, I2C_CACHE_LINE_SIZE, Data, 1);
+  I2cCache_Read(I2C_DEVICE_0, 2 * I2C_CACHE_LINE_SIZE, Data, 1);
+
+  Transfer.Register = I2C_CACHE_LINE_SIZE - 1;
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_TransferAsync(I2C_0, &Transfer));
+  while(I2c_GetResult(I2C_0) == I2C_PENDING)
+    {
+      I2c_Poll();
+    }
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2cCache_Read(I2C_DEVICE_0,
+                                           I2C_CACHE_LINE_SIZE - 1, Data, 2));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(New, Data, 2);
+
+  //the third line is still cached
+  I2cCache_Read(I2C_DEVICE_0, 2 * I2C_CACHE_LINE_SIZE, Data, 1);
+  I2cCache_GetStats(&Stats);
+  TEST_ASSERT_EQUAL_UINT32(5, Stats.Misses);
+  TEST_ASSERT_EQUAL_UINT32(1, Stats.Hits);
+}
+
+void test_FailedFillIsNotCached(void)
+{
+  uint8_t Data;
+
+  gEeprom->Address = 0x51;
+  TEST_ASSERT_EQUAL_UINT8(3, I2cCache_Read(I2C_DEVICE_0, 0x00, &Data, 1));
+
+  gEeprom->Address = EEPROM_ADDRESS;
+  TEST_ASSERT_EQUAL_UINT8(1, I2cCache_Read(I2C_DEVICE_0, 0x00, &Data, 1));
+  TEST_ASSERT_EQUAL_UINT8(0x00, Data);
+}
+
+void test_ReadBeyondTheLastRegisterIsRejected(void)
+{
+  uint8_t Data[2];
+
+  TEST_ASSERT_EQUAL_UINT8(0, I2cCache_Read(I2C_DEVICE_0, 0xFF, Data, 2));
+  TEST_ASSERT_EQUAL_UINT8(0, I2cCache_Read(I2C_DEVICE_MAX, 0x00, Data, 1));
+}
@@ -0,0 +1,171 @@
+#include "unity.h"
+#include "i2c.h"
+#include "i2c_cfg.h"
+#include "i2c_drdy.h"
+#include "twi_sim.h"
+
+#define DEVICE 0x50 /* I2C_DEVICE_0, the device of I2C_DRDY_0 */
+#define SAMPLE_REG 0x28
+#define SAMPLE_SIZE 6
+
+/* START, SLA+W, register, START, SLA+R and the bytes of the sample */
+#define READ_STEPS (5 + SAMPLE_SIZE)
+
+static const uint8_t gWrite[] =
+{
+  I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_REG, I2C_OP_TX, 2, I2C_OP_STOP,
+  I2C_OP_END
+};
+
+static const uint8_t gData[2] = { 0x12, 0x34 };
+
+static TwiSimDevice_t* gDevice;
+
+void setUp(void)
+{
+  TwiSim_Init();
+  gDevice = TwiSim_AddDevice(I2C_0, DEVICE);
+  I2c_Init(I2c_GetConfig());
+  I2cDrdy_Init(I2c_GetDrdyConfig());
+}
+
+void tearDown(void)
+{
+}
+
+/* the main loop, until the bus is idle */
+static void Run(void)
+{
+  do
+    {
+      I2c_Poll();
+      I2cDrdy_Poll();
+    }
+  while(I2c_GetResult(I2C_0) == I2C_PENDING);
+}
+
+static void SetSample(const uint8_t First)
+{
+  uint8_t i;
+
+  for(i = 0; i < SAMPLE_SIZE; i++)
+    {
+      gDevice->Memory[SAMPLE_REG + i] = First + i;
+    }
+}
+
+void test_EdgeReadsAStampedSample(void)
+{
+  I2cDrdySample_t Sample;
+  uint32_t Edge;
+
+  SetSample(0x10);
+  Edge = TwiSim_GetClock();
+  I2cDrdy_Trigger(I2C_DRDY_0);
+  Run();
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2cDrdy_GetCount(I2C_DRDY_0));
+  TEST_ASSERT_EQUAL_UINT8(1, I2cDrdy_Read(I2C_DRDY_0, &Sample));
+  TEST_ASSERT_EQUAL_HEX8(0x10, Sample.Data[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x15, Sample.Data[5]);
+  TEST_ASSERT_EQUAL_UINT32(Edge, Sample.Time);
+  TEST_ASSERT_TRUE(Sample.Done > Sample.Time);
+  TEST_ASSERT_EQUAL_UINT8(0, I2cDrdy_Read(I2C_DRDY_0, &Sample));
+}
+
+void test_LatencyIsCloseToTheBusTime(void)
+{
+  I2cDrdySample_t Sample;
+  I2cDrdyStats_t Stats;
+
+  I2cDrdy_Trigger(I2C_DRDY_0);
+  Run();
+  I2cDrdy_Read(I2C_DRDY_0, &Sample);
+  I2cDrdy_GetStats(I2C_DRDY_0, &Stats);
+
+  //the bus, one command and one poll per step, and the stop bit
+  TEST_ASSERT_TRUE(Sample.Done - Sample.Time <=
+                   TwiSim_GetBusCycles(I2C_0) +
+                   (READ_STEPS + 1) * (I2C_STEP_CYCLES + I2C_POLL_CYCLES));
+  TEST_ASSERT_EQUAL_UINT32(Sample.Done - Sample.Time, Stats.MaxLatency);
+}
+
+void test_EdgeOnABusyBusIsServedWhenItsFree(void)
+{
+  I2cTransfer_t Other = { gWrite, DEVICE, 0x00, gData, 0x0, 0x0, 0x0 };
+  I2cDrdySample_t Sample;
+  uint32_t Edge;
+
+  SetSample(0x40);
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_TransferAsync(I2C_0, &Other));
+  Edge = TwiSim_GetClock();
+  I2cDrdy_Trigger(I2C_DRDY_0);
+  TEST_ASSERT_EQUAL_UINT8(0, I2cDrdy_GetCount(I2C_DRDY_0));
+
+  Run();
+
+  TEST_ASSERT_EQUAL_HEX8(0x34, gDevice->Memory[0x01]);
+  TEST_ASSERT_EQUAL_UINT8(1, I2cDrdy_Read(I2C_DRDY_0, &Sample));
+  TEST_ASSERT_EQUAL_HEX8(0x40, Sample.Data[0]);
+  TEST_ASSERT_EQUAL_UINT32(Edge, Sample.Time);
+}
+
+void test_EdgeDuringAReadIsMissed(void)
+{
+  I2cDrdyStats_t Stats;
+
+  I2cDrdy_Trigger(I2C_DRDY_0);
+  I2cDrdy_Trigger(I2C_DRDY_0);
+  Run();
+  I2cDrdy_GetStats(I2C_DRDY_0, &Stats);
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2cDrdy_GetCount(I2C_DRDY_0));
+  TEST_ASSERT_EQUAL_UINT32(1, Stats.Samples);
+  TEST_ASSERT_EQUAL_UINT16(1, Stats.Missed);
+}
+
+void test_FullBufferDropsTheOldestSample(void)
+{
+  I2cDrdySample_t Sample;
+  I2cDrdyStats_t Stats;
+  uint8_t i;
+
+  for(i = 0; i <= I2C_DRDY_DEPTH; i++)
+    {
+      SetSample(i * 0x10);
+      I2cDrdy_Trigger(I2C_DRDY_0);
+      Run();
+    }
+  I2cDrdy_GetStats(I2C_DRDY_0, &Stats);
+
+  TEST_ASSERT_EQUAL_UINT16(1, Stats.Overruns);
+  TEST_ASSERT_EQUAL_UINT8(I2C_DRDY_DEPTH, I2cDrdy_GetCount(I2C_DRDY_0));
+  TEST_ASSERT_EQUAL_UINT8(1, I2cDrdy_Read(I2C_DRDY_0, &Sample));
+  TEST_ASSERT_EQUAL_HEX8(0x10, Sample.Data[0]);
+}
+
+void test_FailedReadIsCountedAndTheLineRecovers(void)
+{
+  I2cDrdySample_t Sample;
+  I2cDrdyStats_t Stats;
+
+  TwiSim_Init();
+  I2c_Init(I2c_GetConfig());
+  I2cDrdy_Init(I2c_GetDrdyConfig());
+
+  //nobody answers
+  I2cDrdy_Trigger(I2C_DRDY_0);
+  Run();
+  I2cDrdy_GetStats(I2C_DRDY_0, &Stats);
+
+  TEST_ASSERT_EQUAL_UINT16(1, Stats.Errors);
+  TEST_ASSERT_EQUAL_UINT8(0, I2cDrdy_GetCount(I2C_DRDY_0));
+
+  gDevice = TwiSim_AddDevice(I2C_0, DEVICE);
+  SetSample(0x70);
+  I2cDrdy_Trigger(I2C_DRDY_0);
+  Run();
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2cDrdy_Read(I2C_DRDY_0, &Sample));
+  TEST_ASSERT_EQUAL_HEX8(0x70, Sample.Data[0]);
+}
@@ -0,0 +1,195 @@
+#include "unity.h"
+#include "i2c.h"
+#include "i2c_cfg.h"
+#include "i2c_pool.h"
+#include "twi_sim.h"
+
+#define DEVICE 0x50
+
+static const uint8_t gSendBytes[] =
+{
+  I2C_OP_START, I2C_OP_ADDR_W, I2C_OP_REG, I2C_OP_TX, 4, I2C_OP_STOP,
+  I2C_OP_END
+};
+
+static TwiSimDevice_t* gDevice;
+static uint8_t gStatus;
+
+void setUp(void)
+{
+  TwiSim_Init();
+  gDevice = TwiSim_AddDevice(I2C_0, DEVICE);
+  I2c_Init(I2c_GetConfig());
+  I2cPool_Init();
+  gStatus = 0xFF;
+}
+
+void tearDown(void)
+{
+}
+
+/* frees the descriptor and the buffer of the transfer */
+static void FreeTransfer(const I2c_t I2c,
+                         const I2cTransfer_t* const Transfer,
+                         const uint8_t Status)
+{
+  (void)I2c;
+
+  gStatus = Status;
+  I2cPool_FreeBuffer((uint8_t*)Transfer->TxData);
+  I2cPool_Free((I2cDescriptor_t*)Transfer);
+}
+
+void test_ExhaustedPoolFailsAndCountsTheFailures(void)
+{
+  I2cDescriptor_t* Descriptors[I2C_POOL_DESCRIPTOR_COUNT];
+  I2cPoolStats_t Stats;
+  uint8_t i;
+
+  for(i = 0; i < I2C_POOL_DESCRIPTOR_COUNT; i++)
+    {
+      Descriptors[i] = I2cPool_Alloc();
+      TEST_ASSERT_NOT_NULL(Descriptors[i]);
+    }
+
+  TEST_ASSERT_NULL(I2cPool_Alloc());
+  TEST_ASSERT_NULL(I2cPool_Alloc());
+  I2cPool_GetStats(I2C_POOL_DESCRIPTOR, &Stats);
+  TEST_ASSERT_EQUAL_UINT8(I2C_POOL_DESCRIPTOR_COUNT, Stats.Used);
+  TEST_ASSERT_EQUAL_UINT16(2, Stats.Failures);
+
+  //a freed descriptor can be allocated again
+  TEST_ASSERT_EQUAL_UINT8(1, I2cPool_Free(Descriptors[3]));
+  TEST_ASSERT_EQUAL_PTR(Descriptors[3], I2cPool_Alloc());
+}
+
+void test_DescriptorsAreDistinctAndZeroed(void)
+{
+  I2cDescriptor_t* First = I2cPool_Alloc();
+  I2cDescriptor_t* Second = I2cPool_Alloc();
+
+  TEST_ASSERT_TRUE(First != Second);
+  First->Request.Length = 100;
+  First->Request.Priority = 3;
+  I2cPool_Free(First);
+
+  First = I2cPool_Alloc();
+  TEST_ASSERT_EQUAL_UINT16(0, First->Request.Length);
+  TEST_ASSERT_EQUAL_UINT8(0, First->Request.Priority);
+  TEST_ASSERT_NULL(First->Transfer.Callback);
+}
+
+void test_PeakIsTheHighWaterMark(void)
+{
+  I2cDescriptor_t* Descriptors[3];
+  I2cPoolStats_t Stats;
+  uint8_t i;
+
+  for(i = 0; i < 3; i++)
+    {
+      Descriptors[i] = I2cPool_Alloc();
+    }
+  for(i = 0; i < 3; i++)
+    {
+      I2cPool_Free(Descriptors[i]);
+    }
+  Descriptors[0] = I2cPool_Alloc();
+
+  I2cPool_GetStats(I2C_POOL_DESCRIPTOR, &Stats);
+  TEST_ASSERT_EQUAL_UINT8(1, Stats.Used);
+  TEST_ASSERT_EQUAL_UINT8(3, Stats.Peak);
+  TEST_ASSERT_EQUAL_UINT16(0, Stats.Failures);
+
+  //the buffers are counted apart
+  I2cPool_GetStats(I2C_POOL_BUFFER, &Stats);
+  TEST_ASSERT_EQUAL_UINT8(0, Stats.Peak);
+
+  I2cPool_Init();
+  I2cPool_GetStats(I2C_POOL_DESCRIPTOR, &Stats);
+  TEST_ASSERT_EQUAL_UINT8(0, Stats.Used);
+  TEST_ASSERT_EQUAL_UINT8(0, Stats.Peak);
+}
+
+void test_DoubleFreeAndForeignPointersAreRejected(void)
+{
+  I2cDescriptor_t Foreign;
+  I2cDescriptor_t* Descriptor = I2cPool_Alloc();
+  uint8_t* Buffer = I2cPool_AllocBuffer();
+  uint8_t Bytes[I2C_POOL_BUFFER_SIZE];
+  I2cPoolStats_t Stats;
+
+  TEST_ASSERT_EQUAL_UINT8(0, I2cPool_Free(&Foreign));
+  TEST_ASSERT_EQUAL_UINT8(0, I2cPool_Free(0x0));
+  TEST_ASSERT_EQUAL_UINT8(0, I2cPool_Free(
+                               (I2cDescriptor_t*)((uint8_t*)Descriptor + 1)));
+  TEST_ASSERT_EQUAL_UINT8(0, I2cPool_FreeBuffer(Bytes));
+  TEST_ASSERT_EQUAL_UINT8(0, I2cPool_FreeBuffer(Buffer + 1));
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2cPool_Free(Descriptor));
+  TEST_ASSERT_EQUAL_UINT8(0, I2cPool_Free(Descriptor));
+  TEST_ASSERT_EQUAL_UINT8(1, I2cPool_FreeBuffer(Buffer));
+  TEST_ASSERT_EQUAL_UINT8(0, I2cPool_FreeBuffer(Buffer));
+
+  I2cPool_GetStats(I2C_POOL_DESCRIPTOR, &Stats);
+  TEST_ASSERT_EQUAL_UINT8(0, Stats.Used);
+  I2cPool_GetStats(I2C_POOL_BUFFER, &Stats);
+  TEST_ASSERT_EQUAL_UINT8(0, Stats.Used);
+}
+
+void test_BuffersDoNotOverlap(void)
+{
+  uint8_t* Buffers[I2C_POOL_BUFFER_COUNT];
+  uint8_t i;
+  uint8_t j;
+
+  for(i = 0; i < I2C_POOL_BUFFER_COUNT; i++)
+    {
+      Buffers[i] = I2cPool_AllocBuffer();
+      TEST_ASSERT_NOT_NULL(Buffers[i]);
+      for(j = 0; j < I2C_POOL_BUFFER_SIZE; j++)
+        {
+          Buffers[i][j] = i;
+        }
+    }
+  TEST_ASSERT_NULL(I2cPool_AllocBuffer());
+
+  for(i = 0; i < I2C_POOL_BUFFER_COUNT; i++)
+    {
+      for(j = 0; j < I2C_POOL_BUFFER_SIZE; j++)
+        {
+          TEST_ASSERT_EQUAL_UINT8(i, Buffers[i][j]);
+        }
+    }
+}
+
+void test_AsyncTransferFreesItsDescriptorFromTheCallback(void)
+{
+  I2cDescriptor_t* Descriptor = I2cPool_Alloc();
+  uint8_t* Buffer = I2cPool_AllocBuffer();
+  I2cPoolStats_t Stats;
+
+  Buffer[0] = 0xDE;
+  Buffer[1] = 0xAD;
+  Buffer[2] = 0xBE;
+  Buffer[3] = 0xEF;
+  Descriptor->Transfer.Program = gSendBytes;
+  Descriptor->Transfer.Address = DEVICE;
+  Descriptor->Transfer.Register = 0x10;
+  Descriptor->Transfer.TxData = Buffer;
+  Descriptor->Transfer.Callback = FreeTransfer;
+  Descriptor->Transfer.Receive = 0x0;
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_TransferAsync(I2C_0, &Descriptor->Transfer));
+  while(I2c_GetResult(I2C_0) == I2C_PENDING)
+    {
+      I2c_Poll();
+    }
+
+  TEST_ASSERT_EQUAL_UINT8(1, gStatus);
+  TEST_ASSERT_EQUAL_HEX8(0xEF, gDevice->Memory[0x13]);
+  I2cPool_GetStats(I2C_POOL_DESCRIPTOR, &Stats);
+  TEST_ASSERT_EQUAL_UINT8(0, Stats.Used);
+  I2cPool_GetStats(I2C_POOL_BUFFER, &Stats);
+  TEST_ASSERT_EQUAL_UINT8(0, Stats.Used);
+  TEST_ASSERT_EQUAL_UINT8(1, Stats.Peak);
+}
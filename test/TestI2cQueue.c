@@ -0,0 +1,127 @@
+#include "unity.h"
+#include "i2c.h"
+#include "i2c_cfg.h"
+#include "i2c_arb.h"
+#include "i2c_queue.h"
+#include "twi_sim.h"
+
+static I2cRequest_t gRequests[I2C_QUEUE_SIZE + 1];
+static I2cRequest_t* gSeenByIsr; /* what the consumer got while the first
+                                    producer was preempted */
+static uint8_t gSubmittedByIsr;
+
+void setUp(void)
+{
+  uint8_t i;
+
+  TwiSim_Init();
+  I2cQueue_Init();
+  gSeenByIsr = 0x0;
+  gSubmittedByIsr = 0;
+
+  for(i = 0; i < I2C_QUEUE_SIZE + 1; i++)
+    {
+      gRequests[i].Status = 0;
+    }
+}
+
+void tearDown(void)
+{
+}
+
+/* a producer ISR preempts the main producer right after it reserved its
+ * slot, then the consumer looks at the queue */
+static void PreemptingProducer(void)
+{
+  gSubmittedByIsr = I2cQueue_Submit(&gRequests[1]);
+  gSeenByIsr = I2cQueue_Receive();
+}
+
+void test_RequestsAreReceivedInTheSubmissionOrder(void)
+{
+  uint8_t i;
+
+  TEST_ASSERT_NULL(I2cQueue_Receive());
+
+  for(i = 0; i < 3; i++)
+    {
+      TEST_ASSERT_EQUAL_UINT8(1, I2cQueue_Submit(&gRequests[i]));
+      TEST_ASSERT_EQUAL_HEX8(I2C_ARB_PENDING, gRequests[i].Status);
+    }
+
+  for(i = 0; i < 3; i++)
+    {
+      TEST_ASSERT_EQUAL_PTR(&gRequests[i], I2cQueue_Receive());
+    }
+  TEST_ASSERT_NULL(I2cQueue_Receive());
+  TEST_ASSERT_EQUAL_UINT8(0, I2cQueue_Submit(0x0));
+}
+
+void test_ReservedSlotHoldsBackTheLaterSlotsUntilItIsPublished(void)
+{
+  TwiSim_SetInterrupt(PreemptingProducer);
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2cQueue_Submit(&gRequests[0]));
+
+  //the ISR got the slot after the reserved one and published it, but the
+  //consumer waits for the reserved slot
+  TEST_ASSERT_EQUAL_UINT8(1, gSubmittedByIsr);
+  TEST_ASSERT_NULL(gSeenByIsr);
+
+  //the slots are read in the order of their reservation
+  TEST_ASSERT_EQUAL_PTR(&gRequests[0], I2cQueue_Receive());
+  TEST_ASSERT_EQUAL_PTR(&gRequests[1], I2cQueue_Receive());
+  TEST_ASSERT_NULL(I2cQueue_Receive());
+}
+
+void test_FullQueueRejectsTheRequest(void)
+{
+  uint8_t i;
+
+  for(i = 0; i < I2C_QUEUE_SIZE; i++)
+    {
+      TEST_ASSERT_EQUAL_UINT8(1, I2cQueue_Submit(&gRequests[i]));
+    }
+
+  //the rejected request is left as it is
+  TEST_ASSERT_EQUAL_UINT8(0, I2cQueue_Submit(&gRequests[I2C_QUEUE_SIZE]));
+  TEST_ASSERT_EQUAL_HEX8(0, gRequests[I2C_QUEUE_SIZE].Status);
+
+  //a received slot is free again
+  TEST_ASSERT_EQUAL_PTR(&gRequests[0], I2cQueue_Receive());
+  TEST_ASSERT_EQUAL_UINT8(1, I2cQueue_Submit(&gRequests[I2C_QUEUE_SIZE]));
+  TEST_ASSERT_EQUAL_UINT8(0, I2cQueue_Submit(&gRequests[0]));
+
+  for(i = 1; i < I2C_QUEUE_SIZE + 1; i++)
+    {
+      TEST_ASSERT_EQUAL_PTR(&gRequests[i], I2cQueue_Receive());
+    }
+  TEST_ASSERT_NULL(I2cQueue_Receive());
+}
+
+void test_IndexesWrapAroundTheirByte(void)
+{
+  uint16_t Round;
+  uint8_t i;
+
+  //3 slots a round, the 8-bit head and tail wrap after 86 rounds
+  for(Round = 0; Round < 100; Round++)
+    {
+      for(i = 0; i < 3; i++)
+        {
+          TEST_ASSERT_EQUAL_UINT8(1, I2cQueue_Submit(&gRequests[i]));
+        }
+      for(i = 0; i < 3; i++)
+        {
+          TEST_ASSERT_EQUAL_PTR(&gRequests[i], I2cQueue_Receive());
+        }
+      TEST_ASSERT_NULL(I2cQueue_Receive());
+    }
+
+  //the full check still holds across the wrap
+  for(i = 0; i < I2C_QUEUE_SIZE; i++)
+    {
+      TEST_ASSERT_EQUAL_UINT8(1, I2cQueue_Submit(&gRequests[i]));
+    }
+  TEST_ASSERT_EQUAL_UINT8(0, I2cQueue_Submit(&gRequests[I2C_QUEUE_SIZE]));
+}
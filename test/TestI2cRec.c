@@ -0,0 +1,169 @@
+#include "unity.h"
+#include "i2c.h"
+#include "i2c_cfg.h"
+#include "i2c_rec.h"
+#include "twi_sim.h"
+#include "twi_replay.h"
+
+#define EEPROM_ADDRESS 0x50
+#define MISSING_ADDRESS 0x31
+
+static uint8_t gLog[I2C_REC_SIZE];
+
+static TwiReplayResult_t gResult;
+
+void setUp(void)
+{
+  TwiSimDevice_t* Eeprom;
+  uint16_t i;
+
+  TwiSim_Init();
+  Eeprom = TwiSim_AddDevice(I2C_0, EEPROM_ADDRESS);
+  for(i = 0; i < 256; i++)
+    {
+      Eeprom->Memory[i] = (uint8_t)(0xFF - i);
+    }
+
+  I2c_Init(I2c_GetConfig());
+  I2cRec_Init();
+}
+
+void tearDown(void)
+{
+  I2c_SetRecorder(0x0);
+}
+
+/* run a session against the model and take its log */
+static uint16_t RecordSession(uint8_t* const Rx)
+{
+  const uint8_t Tx[3] = { 0x11, 0x22, 0x33 };
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_SendBytes(I2C_0, EEPROM_ADDRESS, 0x10, Tx, 3));
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_ReceiveBytes(I2C_0, EEPROM_ADDRESS, 0x0F, Rx, 5));
+  TEST_ASSERT_EQUAL_UINT8(3, I2c_SendByte(I2C_0, MISSING_ADDRESS, 0x00, 0x44));
+
+  return I2cRec_Read(gLog, sizeof(gLog));
+}
+
+/* replay a log on a bus without devices */
+static void Replay(const uint8_t* const Log, const uint16_t Length)
+{
+  TwiSim_Init();
+  I2c_Init(I2c_GetConfig());
+  TwiReplay_Run(Log, Length, &gResult);
+}
+
+void test_StepsAreRecordedWithTheirStatusAndByte(void)
+{
+  const uint8_t Expected[][3] =
+  {
+    { I2C_OP_START, 0x08, 0 },
+    { I2C_OP_ADDR_W, 0x18, EEPROM_ADDRESS << 1 },
+    { I2C_OP_REG, 0x28, 0x20 },
+    { I2C_OP_TX, 0x28, 0x99 },
+    { I2C_OP_STOP, I2C_NO_STATUS, 0 },
+  };
+  uint16_t Length;
+  uint8_t i;
+
+  I2c_SendByte(I2C_0, EEPROM_ADDRESS, 0x20, 0x99);
+
+  Length = I2cRec_Read(gLog, sizeof(gLog));
+  TEST_ASSERT_EQUAL_UINT16(5 * I2C_REC_RECORD_SIZE, Length);
+
+  for(i = 0; i < 5; i++)
+    {
+      TEST_ASSERT_EQUAL_HEX8(I2C_0 << 4 | Expected[i][0], gLog[5 * i]);
+      TEST_ASSERT_EQUAL_HEX8(Expected[i][1], gLog[5 * i + 1]);
+      if(Expected[i][0] != I2C_OP_START && Expected[i][0] != I2C_OP_STOP)
+        {
+          TEST_ASSERT_EQUAL_HEX8(Expected[i][2], gLog[5 * i + 2]);
+        }
+    }
+
+  //the gaps add up to the clock
+  TEST_ASSERT_UINT32_WITHIN(I2C_STEP_CYCLES, TwiSim_GetClock(),
+    (uint32_t)gLog[3] + (gLog[4] << 8) + gLog[8] + (gLog[9] << 8) +
+    gLog[13] + (gLog[14] << 8) + gLog[18] + (gLog[19] << 8) +
+    gLog[23] + (gLog[24] << 8));
+
+  TEST_ASSERT_EQUAL_UINT16(0, I2cRec_Read(gLog, sizeof(gLog)));
+}
+
+void test_ReplayReproducesTheSession(void)
+{
+  uint8_t Rx[5];
+  uint8_t Replayed[I2C_REC_SIZE];
+  const uint16_t Length = RecordSession(Rx);
+  uint16_t i;
+
+  Replay(gLog, Length);
+
+  TEST_ASSERT_EQUAL_UINT16(0, gResult.Mismatches);
+  TEST_ASSERT_EQUAL_UINT16(1, gResult.Failed);
+  TEST_ASSERT_EQUAL_UINT16(5, gResult.RxCount);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(Rx, gResult.Rx, 5);
+
+  //the replay is recorded the same, at about the same time
+  TEST_ASSERT_EQUAL_UINT16(Length, I2cRec_Read(Replayed, sizeof(Replayed)));
+  for(i = 0; i < Length; i += I2C_REC_RECORD_SIZE)
+    {
+      TEST_ASSERT_EQUAL_HEX8_ARRAY(&gLog[i], &Replayed[i], 3);
+    }
+  TEST_ASSERT_UINT32_WITHIN((Length / I2C_REC_RECORD_SIZE) * I2C_POLL_CYCLES,
+                            gResult.LogCycles, gResult.Cycles);
+}
+
+void test_ReplayReproducesATimeout(void)
+{
+  //a start bit which never ends, then the stop bit of the driver
+  const uint8_t Log[] =
+  {
+    I2C_0 << 4 | I2C_OP_START, I2C_NO_STATUS, 0, 0x00, 0x10,
+    I2C_0 << 4 | I2C_OP_STOP, I2C_NO_STATUS, 0, 0x20, 0x00,
+  };
+
+  Replay(Log, sizeof(Log));
+
+  TEST_ASSERT_EQUAL_UINT16(1, gResult.Transfers);
+  TEST_ASSERT_EQUAL_UINT16(1, gResult.Failed);
+  TEST_ASSERT_EQUAL_UINT16(0, gResult.Mismatches);
+  TEST_ASSERT_TRUE(gResult.Cycles >= (uint32_t)I2C_TIMEOUT * I2C_POLL_CYCLES);
+}
+
+void test_ReplayFlagsTheStepsTheDriverRunsDifferently(void)
+{
+  uint8_t Rx[5];
+  const uint16_t Length = RecordSession(Rx);
+
+  //the register of the first transfer was NACKed: the driver stops there
+  //instead of sending the data
+  gLog[2 * I2C_REC_RECORD_SIZE + 1] = 0x30;
+
+  Replay(gLog, Length);
+
+  //its stop bit is answered with the first data byte, the two other data
+  //bytes and the recorded stop bit are left
+  TEST_ASSERT_EQUAL_UINT16(2, gResult.Failed);
+  TEST_ASSERT_EQUAL_UINT16(4, gResult.Mismatches);
+}
+
+void test_FullLogDropsWholeRecords(void)
+{
+  uint16_t Length;
+  uint16_t i;
+
+  for(i = 0; i < I2C_REC_SIZE / I2C_REC_RECORD_SIZE; i++)
+    {
+      I2c_SendByte(I2C_0, EEPROM_ADDRESS, 0x00, (uint8_t)i);
+    }
+
+  TEST_ASSERT_TRUE(I2cRec_GetDropped() > 0);
+
+  Length = I2cRec_Read(gLog, 7);
+  TEST_ASSERT_EQUAL_UINT16(I2C_REC_RECORD_SIZE, Length);
+
+  Length += I2cRec_Read(&gLog[Length], sizeof(gLog) - Length);
+  TEST_ASSERT_EQUAL_UINT16(
+    (I2C_REC_SIZE / I2C_REC_RECORD_SIZE) * I2C_REC_RECORD_SIZE, Length);
+}
@@ -0,0 +1,137 @@
+#include "unity.h"
+#include "i2c.h"
+#include "i2c_cfg.h"
+#include "i2c_sample.h"
+#include "twi_sim.h"
+
+#define SENSOR_ADDRESS 0x50
+#define FIFO_REG 0x40
+
+static TwiSimDevice_t* gSensor;
+
+void setUp(void)
+{
+  TwiSim_Init();
+  gSensor = TwiSim_AddDevice(I2C_0, SENSOR_ADDRESS);
+  I2c_Init(I2c_GetConfig());
+}
+
+void tearDown(void)
+{
+}
+
+/* a sample of two bytes in the FIFO */
+static void SetWord(const uint8_t Index, const uint8_t First, const uint8_t Second)
+{
+  gSensor->Memory[FIFO_REG + 2 * Index] = First;
+  gSensor->Memory[FIFO_REG + 2 * Index + 1] = Second;
+}
+
+void test_Signed16BigEndianSamplesAreDecodedInPlace(void)
+{
+  const I2cSampleFormat_t Format = I2C_SAMPLE_S16_BE;
+  int16_t Samples[3];
+
+  SetWord(0, 0x12, 0x34);
+  SetWord(1, 0xFF, 0xFE);
+  SetWord(2, 0x80, 0x00);
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2cSample_Read(I2C_0, SENSOR_ADDRESS, FIFO_REG,
+                                            &Format, Samples, 3));
+  TEST_ASSERT_EQUAL_INT16(0x1234, Samples[0]);
+  TEST_ASSERT_EQUAL_INT16(-2, Samples[1]);
+  TEST_ASSERT_EQUAL_INT16(-32768, Samples[2]);
+}
+
+void test_LeftJustified12BitSamplesAreShiftedAndSignExtended(void)
+{
+  const I2cSampleFormat_t Signed = I2C_SAMPLE_S12_LJ_BE;
+  const I2cSampleFormat_t Unsigned = I2C_SAMPLE_U12_LJ_BE;
+  int16_t Samples[4];
+
+  //the low nibble isn't part of the value
+  SetWord(0, 0x7F, 0xFF);
+  SetWord(1, 0x80, 0x0F);
+  SetWord(2, 0xFF, 0xF0);
+  SetWord(3, 0x00, 0x10);
+
+  I2cSample_Read(I2C_0, SENSOR_ADDRESS, FIFO_REG, &Signed, Samples, 4);
+  TEST_ASSERT_EQUAL_INT16(2047, Samples[0]);
+  TEST_ASSERT_EQUAL_INT16(-2048, Samples[1]);
+  TEST_ASSERT_EQUAL_INT16(-1, Samples[2]);
+  TEST_ASSERT_EQUAL_INT16(1, Samples[3]);
+
+  I2cSample_Read(I2C_0, SENSOR_ADDRESS, FIFO_REG, &Unsigned, Samples, 4);
+  TEST_ASSERT_EQUAL_INT16(2048, Samples[1]);
+  TEST_ASSERT_EQUAL_INT16(4095, Samples[2]);
+}
+
+void test_RightJustifiedLittleEndianSamplesIgnoreTheHighBits(void)
+{
+  const I2cSampleFormat_t Format = { 2, 0, 10, 0, 1 };
+  int16_t Samples[2];
+
+  SetWord(0, 0xFF, 0xFD); //0x1FF with a status bit set
+  SetWord(1, 0x00, 0x02); //0x200
+
+  I2cSample_Read(I2C_0, SENSOR_ADDRESS, FIFO_REG, &Format, Samples, 2);
+  TEST_ASSERT_EQUAL_INT16(511, Samples[0]);
+  TEST_ASSERT_EQUAL_INT16(-512, Samples[1]);
+}
+
+void test_LongFifoIsDecodedWhole(void)
+{
+  const I2cSampleFormat_t Format = I2C_SAMPLE_S16_LE;
+  int16_t Samples[150];
+  uint16_t i;
+
+  //more than 255 bytes, the register pointer wraps, and a tail which isn't
+  //a whole vector
+  for(i = 0; i < 256; i++)
+    {
+      gSensor->Memory[i] = (uint8_t)i;
+    }
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2cSample_Read(I2C_0, SENSOR_ADDRESS, 0x00,
+                                            &Format, Samples, 150));
+  for(i = 0; i < 150; i++)
+    {
+      TEST_ASSERT_EQUAL_INT16((int16_t)(((2 * i + 1) & 0xFF) << 8 |
+                                        ((2 * i) & 0xFF)), Samples[i]);
+    }
+}
+
+void test_SignedBytesAreWidened(void)
+{
+  const I2cSampleFormat_t Format = I2C_SAMPLE_S8;
+  const I2cSampleFormat_t Nibble = { 1, 0, 4, 2, 1 };
+  int16_t Samples[3];
+
+  gSensor->Memory[FIFO_REG] = 0x7F;
+  gSensor->Memory[FIFO_REG + 1] = 0x80;
+  gSensor->Memory[FIFO_REG + 2] = 0xFF;
+
+  I2cSample_Read(I2C_0, SENSOR_ADDRESS, FIFO_REG, &Format, Samples, 3);
+  TEST_ASSERT_EQUAL_INT16(127, Samples[0]);
+  TEST_ASSERT_EQUAL_INT16(-128, Samples[1]);
+  TEST_ASSERT_EQUAL_INT16(-1, Samples[2]);
+
+  //bits 5..2
+  I2cSample_Read(I2C_0, SENSOR_ADDRESS, FIFO_REG, &Nibble, Samples, 3);
+  TEST_ASSERT_EQUAL_INT16(-1, Samples[0]);
+  TEST_ASSERT_EQUAL_INT16(0, Samples[1]);
+}
+
+void test_InvalidFormatIsRejectedWithoutTransfer(void)
+{
+  const I2cSampleFormat_t TooWide = { 2, 1, 12, 5, 1 };
+  const I2cSampleFormat_t NoSize = { 3, 1, 8, 0, 1 };
+  int16_t Samples[2];
+
+  TEST_ASSERT_EQUAL_UINT8(0, I2cSample_Read(I2C_0, SENSOR_ADDRESS, FIFO_REG,
+                                            &TooWide, Samples, 2));
+  TEST_ASSERT_EQUAL_UINT8(0, I2cSample_Decode(&NoSize, Samples, 2));
+  TEST_ASSERT_EQUAL_UINT8(0, I2cSample_Read(I2C_0, SENSOR_ADDRESS, FIFO_REG,
+                                            &TooWide, Samples, 0));
+  TEST_ASSERT_EQUAL_UINT32(0, TwiSim_GetBusCycles(I2C_0));
+}
@@ -0,0 +1,228 @@
+#include "unity.h"
+#include "i2c.h"
+#include "i2c_cfg.h"
+#include "i2c_memmap.h"
+#include "i2c_smbus.h"
+#include "twi_sim.h"
+
+#define DEVICE 0x50
+#define COMMAND 0x20
+
+static const uint8_t gBlock[] = { 0x11, 0x22, 0x33 };
+
+static TwiSimDevice_t* gDevice;
+static uint8_t gStarts; /* the start bits seen by CountSteps */
+static uint8_t gStops; /* the stop bits seen by CountSteps */
+
+void setUp(void)
+{
+  TwiSim_Init();
+  gDevice = TwiSim_AddDevice(I2C_0, DEVICE);
+  I2c_Init(I2c_GetConfig());
+  gStarts = 0;
+  gStops = 0;
+}
+
+void tearDown(void)
+{
+}
+
+static void CountSteps(const I2c_t I2c, TwiSimStep_t* const Step)
+{
+  (void)I2c;
+
+  if(Step->Command & (1 << TWSTO))
+    {
+      gStops++;
+    }
+  else if(Step->Command & (1 << TWSTA))
+    {
+      gStarts++;
+    }
+}
+
+static uint8_t GetPec(const uint8_t* const Bytes, const uint8_t Length)
+{
+  uint8_t Crc = 0;
+  uint8_t i;
+
+  for(i = 0; i < Length; i++)
+    {
+      Crc = I2cSmbus_Crc8(Crc, Bytes[i]);
+    }
+
+  return Crc;
+}
+
+/* the device answers a block read of COMMAND with gBlock and its PEC */
+static void LoadBlock(void)
+{
+  const uint8_t Bytes[] = { DEVICE << 1, COMMAND, DEVICE << 1 | 1, 3,
+                            0x11, 0x22, 0x33 };
+
+  gDevice->Memory[COMMAND] = 3;
+  gDevice->Memory[COMMAND + 1] = 0x11;
+  gDevice->Memory[COMMAND + 2] = 0x22;
+  gDevice->Memory[COMMAND + 3] = 0x33;
+  gDevice->Memory[COMMAND + 4] = GetPec(Bytes, sizeof(Bytes));
+}
+
+void test_BlockWriteSendsTheCountTheBytesAndThePec(void)
+{
+  const uint8_t Bytes[] = { DEVICE << 1, COMMAND, 3, 0x11, 0x22, 0x33 };
+
+  TwiSim_SetHook(CountSteps);
+  TEST_ASSERT_EQUAL_UINT8(1, I2cSmbus_BlockWrite(I2C_0, DEVICE, COMMAND,
+                                                 gBlock, 3, 1));
+
+  TEST_ASSERT_EQUAL_HEX8(3, gDevice->Memory[COMMAND]);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(gBlock, &gDevice->Memory[COMMAND + 1], 3);
+  TEST_ASSERT_EQUAL_HEX8(GetPec(Bytes, sizeof(Bytes)),
+                         gDevice->Memory[COMMAND + 4]);
+  TEST_ASSERT_EQUAL_UINT8(1, gStarts);
+  TEST_ASSERT_EQUAL_UINT8(1, gStops);
+}
+
+void test_BlockReadIsOneTransaction(void)
+{
+  uint8_t Data[I2C_SMBUS_BLOCK_MAX];
+  uint8_t Length = 0;
+
+  LoadBlock();
+  TwiSim_SetHook(CountSteps);
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2cSmbus_BlockRead(I2C_0, DEVICE, COMMAND, Data,
+                                                &Length, 1));
+  TEST_ASSERT_EQUAL_UINT8(3, Length);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(gBlock, Data, 3);
+
+  //the repeated start doesn't release the bus
+  TEST_ASSERT_EQUAL_UINT8(2, gStarts);
+  TEST_ASSERT_EQUAL_UINT8(1, gStops);
+}
+
+void test_LargestBlockIsReceivedStraightIntoTheBuffer(void)
+{
+  uint8_t Bytes[4 + I2C_SMBUS_BLOCK_MAX];
+  uint8_t Data[I2C_SMBUS_BLOCK_MAX + 1];
+  uint8_t Length = 0;
+  uint8_t i;
+
+  Bytes[0] = DEVICE << 1;
+  Bytes[1] = COMMAND;
+  Bytes[2] = DEVICE << 1 | 1;
+  Bytes[3] = I2C_SMBUS_BLOCK_MAX;
+  gDevice->Memory[COMMAND] = I2C_SMBUS_BLOCK_MAX;
+  for(i = 0; i < I2C_SMBUS_BLOCK_MAX; i++)
+    {
+      Bytes[4 + i] = 0xA0 + i;
+      gDevice->Memory[COMMAND + 1 + i] = 0xA0 + i;
+    }
+  gDevice->Memory[COMMAND + 1 + I2C_SMBUS_BLOCK_MAX] =
+    GetPec(Bytes, sizeof(Bytes));
+  //the byte after the buffer of the caller
+  Data[I2C_SMBUS_BLOCK_MAX] = 0x5A;
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2cSmbus_BlockRead(I2C_0, DEVICE, COMMAND, Data,
+                                                &Length, 1));
+  TEST_ASSERT_EQUAL_UINT8(I2C_SMBUS_BLOCK_MAX, Length);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(&Bytes[4], Data, I2C_SMBUS_BLOCK_MAX);
+  //the byte count and the PEC aren't saved
+  TEST_ASSERT_EQUAL_HEX8(0x5A, Data[I2C_SMBUS_BLOCK_MAX]);
+}
+
+void test_BlockReadWithoutPecDoesNotReadIt(void)
+{
+  uint8_t Data[I2C_SMBUS_BLOCK_MAX];
+  uint8_t Length = 0;
+
+  LoadBlock();
+  //a wrong PEC which isn't read
+  gDevice->Memory[COMMAND + 4] ^= 0xFF;
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2cSmbus_BlockRead(I2C_0, DEVICE, COMMAND, Data,
+                                                &Length, 0));
+  TEST_ASSERT_EQUAL_UINT8(3, Length);
+  TEST_ASSERT_EQUAL_UINT8(COMMAND + 4, gDevice->Pointer);
+}
+
+void test_CorruptedByteFailsThePec(void)
+{
+  uint8_t Data[I2C_SMBUS_BLOCK_MAX];
+  uint8_t Length = 0;
+
+  LoadBlock();
+  gDevice->Memory[COMMAND + 2] = 0x23;
+
+  TEST_ASSERT_EQUAL_UINT8(8, I2cSmbus_BlockRead(I2C_0, DEVICE, COMMAND, Data,
+                                                &Length, 1));
+  TEST_ASSERT_EQUAL_UINT8(0, Length);
+}
+
+void test_ProcessCallSendsAndReceivesAWord(void)
+{
+  uint16_t Result = 0;
+  uint8_t Bytes[] = { DEVICE << 1, COMMAND, 0x34, 0x12, DEVICE << 1 | 1,
+                      0xCD, 0xAB };
+
+  //the device pointer is past the sent word when the word is read
+  gDevice->Memory[COMMAND + 2] = 0xCD;
+  gDevice->Memory[COMMAND + 3] = 0xAB;
+  gDevice->Memory[COMMAND + 4] = GetPec(Bytes, sizeof(Bytes));
+  TwiSim_SetHook(CountSteps);
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2cSmbus_ProcessCall(I2C_0, DEVICE, COMMAND,
+                                                  0x1234, &Result, 1));
+  TEST_ASSERT_EQUAL_HEX16(0xABCD, Result);
+  TEST_ASSERT_EQUAL_HEX8(0x34, gDevice->Memory[COMMAND]);
+  TEST_ASSERT_EQUAL_HEX8(0x12, gDevice->Memory[COMMAND + 1]);
+  TEST_ASSERT_EQUAL_UINT8(2, gStarts);
+  TEST_ASSERT_EQUAL_UINT8(1, gStops);
+
+  //the same word with a wrong PEC
+  gDevice->Memory[COMMAND + 4] ^= 0x01;
+  TEST_ASSERT_EQUAL_UINT8(8, I2cSmbus_ProcessCall(I2C_0, DEVICE, COMMAND,
+                                                  0x1234, &Result, 1));
+}
+
+void test_BlockProcessCallReceivesTheBlockAfterTheSentOne(void)
+{
+  uint8_t Data[I2C_SMBUS_BLOCK_MAX];
+  uint8_t Length = 0;
+
+  //the answer follows the 2 bytes of the sent block
+  gDevice->Memory[COMMAND + 3] = 2;
+  gDevice->Memory[COMMAND + 4] = 0x5A;
+  gDevice->Memory[COMMAND + 5] = 0xA5;
+
+  TEST_ASSERT_EQUAL_UINT8(1, I2cSmbus_BlockProcessCall(I2C_0, DEVICE, COMMAND,
+                                                       gBlock, 2, Data,
+                                                       &Length, 0));
+  TEST_ASSERT_EQUAL_UINT8(2, gDevice->Memory[COMMAND]);
+  TEST_ASSERT_EQUAL_HEX8(0x22, gDevice->Memory[COMMAND + 2]);
+  TEST_ASSERT_EQUAL_UINT8(2, Length);
+  TEST_ASSERT_EQUAL_HEX8(0x5A, Data[0]);
+  TEST_ASSERT_EQUAL_HEX8(0xA5, Data[1]);
+}
+
+void test_CountAboveTheBlockMaxIsRejectedAndReleasesTheBus(void)
+{
+  uint8_t Data[I2C_SMBUS_BLOCK_MAX];
+  uint8_t Length = 0;
+
+  gDevice->Memory[COMMAND] = I2C_SMBUS_BLOCK_MAX + 1;
+  TwiSim_SetHook(CountSteps);
+
+  TEST_ASSERT_EQUAL_UINT8(7, I2cSmbus_BlockRead(I2C_0, DEVICE, COMMAND, Data,
+                                                &Length, 1));
+  TEST_ASSERT_EQUAL_UINT8(0, Length);
+  //only the count and one NACKed byte are read
+  TEST_ASSERT_EQUAL_UINT8(COMMAND + 2, gDevice->Pointer);
+  TEST_ASSERT_EQUAL_UINT8(1, gStops);
+
+  //the next transaction runs
+  LoadBlock();
+  TEST_ASSERT_EQUAL_UINT8(1, I2cSmbus_BlockRead(I2C_0, DEVICE, COMMAND, Data,
+                                                &Length, 1));
+  TEST_ASSERT_EQUAL_UINT8(3, Length);
+}
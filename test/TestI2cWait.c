@@ -0,0 +1,96 @@
+#include "unity.h"
+#include "i2c.h"
+#include "i2c_cfg.h"
+#include "twi_sim.h"
+#include "twi_fault.h"
+
+/* built with I2C_WAIT_STRATEGY=I2C_WAIT_SLEEP and I2C_WAIT_STATS=1, see
+ * project.yml */
+#if I2C_WAIT_STRATEGY != I2C_WAIT_SLEEP || I2C_WAIT_STATS != 1
+#error "TestI2cWait needs the sleep strategy and the wait statistics"
+#endif
+
+#define DEVICE 0x50 /* listed in the device table at 400 kHz */
+
+/* the period of the tick which wakes the CPU up besides the I2C interrupt,
+ * longer than a step */
+#define TICK_CYCLES 2000ul
+
+/* a step of a byte at 400 kHz */
+#define BYTE_CYCLES (9 * (I2C_CPU_CLK / 400000ul))
+
+static TwiSimDevice_t* gDevice;
+
+void setUp(void)
+{
+  TwiSim_Init();
+  TwiSim_SetTick(TICK_CYCLES);
+  gDevice = TwiSim_AddDevice(I2C_0, DEVICE);
+  I2c_Init(I2c_GetConfig());
+  I2c_ResetWaitStats(I2C_0);
+}
+
+void tearDown(void)
+{
+}
+
+void test_EveryStepIsOneWakeupByTheInterrupt(void)
+{
+  I2cWaitStats_t Stats;
+  uint32_t Start;
+
+  Start = TwiSim_GetClock();
+  TEST_ASSERT_EQUAL_UINT8(1, I2c_SendByte(I2C_0, DEVICE, 0x10, 0xA5));
+  TEST_ASSERT_EQUAL_HEX8(0xA5, gDevice->Memory[0x10]);
+  I2c_GetWaitStats(I2C_0, &Stats);
+
+  //start, address, register and byte: each step ends before the tick
+  TEST_ASSERT_EQUAL_UINT16(4, Stats.Wakeups);
+  //the CPU sleeps for the steps on the bus less the commands
+  TEST_ASSERT_TRUE(Stats.SleepCycles >= 3 * (BYTE_CYCLES - I2C_STEP_CYCLES));
+  TEST_ASSERT_TRUE(Stats.SleepCycles <= TwiSim_GetBusCycles(I2C_0));
+  //it only spins for the poll before and after every sleep
+  TEST_ASSERT_EQUAL_UINT32(2 * 4 * I2C_POLL_CYCLES, Stats.SpinCycles);
+  //the rest of the call is the commands of the 4 steps and the stop bit
+  TEST_ASSERT_EQUAL_UINT32(TwiSim_GetClock() - Start - 5 * I2C_STEP_CYCLES,
+                           Stats.SleepCycles + Stats.SpinCycles);
+}
+
+void test_TimeoutCountsTheWakeups(void)
+{
+  TwiFault_t Fault = { TWI_FAULT_BUS_LOW, TWI_FAULT_START, 0, 0,
+                       TWI_SIM_NEVER };
+  I2cWaitStats_t Stats;
+  uint32_t Start;
+
+  TwiFault_Arm(I2C_0, &Fault);
+
+  Start = TwiSim_GetClock();
+  TEST_ASSERT_EQUAL_UINT8(2, I2c_SendByte(I2C_0, DEVICE, 0x10, 0xA5));
+  I2c_GetWaitStats(I2C_0, &Stats);
+
+  //nothing but the tick wakes the CPU up, I2C_TIMEOUT times, so the step
+  //is given up after I2C_TIMEOUT ticks instead of I2C_TIMEOUT polls
+  TEST_ASSERT_EQUAL_UINT16(I2C_TIMEOUT, Stats.Wakeups);
+  TEST_ASSERT_TRUE(TwiSim_GetClock() - Start >=
+                   (uint32_t)I2C_TIMEOUT * TICK_CYCLES);
+  TEST_ASSERT_TRUE(TwiSim_GetClock() - Start <=
+                   (uint32_t)I2C_TIMEOUT * (TICK_CYCLES + I2C_POLL_CYCLES) +
+                   2 * I2C_STEP_CYCLES);
+}
+
+void test_ResetClearsTheStatistics(void)
+{
+  I2cWaitStats_t Stats;
+  uint8_t Data;
+
+  I2c_ReceiveByte(I2C_0, DEVICE, 0x10, &Data);
+  I2c_GetWaitStats(I2C_0, &Stats);
+  TEST_ASSERT_EQUAL_UINT16(6, Stats.Wakeups);
+
+  I2c_ResetWaitStats(I2C_0);
+  I2c_GetWaitStats(I2C_0, &Stats);
+  TEST_ASSERT_EQUAL_UINT16(0, Stats.Wakeups);
+  TEST_ASSERT_EQUAL_UINT32(0, Stats.SleepCycles);
+  TEST_ASSERT_EQUAL_UINT32(0, Stats.SpinCycles);
+}
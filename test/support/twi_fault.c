@@ -0,0 +1,171 @@
+/**
+ * @file twi_fault.c
+ * @author Mohamed Hassanin
+ * @brief Inject faults in the steps of the TWI model. The injector is the
+ * hook of the model, so the driver sees the faults through its registers
+ * like on the hardware. The recovery latency is the time from the faulty
+ * step to the moment it's read by TwiFault_GetLatency, i.e. to the success
+ * or the failure reported by the driver.
+ * @version 0.1
+ * @date 2021-05-23
+ */
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <inttypes.h>
+#include "twi_fault.h"
+#include "twi_sim.h"
+#include "i2c_memmap.h"
+/******************************************************************************
+ * module variables definitions
+ ******************************************************************************/
+static TwiFault_t gFault;
+
+static I2c_t gI2c; /**< the bus of the fault */
+
+static uint8_t gSkip; /**< the steps of the phase still to let through */
+
+static uint8_t gAddressNext; /**< 1 if the next byte is an address */
+
+static uint8_t gInjected;
+
+static uint32_t gInjectedAt; /**< the clock of the faulty step */
+/******************************************************************************
+ * functions prototypes
+ ******************************************************************************/
+static void TwiFault_Hook(const I2c_t I2c, TwiSimStep_t* const Step);
+/******************************************************************************
+ * functions definitions
+ ******************************************************************************/
+/******************************************************************************
+* Function : TwiFault_Arm()
+*//**
+* \b Description:
+* Inject a fault in a coming step of a bus. The fault is injected once. <br>
+* PRE-CONDITION: TwiSim_Init is called, it disarms the fault <br>
+* @param I2c the bus
+* @param Fault the fault and the step to inject it in
+* @return void
+ ******************************************************************************/
+extern void
+TwiFault_Arm(const I2c_t I2c, const TwiFault_t* const Fault)
+{
+  gFault = *Fault;
+  gI2c = I2c;
+  gSkip = Fault->Skip;
+  gAddressNext = 0;
+  gInjected = 0;
+  gInjectedAt = 0;
+
+  TwiSim_SetHook(TwiFault_Hook);
+}
+
+/******************************************************************************
+* Function : TwiFault_IsInjected()
+*//**
+* \b Description:
+* Check whether the armed fault is injected. <br>
+* @return uint8_t 1 if it's injected, 0 otherwise.
+ ******************************************************************************/
+extern uint8_t
+TwiFault_IsInjected(void)
+{
+  return gInjected;
+}
+
+/******************************************************************************
+* Function : TwiFault_GetLatency()
+*//**
+* \b Description:
+* Get the time since the faulty step. <br>
+* @return uint32_t the CPU cycles since the fault was injected, 0 if it
+* isn't.
+ ******************************************************************************/
+extern uint32_t
+TwiFault_GetLatency(void)
+{
+  if(gInjected == 0) return 0;
+
+  return TwiSim_GetClock() - gInjectedAt;
+}
+
+/******************************************************************************
+* Function : TwiFault_Hook()
+*//**
+* \b Description:
+* Utility function to find the faulty step and change its outcome. While
+* the bus is held low, no step ends. <br>
+* @param I2c the bus
+* @param Step the step computed by the model
+* @return void
+ ******************************************************************************/
+static void
+TwiFault_Hook(const I2c_t I2c, TwiSimStep_t* const Step)
+{
+  if(I2c != gI2c) return;
+
+  TwiFaultPhase_t Phase;
+
+  if(Step->Command & (1 << TWSTO))
+    {
+      Phase = TWI_FAULT_STOP;
+    }
+  else if(Step->Command & (1 << TWSTA))
+    {
+      Phase = TWI_FAULT_START;
+    }
+  else if(gAddressNext != 0)
+    {
+      Phase = TWI_FAULT_ADDRESS;
+    }
+  else
+    {
+      Phase = TWI_FAULT_DATA;
+    }
+  gAddressNext = Phase == TWI_FAULT_START;
+
+  if(gInjected != 0)
+    {
+      if(gFault.Kind == TWI_FAULT_BUS_LOW &&
+        TwiSim_GetClock() - gInjectedAt < gFault.Cycles)
+        {
+          Step->Cycles = TWI_SIM_NEVER;
+        }
+      return;
+    }
+
+  if(Phase != gFault.Phase) return;
+
+  if(gSkip != 0)
+    {
+      gSkip--;
+      return;
+    }
+
+  gInjected = 1;
+  gInjectedAt = TwiSim_GetClock();
+
+  switch(gFault.Kind)
+  {
+    case TWI_FAULT_NACK:
+      //SLA+W, data and SLA+R ACKs are 8 below their NACKs
+      if(Step->Status == 0x18 || Step->Status == 0x28 || Step->Status == 0x40)
+        {
+          Step->Status += 8;
+        }
+    break;
+
+    case TWI_FAULT_DELAY:
+      Step->Cycles += gFault.Cycles;
+    break;
+
+    case TWI_FAULT_STATUS:
+      Step->Status = gFault.Status;
+    break;
+
+    default:
+      Step->Cycles = TWI_SIM_NEVER;
+    break;
+  }
+}
+/*****************************End of File ************************************/
@@ -0,0 +1,51 @@
+/**
+ * @file twi_fault.h
+ * @author Mohamed Hassanin
+ * @brief Inject faults in the steps of the TWI model and measure how long
+ * the driver takes to recover from them.
+ * @version 0.1
+ * @date 2021-05-23
+ */
+#ifndef TWI_FAULT_H
+#define TWI_FAULT_H
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "i2c_cfg.h"
+/******************************************************************************
+ * Typedefs
+ ******************************************************************************/
+typedef enum
+{
+  TWI_FAULT_NACK, /**< the ACK of the address or of a sent byte is a NACK */
+  TWI_FAULT_DELAY, /**< TWINT is set Cycles later */
+  TWI_FAULT_STATUS, /**< TWSR is Status, e.g. 0x38 for a lost arbitration */
+  TWI_FAULT_BUS_LOW, /**< the bus is held low for Cycles: TWINT isn't set */
+}TwiFaultKind_t;
+
+typedef enum
+{
+  TWI_FAULT_START, /**< a start or a repeated start bit */
+  TWI_FAULT_ADDRESS, /**< the address following a start bit */
+  TWI_FAULT_DATA, /**< a byte sent or received */
+  TWI_FAULT_STOP, /**< a stop bit */
+}TwiFaultPhase_t;
+
+typedef struct
+{
+  TwiFaultKind_t Kind; /**< what goes wrong */
+  TwiFaultPhase_t Phase; /**< the phase of the faulty step */
+  uint8_t Skip; /**< the steps of the phase to let through first */
+  uint8_t Status; /**< the status code of TWI_FAULT_STATUS */
+  uint32_t Cycles; /**< the delay of TWI_FAULT_DELAY, the time the bus is
+                     held by TWI_FAULT_BUS_LOW */
+}TwiFault_t;
+/******************************************************************************
+ * Function prototypes
+ ******************************************************************************/
+extern void TwiFault_Arm(const I2c_t I2c, const TwiFault_t* const Fault);
+extern uint8_t TwiFault_IsInjected(void);
+extern uint32_t TwiFault_GetLatency(void);
+
+#endif
+/*****************************End of File ************************************/
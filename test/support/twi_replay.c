@@ -0,0 +1,365 @@
+/**
+ * @file twi_replay.c
+ * @author Mohamed Hassanin
+ * @brief Replay a log of the bus recorder (i2c_rec) through the driver on
+ * the TWI model. The records are grouped back into programs, split at every
+ * start bit, and run by I2c_Transfer. The hook of the model answers every
+ * step with the recorded status code and byte, at the recorded time, so the
+ * driver sees the bus of the field again: its NACKs, its timeouts and its
+ * timing. A step which the driver runs differently than the log is counted
+ * as a mismatch, e.g. after a change of the driver.
+ * @version 0.1
+ * @date 2021-05-22
+ */
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <inttypes.h>
+#include "twi_replay.h"
+#include "twi_sim.h"
+#include "i2c_rec.h"
+#include "i2c_memmap.h"
+/******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define TWI_REPLAY_OPS_MAX 32 /**< The maximum size of a rebuilt program */
+/******************************************************************************
+ * module variables definitions
+ ******************************************************************************/
+static const uint8_t* gLog;
+
+static uint16_t gCount; /**< the number of the records */
+
+static uint16_t gNext; /**< the next record to answer with */
+
+static uint32_t gDue; /**< the clock at which the last answered record was
+                        recorded */
+
+static uint16_t gMismatches;
+
+static uint8_t gProgram[TWI_REPLAY_OPS_MAX];
+
+static uint8_t gTx[256];
+
+static uint8_t gRx[256];
+/******************************************************************************
+ * functions prototypes
+ ******************************************************************************/
+static uint16_t TwiReplay_GetDelta(const uint16_t Record);
+static uint8_t TwiReplay_IsValid(void);
+static uint16_t TwiReplay_Build(uint16_t Record,
+                                I2c_t* const I2c,
+                                I2cTransfer_t* const Transfer,
+                                uint8_t* const RxCount);
+static void TwiReplay_Hook(const I2c_t I2c, TwiSimStep_t* const Step);
+/******************************************************************************
+ * functions definitions
+ ******************************************************************************/
+/******************************************************************************
+* Function : TwiReplay_Run()
+*//**
+* \b Description:
+* Replay a log through the driver. The model must have no devices on the
+* recorded buses, the hook answers for them. <br>
+* PRE-CONDITION: TwiSim_Init and I2c_Init are called <br>
+* @param Log the records, as read by I2cRec_Read
+* @param Length the size of the log in bytes
+* @param Result a pointer to receive the outcome of the replay in
+* @return void
+ ******************************************************************************/
+extern void
+TwiReplay_Run(const uint8_t* const Log,
+              const uint16_t Length,
+              TwiReplayResult_t* const Result)
+{
+  const uint32_t Start = TwiSim_GetClock();
+  I2cTransfer_t Transfer;
+  I2c_t I2c;
+  uint8_t RxCount;
+  uint16_t Record;
+  uint16_t End;
+  uint8_t i;
+
+  gLog = Log;
+  gCount = Length / I2C_REC_RECORD_SIZE;
+  gNext = 0;
+  gDue = Start;
+  gMismatches = 0;
+
+  Result->Transfers = 0;
+  Result->Failed = 0;
+  Result->LogCycles = 0;
+  Result->RxCount = 0;
+
+  for(Record = 0; Record < gCount; Record++)
+    {
+      Result->LogCycles += TwiReplay_GetDelta(Record);
+    }
+
+  if(TwiReplay_IsValid() == 0)
+    {
+      Result->Mismatches = gCount;
+      Result->Cycles = 0;
+      return;
+    }
+
+  TwiSim_SetHook(TwiReplay_Hook);
+
+  Record = 0;
+  while(Record < gCount)
+    {
+      End = TwiReplay_Build(Record, &I2c, &Transfer, &RxCount);
+
+      Result->Transfers++;
+      if(I2c_Transfer(I2c, &Transfer) != 1)
+        {
+          Result->Failed++;
+        }
+
+      for(i = 0; i < RxCount && Result->RxCount < TWI_REPLAY_RX_MAX; i++)
+        {
+          Result->Rx[Result->RxCount] = gRx[i];
+          Result->RxCount++;
+        }
+
+      //the records the driver didn't ask for are skipped, the ones it asked
+      //for beyond the program are already counted by the hook
+      while(gNext < End)
+        {
+          gDue += TwiReplay_GetDelta(gNext);
+          gNext++;
+          gMismatches++;
+        }
+      Record = gNext;
+    }
+
+  TwiSim_SetHook(0x0);
+
+  Result->Mismatches = gMismatches;
+  Result->Cycles = TwiSim_GetClock() - Start;
+}
+
+/******************************************************************************
+* Function : TwiReplay_GetDelta()
+*//**
+* \b Description:
+* Utility function to get the cycles between a record and the previous
+* one. <br>
+* @param Record the index of the record
+* @return uint16_t the cycles
+ ******************************************************************************/
+static uint16_t
+TwiReplay_GetDelta(const uint16_t Record)
+{
+  const uint8_t* const Bytes = &gLog[Record * I2C_REC_RECORD_SIZE];
+
+  return (uint16_t)(Bytes[3] | Bytes[4] << 8);
+}
+
+/******************************************************************************
+* Function : TwiReplay_IsValid()
+*//**
+* \b Description:
+* Utility function to check the peripherals and the ops of the log. <br>
+* @return uint8_t 1 if the log is valid, 0 otherwise.
+ ******************************************************************************/
+static uint8_t
+TwiReplay_IsValid(void)
+{
+  uint16_t Record;
+  uint8_t Op;
+
+  for(Record = 0; Record < gCount; Record++)
+    {
+      Op = gLog[Record * I2C_REC_RECORD_SIZE] & 0x0F;
+      if(!((gLog[Record * I2C_REC_RECORD_SIZE] >> 4) < I2C_MAX &&
+        Op != I2C_OP_END && Op < I2C_OP_MAX))
+        {
+          return 0;
+        }
+    }
+
+  return 1;
+}
+
+/******************************************************************************
+* Function : TwiReplay_Build()
+*//**
+* \b Description:
+* Utility function to rebuild the program of the records from a start bit
+* up to the next one, or up to a stop bit. <br>
+* @param Record the index of the first record
+* @param I2c a pointer to receive the peripheral of the program in
+* @param Transfer a pointer to receive the program in
+* @param RxCount a pointer to receive the number of the bytes to receive in
+* @return uint16_t the index of the record following the program
+ ******************************************************************************/
+static uint16_t
+TwiReplay_Build(uint16_t Record,
+                I2c_t* const I2c,
+                I2cTransfer_t* const Transfer,
+                uint8_t* const RxCount)
+{
+  const uint8_t* Bytes = &gLog[Record * I2C_REC_RECORD_SIZE];
+  uint8_t HasAddress = 0;
+  uint8_t HasRegister = 0;
+  uint8_t Length = 0;
+  uint8_t TxCount = 0;
+  uint8_t Op;
+
+  *I2c = (I2c_t)(Bytes[0] >> 4);
+  *RxCount = 0;
+  Transfer->Program = gProgram;
+  Transfer->Address = 0;
+  Transfer->Register = 0;
+  Transfer->TxData = gTx;
+  Transfer->RxData = gRx;
+  Transfer->Callback = 0x0;
+  Transfer->Receive = 0x0;
+
+  for(; Record < gCount; Record++)
+    {
+      Bytes = &gLog[Record * I2C_REC_RECORD_SIZE];
+      Op = Bytes[0] & 0x0F;
+      //the byte count of a block is received with ACK like the data
+      if(Op == I2C_OP_RX_BLOCK) Op = I2C_OP_RX_ACK;
+
+      if(Length != 0 &&
+        ((Bytes[0] >> 4) != *I2c || Op == I2C_OP_START ||
+        ((Op == I2C_OP_ADDR_W || Op == I2C_OP_ADDR_R) && HasAddress != 0) ||
+        (Op == I2C_OP_REG && HasRegister != 0) ||
+        Length > TWI_REPLAY_OPS_MAX - 3 || TxCount == 255 || *RxCount == 255))
+        {
+          break;
+        }
+
+      switch(Op)
+      {
+        case I2C_OP_ADDR_W:
+        case I2C_OP_ADDR_R:
+          Transfer->Address = Bytes[2] >> 1;
+          HasAddress = 1;
+          gProgram[Length++] = Op;
+        break;
+
+        case I2C_OP_REG:
+          Transfer->Register = Bytes[2];
+          HasRegister = 1;
+          gProgram[Length++] = Op;
+        break;
+
+        case I2C_OP_TX:
+        case I2C_OP_TX_GC:
+        case I2C_OP_RX_ACK:
+          if(Length < 2 || gProgram[Length - 2] != Op ||
+            gProgram[Length - 1] == 255)
+            {
+              gProgram[Length++] = Op;
+              gProgram[Length++] = 0;
+            }
+          gProgram[Length - 1]++;
+
+          if(Op == I2C_OP_RX_ACK)
+            {
+              (*RxCount)++;
+            }
+          else
+            {
+              gTx[TxCount++] = Bytes[2];
+            }
+        break;
+
+        case I2C_OP_RX_NACK:
+          (*RxCount)++;
+          gProgram[Length++] = Op;
+        break;
+
+        default:
+          gProgram[Length++] = Op;
+        break;
+      }
+
+      if(Op == I2C_OP_STOP)
+        {
+          Record++;
+          break;
+        }
+    }
+
+  gProgram[Length] = I2C_OP_END;
+
+  return Record;
+}
+
+/******************************************************************************
+* Function : TwiReplay_Hook()
+*//**
+* \b Description:
+* Utility function to answer a step of the model with the next record. A
+* stop bit takes no time, its bus time is in the gap of the following start
+* bit. <br>
+* @param I2c the bus
+* @param Step the step computed by the model
+* @return void
+ ******************************************************************************/
+static void
+TwiReplay_Hook(const I2c_t I2c, TwiSimStep_t* const Step)
+{
+  if(gNext >= gCount)
+    {
+      gMismatches++;
+      return;
+    }
+
+  const uint8_t* const Bytes = &gLog[gNext * I2C_REC_RECORD_SIZE];
+  const uint8_t Op = Bytes[0] & 0x0F;
+  uint8_t Match;
+
+  gDue += TwiReplay_GetDelta(gNext);
+  gNext++;
+
+  if(Step->Command & (1 << TWSTO))
+    {
+      Match = Op == I2C_OP_STOP;
+    }
+  else if(Step->Command & (1 << TWSTA))
+    {
+      Match = Op == I2C_OP_START;
+    }
+  else if(Op == I2C_OP_RX_ACK || Op == I2C_OP_RX_NACK || Op == I2C_OP_RX_BLOCK)
+    {
+      Match = ((Step->Command & (1 << TWEA)) != 0) == (Op != I2C_OP_RX_NACK);
+    }
+  else
+    {
+      Match = Op != I2C_OP_START && Op != I2C_OP_STOP && Step->Byte == Bytes[2];
+    }
+
+  if(Match == 0 || (Bytes[0] >> 4) != I2c)
+    {
+      gMismatches++;
+    }
+
+  if(Step->Command & (1 << TWSTO))
+    {
+      Step->Cycles = 0;
+      return;
+    }
+
+  Step->Status = Bytes[1];
+  Step->Data = Bytes[2];
+
+  if(Bytes[1] == I2C_NO_STATUS)
+    {
+      Step->Cycles = TWI_SIM_NEVER;
+    }
+  else if((int32_t)(gDue - TwiSim_GetClock()) > 0)
+    {
+      Step->Cycles = gDue - TwiSim_GetClock();
+    }
+  else
+    {
+      Step->Cycles = 0;
+    }
+}
+/*****************************End of File ************************************/
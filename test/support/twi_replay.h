@@ -0,0 +1,41 @@
+/**
+ * @file twi_replay.h
+ * @author Mohamed Hassanin
+ * @brief Replay a log of the bus recorder (i2c_rec) through the driver on
+ * the TWI model.
+ * @version 0.1
+ * @date 2021-05-22
+ */
+#ifndef TWI_REPLAY_H
+#define TWI_REPLAY_H
+/******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define TWI_REPLAY_RX_MAX 256 /**< The maximum number of received bytes kept */
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "i2c.h"
+/******************************************************************************
+ * Typedefs
+ ******************************************************************************/
+typedef struct
+{
+  uint16_t Transfers; /**< the programs run */
+  uint16_t Failed; /**< the programs which ended with an error */
+  uint16_t Mismatches; /**< the steps the driver ran differently than the
+                         log, and the steps missing from the log */
+  uint32_t LogCycles; /**< the cycles of the log */
+  uint32_t Cycles; /**< the cycles of the replay */
+  uint16_t RxCount; /**< the number of the received bytes */
+  uint8_t Rx[TWI_REPLAY_RX_MAX]; /**< the received bytes, in order */
+}TwiReplayResult_t;
+/******************************************************************************
+ * Function prototypes
+ ******************************************************************************/
+extern void TwiReplay_Run(const uint8_t* const Log,
+                          const uint16_t Length,
+                          TwiReplayResult_t* const Result);
+
+#endif
+/*****************************End of File ************************************/
@@ -0,0 +1,641 @@
+/**
+ * @file twi_sim.c
+ * @author Mohamed Hassanin
+ * @brief A host model of the ATmega32A TWI in master mode. Every command
+ * written to TWCR starts a bus step which finishes after the SCL periods it
+ * takes, in CPU cycles of a simulated clock. The clock runs on the commands
+ * and the polls of the driver, so a step is seen done by the first poll
+ * after it finishes, like on the hardware. A hook can change the outcome of
+ * the steps to replay a recorded bus or inject faults.
+ * @version 0.1
+ * @date 2021-05-18
+ */
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <inttypes.h>
+#include "twi_sim.h"
+#include "i2c_memmap.h"
+/******************************************************************************
+ * Typedefs
+ ******************************************************************************/
+typedef enum
+{
+  TWI_SIM_IDLE, /**< the bus isn't owned */
+  TWI_SIM_ADDRESS, /**< a start bit is sent, the address is next */
+  TWI_SIM_TX, /**< a device is addressed for writing */
+  TWI_SIM_RX, /**< a device is addressed for reading */
+  TWI_SIM_NACKED, /**< nobody acknowledged the address */
+}TwiSimPhase_t;
+
+typedef struct
+{
+  TwiSimPhase_t Phase; /**< the phase of the transaction */
+  TwiSimDevice_t* Device; /**< the addressed device, null for a general call */
+  uint8_t PointerSet; /**< 1 if the register pointer is written */
+  uint8_t Pending; /**< 1 while a step is on the bus */
+  uint32_t Due; /**< the clock at which the step finishes */
+  uint8_t Status; /**< the status code of the step */
+  uint8_t Data; /**< TWDR when the step ends */
+  uint32_t Free; /**< the clock at which the bus is free */
+  uint32_t BusCycles; /**< the cycles the bus was busy */
+  uint8_t AfterByte; /**< 1 if the last step is a byte */
+  TwiSimGaps_t Gaps; /**< the idle times between the bytes */
+}TwiSimBus_t;
+/******************************************************************************
+ * Variables
+ ******************************************************************************/
+TwiSimRegs_t gTwiSim[I2C_MAX];
+
+volatile uint8_t gTwiSimMcucr;
+/******************************************************************************
+ * module variables definitions
+ ******************************************************************************/
+static TwiSimBus_t gBus[I2C_MAX];
+
+static TwiSimDevice_t gDevice[TWI_SIM_DEVICE_MAX];
+
+static uint8_t gDeviceCount;
+
+static uint32_t gClock;
+
+static uint32_t gStepCycles; /**< the CPU cycles charged for every command */
+
+static uint32_t gPollCycles; /**< the CPU cycles charged for every poll */
+
+static uint32_t gFastStepCycles; /**< the same for the fast data path */
+
+static uint32_t gFastPollCycles;
+
+static uint32_t gTickCycles; /**< the period of the wake-ups of a sleep */
+
+static TwiSimHook_t gHook;
+
+static TwiSimIsr_t gIsr; /**< the pending interrupt, see TwiSim_SetInterrupt */
+/******************************************************************************
+ * functions prototypes
+ ******************************************************************************/
+static uint32_t TwiSim_GetPeriod(const I2c_t I2c);
+static TwiSimDevice_t* TwiSim_FindDevice(const I2c_t I2c, const uint8_t Address);
+static uint8_t TwiSim_Address(TwiSimBus_t* const Bus,
+                              const I2c_t I2c,
+                              const uint8_t Byte);
+static void TwiSim_Execute(const I2c_t I2c, const uint32_t Cycles);
+static void TwiSim_Update(const I2c_t I2c, const uint32_t Cycles);
+static void TwiSim_Transmit(TwiSimBus_t* const Bus,
+                            const I2c_t I2c,
+                            const uint8_t Byte);
+/******************************************************************************
+ * functions definitions
+ ******************************************************************************/
+/******************************************************************************
+* Function : TwiSim_Init()
+*//**
+* \b Description:
+* Reset the registers, the buses, the devices and the clock. The CPU cycles
+* of a command and a poll are set to I2C_STEP_CYCLES and I2C_POLL_CYCLES,
+* I2C_FAST_STEP_CYCLES and I2C_FAST_POLL_CYCLES in the fast data path. The
+* period of the ticks which end a sleep is set to I2C_POLL_CYCLES. <br>
+* @return void
+ ******************************************************************************/
+extern void
+TwiSim_Init(void)
+{
+  uint8_t i;
+
+  for(i = 0; i < I2C_MAX; i++)
+    {
+      gTwiSim[i].Twbr = 0;
+      gTwiSim[i].Twsr = 0xF8;
+      gTwiSim[i].Twar = 0xFE;
+      gTwiSim[i].Twdr = 0xFF;
+      gTwiSim[i].Twcr = 0;
+
+      gBus[i].Phase = TWI_SIM_IDLE;
+      gBus[i].Device = 0x0;
+      gBus[i].Pending = 0;
+      gBus[i].Free = 0;
+      gBus[i].BusCycles = 0;
+      gBus[i].AfterByte = 0;
+      gBus[i].Gaps.Count = 0;
+      gBus[i].Gaps.Cycles = 0;
+      gBus[i].Gaps.Max = 0;
+    }
+
+  gTwiSimMcucr = 0;
+  gDeviceCount = 0;
+  gClock = 0;
+  gStepCycles = I2C_STEP_CYCLES;
+  gPollCycles = I2C_POLL_CYCLES;
+  gFastStepCycles = I2C_FAST_STEP_CYCLES;
+  gFastPollCycles = I2C_FAST_POLL_CYCLES;
+  gTickCycles = I2C_POLL_CYCLES;
+  gHook = 0x0;
+  gIsr = 0x0;
+}
+
+/******************************************************************************
+* Function : TwiSim_AddDevice()
+*//**
+* \b Description:
+* Connect a memory device to a bus. Its memory is zeroed. <br>
+* @param I2c the bus of the device
+* @param Address the 7-bit address of the device
+* @return TwiSimDevice_t* the device, null if there's no room.
+ ******************************************************************************/
+extern TwiSimDevice_t*
+TwiSim_AddDevice(const I2c_t I2c, const uint8_t Address)
+{
+  if(!(I2c < I2C_MAX && gDeviceCount < TWI_SIM_DEVICE_MAX)) return 0x0;
+
+  TwiSimDevice_t* const Device = &gDevice[gDeviceCount];
+  uint16_t i;
+
+  Device->I2c = I2c;
+  Device->Address = Address;
+  Device->Pointer = 0;
+  Device->GeneralCall = 0;
+  for(i = 0; i < sizeof(Device->Memory); i++)
+    {
+      Device->Memory[i] = 0;
+    }
+
+  gDeviceCount++;
+
+  return Device;
+}
+
+/******************************************************************************
+* Function : TwiSim_SetCpuCycles()
+*//**
+* \b Description:
+* Set the CPU cycles charged to the clock for every command written to TWCR
+* and every poll of TWINT. <br>
+* @param StepCycles the cycles of a command
+* @param PollCycles the cycles of a poll
+* @return void
+ ******************************************************************************/
+extern void
+TwiSim_SetCpuCycles(const uint32_t StepCycles, const uint32_t PollCycles)
+{
+  gStepCycles = StepCycles;
+  gPollCycles = PollCycles;
+}
+
+/******************************************************************************
+* Function : TwiSim_SetTick()
+*//**
+* \b Description:
+* Set the period of the interrupt (e.g. the scheduler tick) which wakes the
+* CPU up from a sleep besides the TWI interrupt, see TwiSim_Sleep. <br>
+* @param TickCycles the period in CPU cycles
+* @return void
+ ******************************************************************************/
+extern void
+TwiSim_SetTick(const uint32_t TickCycles)
+{
+  gTickCycles = TickCycles;
+}
+
+/******************************************************************************
+* Function : TwiSim_SetInterrupt()
+*//**
+* \b Description:
+* Make an interrupt pending. It's run once at the exit of the next critical
+* section, so it preempts the code right after the section, e.g. a
+* producer of i2c_queue between the reservation and the publication of its
+* slot. It's reset by TwiSim_Init. <br>
+* @param Isr the interrupt service routine, null to cancel it
+* @return void
+ ******************************************************************************/
+extern void
+TwiSim_SetInterrupt(const TwiSimIsr_t Isr)
+{
+  gIsr = Isr;
+}
+
+/******************************************************************************
+* Function : TwiSim_ExitCritical()
+*//**
+* \b Description:
+* Run the pending interrupt, called by I2C_EXIT_CRITICAL. <br>
+* @return void
+ ******************************************************************************/
+extern void
+TwiSim_ExitCritical(void)
+{
+  const TwiSimIsr_t Isr = gIsr;
+
+  if(Isr == 0x0) return;
+
+  gIsr = 0x0;
+  Isr();
+}
+
+/******************************************************************************
+* Function : TwiSim_SetHook()
+*//**
+* \b Description:
+* Set the function called with every step of the buses before it's started.
+* It's reset by TwiSim_Init. <br>
+* @param Hook the function, null to run the model alone
+* @return void
+ ******************************************************************************/
+extern void
+TwiSim_SetHook(const TwiSimHook_t Hook)
+{
+  gHook = Hook;
+}
+
+/******************************************************************************
+* Function : TwiSim_GetClock()
+*//**
+* \b Description:
+* Get the simulated clock. <br>
+* @return uint32_t the CPU cycles since TwiSim_Init
+ ******************************************************************************/
+extern uint32_t
+TwiSim_GetClock(void)
+{
+  return gClock;
+}
+
+/******************************************************************************
+* Function : TwiSim_GetBusCycles()
+*//**
+* \b Description:
+* Get the time a bus was busy. <br>
+* @param I2c the bus
+* @return uint32_t the CPU cycles the bus was busy since TwiSim_Init
+ ******************************************************************************/
+extern uint32_t
+TwiSim_GetBusCycles(const I2c_t I2c)
+{
+  return gBus[I2c].BusCycles;
+}
+
+/******************************************************************************
+* Function : TwiSim_Command()
+*//**
+* \b Description:
+* Start the bus step of the command written to TWCR. Writing TWINT clears
+* the flag, a command without it does nothing. A stop bit doesn't set the
+* flag, the next start bit waits until it's sent. <br>
+* @param I2c the bus
+* @return void
+ ******************************************************************************/
+extern void
+TwiSim_Command(const I2c_t I2c)
+{
+  TwiSim_Execute(I2c, gStepCycles);
+}
+
+/******************************************************************************
+* Function : TwiSim_FastCommand()
+*//**
+* \b Description:
+* The same as TwiSim_Command for a command of the fast data path. <br>
+* @param I2c the bus
+* @return void
+ ******************************************************************************/
+extern void
+TwiSim_FastCommand(const I2c_t I2c)
+{
+  TwiSim_Execute(I2c, gFastStepCycles);
+}
+
+/******************************************************************************
+* Function : TwiSim_Poll()
+*//**
+* \b Description:
+* Advance the clock by one poll and set TWINT if the step is finished. <br>
+* @param I2c the bus
+* @return void
+ ******************************************************************************/
+extern void
+TwiSim_Poll(const I2c_t I2c)
+{
+  TwiSim_Update(I2c, gPollCycles);
+}
+
+/******************************************************************************
+* Function : TwiSim_FastPoll()
+*//**
+* \b Description:
+* The same as TwiSim_Poll for a poll of the fast data path. <br>
+* @param I2c the bus
+* @return void
+ ******************************************************************************/
+extern void
+TwiSim_FastPoll(const I2c_t I2c)
+{
+  TwiSim_Update(I2c, gFastPollCycles);
+}
+
+/******************************************************************************
+* Function : TwiSim_Sleep()
+*//**
+* \b Description:
+* Sleep until a wake-up: the end of the step on the bus (the TWI interrupt)
+* or the next tick of another interrupt, see TwiSim_SetTick. TWINT is set
+* if the step is finished. <br>
+* @param I2c the bus
+* @return void
+ ******************************************************************************/
+extern void
+TwiSim_Sleep(const I2c_t I2c)
+{
+  TwiSimBus_t* const Bus = &gBus[I2c];
+  uint32_t Cycles = gTickCycles;
+
+  if(Bus->Pending != 0 && (int32_t)(Bus->Due - gClock) < (int32_t)Cycles)
+    {
+      Cycles = (int32_t)(Bus->Due - gClock) > 0 ? Bus->Due - gClock : 0;
+    }
+
+  TwiSim_Update(I2c, Cycles);
+}
+
+/******************************************************************************
+* Function : TwiSim_GetGaps()
+*//**
+* \b Description:
+* Get the times SCL was held low by the master between two bytes of a
+* transaction, from the end of a byte to the command of the next one. <br>
+* @param I2c the bus
+* @param Gaps a pointer to receive the times in
+* @return void
+ ******************************************************************************/
+extern void
+TwiSim_GetGaps(const I2c_t I2c, TwiSimGaps_t* const Gaps)
+{
+  *Gaps = gBus[I2c].Gaps;
+}
+
+/******************************************************************************
+* Function : TwiSim_Execute()
+*//**
+* \b Description:
+* Utility function to charge the CPU cycles of a command, then start its
+* bus step, see TwiSim_Command. <br>
+* @param I2c the bus
+* @param Cycles the CPU cycles of the command
+* @return void
+ ******************************************************************************/
+static void
+TwiSim_Execute(const I2c_t I2c, const uint32_t Cycles)
+{
+  TwiSimRegs_t* const Regs = &gTwiSim[I2c];
+  TwiSimBus_t* const Bus = &gBus[I2c];
+  const uint32_t Period = TwiSim_GetPeriod(I2c);
+  TwiSimStep_t Step;
+  uint32_t Start;
+  uint8_t IsByte;
+
+  gClock += Cycles;
+
+  Step.Command = Regs->Twcr;
+  if((Step.Command & (1 << TWEN | 1 << TWINT)) != (1 << TWEN | 1 << TWINT))
+    {
+      return;
+    }
+
+  Regs->Twcr &= ~(1 << TWINT | 1 << TWSTO);
+
+  Step.Byte = Regs->Twdr;
+  Step.Data = Regs->Twdr;
+  Step.Cycles = 9 * Period;
+  IsByte = (Step.Command & (1 << TWSTO | 1 << TWSTA)) == 0 &&
+           Bus->Phase != TWI_SIM_IDLE;
+
+  if(Step.Command & (1 << TWSTO))
+    {
+      //it cuts the step on the bus, if any
+      if(Bus->Pending != 0)
+        {
+          Bus->Pending = 0;
+          Bus->Free = gClock;
+        }
+      Bus->Phase = TWI_SIM_IDLE;
+      Step.Status = 0xF8;
+      Step.Cycles = Period;
+    }
+  else if(Step.Command & (1 << TWSTA))
+    {
+      Step.Status = Bus->Phase == TWI_SIM_IDLE ? 0x08 : 0x10;
+      Bus->Phase = TWI_SIM_ADDRESS;
+      Step.Cycles = Period;
+    }
+  else if(Bus->Phase == TWI_SIM_ADDRESS)
+    {
+      Step.Status = TwiSim_Address(Bus, I2c, Step.Byte);
+    }
+  else if(Bus->Phase == TWI_SIM_TX)
+    {
+      TwiSim_Transmit(Bus, I2c, Step.Byte);
+      Step.Status = 0x28;
+    }
+  else if(Bus->Phase == TWI_SIM_RX)
+    {
+      Step.Data = Bus->Device->Memory[Bus->Device->Pointer];
+      Bus->Device->Pointer++;
+      Step.Status = (Step.Command & (1 << TWEA)) ? 0x50 : 0x58;
+    }
+  else if(Bus->Phase == TWI_SIM_NACKED)
+    {
+      Step.Status = 0x30;
+    }
+  else
+    {
+      //a step without a start bit is a bus error
+      Step.Status = 0x00;
+      Step.Cycles = 0;
+    }
+
+  if(gHook != 0x0)
+    {
+      gHook(I2c, &Step);
+    }
+
+  Start = (int32_t)(Bus->Free - gClock) > 0 ? Bus->Free : gClock;
+
+  //the master holds SCL low from the end of a byte to the next command
+  if(IsByte != 0 && Bus->AfterByte != 0)
+    {
+      Bus->Gaps.Count++;
+      Bus->Gaps.Cycles += Start - Bus->Due;
+      if(Start - Bus->Due > Bus->Gaps.Max)
+        {
+          Bus->Gaps.Max = Start - Bus->Due;
+        }
+    }
+  Bus->AfterByte = IsByte;
+
+  if(Step.Cycles == TWI_SIM_NEVER)
+    {
+      //the bus is stuck, TWINT stays cleared
+      Bus->Pending = 0;
+      Bus->Free = Start;
+      Bus->AfterByte = 0;
+      return;
+    }
+
+  Bus->Free = Start + Step.Cycles;
+  Bus->BusCycles += Step.Cycles;
+
+  //a stop bit doesn't set TWINT
+  if(Step.Command & (1 << TWSTO)) return;
+
+  Bus->Pending = 1;
+  Bus->Due = Bus->Free;
+  Bus->Status = Step.Status;
+  Bus->Data = Step.Data;
+}
+
+/******************************************************************************
+* Function : TwiSim_Update()
+*//**
+* \b Description:
+* Utility function to charge the CPU cycles of a poll, then set TWINT if
+* the step is finished. <br>
+* @param I2c the bus
+* @param Cycles the CPU cycles of the poll
+* @return void
+ ******************************************************************************/
+static void
+TwiSim_Update(const I2c_t I2c, const uint32_t Cycles)
+{
+  TwiSimRegs_t* const Regs = &gTwiSim[I2c];
+  TwiSimBus_t* const Bus = &gBus[I2c];
+
+  gClock += Cycles;
+
+  if(Bus->Pending != 0 && (int32_t)(gClock - Bus->Due) >= 0)
+    {
+      Bus->Pending = 0;
+      Regs->Twsr = (Regs->Twsr & 0x03) | Bus->Status;
+      Regs->Twdr = Bus->Data;
+      Regs->Twcr |= 1 << TWINT;
+    }
+}
+
+/******************************************************************************
+* Function : TwiSim_GetPeriod()
+*//**
+* \b Description:
+* Utility function to compute the SCL period from the registers, as
+* described in the datasheet. <br>
+* @param I2c the bus
+* @return uint32_t the SCL period in CPU cycles
+ ******************************************************************************/
+static uint32_t
+TwiSim_GetPeriod(const I2c_t I2c)
+{
+  const uint32_t Prescaler = 1ul << (2 * (gTwiSim[I2c].Twsr & 0x03));
+
+  return 16 + 2 * (uint32_t)gTwiSim[I2c].Twbr * Prescaler;
+}
+
+/******************************************************************************
+* Function : TwiSim_FindDevice()
+*//**
+* \b Description:
+* Utility function to find a device on a bus. <br>
+* @param I2c the bus
+* @param Address the 7-bit address of the device
+* @return TwiSimDevice_t* the device, null if there's none.
+ ******************************************************************************/
+static TwiSimDevice_t*
+TwiSim_FindDevice(const I2c_t I2c, const uint8_t Address)
+{
+  uint8_t i;
+
+  for(i = 0; i < gDeviceCount; i++)
+    {
+      if(gDevice[i].I2c == I2c && gDevice[i].Address == Address)
+        {
+          return &gDevice[i];
+        }
+    }
+
+  return 0x0;
+}
+
+/******************************************************************************
+* Function : TwiSim_Address()
+*//**
+* \b Description:
+* Utility function to address a device. Every device acknowledges the
+* general call. <br>
+* @param Bus the state of the bus
+* @param I2c the bus
+* @param Byte the address and the direction bit
+* @return uint8_t the status code
+ ******************************************************************************/
+static uint8_t
+TwiSim_Address(TwiSimBus_t* const Bus, const I2c_t I2c, const uint8_t Byte)
+{
+  const uint8_t Address = Byte >> 1;
+  const uint8_t Read = Byte & 1;
+  uint8_t Ack;
+  uint8_t i;
+
+  Bus->Device = TwiSim_FindDevice(I2c, Address);
+  Bus->PointerSet = 0;
+  Ack = Bus->Device != 0x0;
+
+  if(Address == 0 && Read == 0)
+    {
+      for(i = 0; i < gDeviceCount; i++)
+        {
+          Ack |= gDevice[i].I2c == I2c;
+        }
+    }
+
+  if(Ack == 0)
+    {
+      Bus->Phase = TWI_SIM_NACKED;
+      return Read ? 0x48 : 0x20;
+    }
+
+  Bus->Phase = Read ? TWI_SIM_RX : TWI_SIM_TX;
+  return Read ? 0x40 : 0x18;
+}
+
+/******************************************************************************
+* Function : TwiSim_Transmit()
+*//**
+* \b Description:
+* Utility function to give a byte to the addressed devices. <br>
+* @param Bus the state of the bus
+* @param I2c the bus
+* @param Byte the byte
+* @return void
+ ******************************************************************************/
+static void
+TwiSim_Transmit(TwiSimBus_t* const Bus, const I2c_t I2c, const uint8_t Byte)
+{
+  uint8_t i;
+
+  if(Bus->Device == 0x0)
+    {
+      for(i = 0; i < gDeviceCount; i++)
+        {
+          if(gDevice[i].I2c == I2c)
+            {
+              gDevice[i].GeneralCall = Byte;
+            }
+        }
+    }
+  else if(Bus->PointerSet == 0)
+    {
+      Bus->Device->Pointer = Byte;
+      Bus->PointerSet = 1;
+    }
+  else
+    {
+      Bus->Device->Memory[Bus->Device->Pointer] = Byte;
+      Bus->Device->Pointer++;
+    }
+}
+/*****************************End of File ************************************/
@@ -0,0 +1,109 @@
+/**
+ * @file twi_sim.h
+ * @author Mohamed Hassanin
+ * @brief A host model of the ATmega32A TWI in master mode and of memory
+ * devices on its bus. The registers of the driver are mapped on it when
+ * I2C_SIM is defined, see i2c_memmap.h.
+ * @version 0.1
+ * @date 2021-05-18
+ */
+#ifndef TWI_SIM_H
+#define TWI_SIM_H
+/******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define TWI_SIM_DEVICE_MAX 4 /**< The maximum number of devices on all buses */
+
+#define TWI_SIM_NEVER 0xFFFFFFFFul /**< The cycles of a step which never ends */
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "i2c_cfg.h"
+/******************************************************************************
+ * Typedefs
+ ******************************************************************************/
+typedef struct
+{
+  volatile uint8_t Twbr; /**< bit rate register */
+  volatile uint8_t Twsr; /**< status register */
+  volatile uint8_t Twar; /**< slave address register */
+  volatile uint8_t Twdr; /**< data register */
+  volatile uint8_t Twcr; /**< control register */
+}TwiSimRegs_t;
+
+/**
+ * A memory device: the first byte written after its address sets the
+ * register pointer, the following bytes are written from it. Reads start at
+ * the register pointer. The pointer is incremented after every byte.
+ */
+typedef struct
+{
+  I2c_t I2c; /**< the bus of the device */
+  uint8_t Address; /**< the 7-bit address of the device */
+  uint8_t Pointer; /**< the register pointer */
+  uint8_t GeneralCall; /**< the last general call byte received */
+  uint8_t Memory[256]; /**< the registers */
+}TwiSimDevice_t;
+
+/**
+ * A bus step as computed by the model. The hook set by TwiSim_SetHook can
+ * change its outcome before it's started.
+ */
+typedef struct
+{
+  uint8_t Command; /**< the command written to TWCR */
+  uint8_t Byte; /**< TWDR when the command was written */
+  uint8_t Status; /**< the status code of the step */
+  uint8_t Data; /**< TWDR when the step ends */
+  uint32_t Cycles; /**< the bus cycles of the step, TWI_SIM_NEVER if TWINT
+                     is never set */
+}TwiSimStep_t;
+
+/**
+ * The times SCL was held low by the master between two bytes.
+ */
+typedef struct
+{
+  uint32_t Count; /**< the number of gaps */
+  uint32_t Cycles; /**< their total CPU cycles */
+  uint32_t Max; /**< the longest one */
+}TwiSimGaps_t;
+
+typedef void (*TwiSimHook_t)(const I2c_t I2c, TwiSimStep_t* const Step);
+
+typedef void (*TwiSimIsr_t)(void);
+/******************************************************************************
+ * Variables
+ ******************************************************************************/
+extern TwiSimRegs_t gTwiSim[I2C_MAX];
+extern volatile uint8_t gTwiSimMcucr;
+/******************************************************************************
+ * Function prototypes
+ ******************************************************************************/
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+extern void TwiSim_Init(void);
+extern TwiSimDevice_t* TwiSim_AddDevice(const I2c_t I2c, const uint8_t Address);
+extern void TwiSim_SetCpuCycles(const uint32_t StepCycles,
+                                const uint32_t PollCycles);
+extern void TwiSim_SetTick(const uint32_t TickCycles);
+extern void TwiSim_SetInterrupt(const TwiSimIsr_t Isr);
+extern void TwiSim_ExitCritical(void);
+extern void TwiSim_SetHook(const TwiSimHook_t Hook);
+extern uint32_t TwiSim_GetClock(void);
+extern uint32_t TwiSim_GetBusCycles(const I2c_t I2c);
+extern void TwiSim_Command(const I2c_t I2c);
+extern void TwiSim_Poll(const I2c_t I2c);
+extern void TwiSim_FastCommand(const I2c_t I2c);
+extern void TwiSim_FastPoll(const I2c_t I2c);
+extern void TwiSim_Sleep(const I2c_t I2c);
+extern void TwiSim_GetGaps(const I2c_t I2c, TwiSimGaps_t* const Gaps);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
+/*****************************End of File ************************************/